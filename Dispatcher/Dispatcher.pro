@@ -47,6 +47,7 @@ HEADERS += \
 	CDspTaskHelper.h \
 	CDspTaskManager.h \
 	CDspUserHelper.h \
+	CDspUserHelper_p.h \
 	CDspVNCStarter_p.h \
 	CDspVNCStarter.h \
 	CDspVm.h \
@@ -71,6 +72,8 @@ HEADERS += \
 	CDspVmStateMachine.h \
 	CDspVmAutoTaskManagerBase.h \
 	CDspVmStateSender.h \
+	CDspVmStateCoalescer.h \
+	CDspCtStateReactor.h \
 	CDspTestConfig.h \
 	CDspBackupHelper.h \
 	CDspBugPatcherLogic.h \
@@ -79,6 +82,7 @@ HEADERS += \
 	CDspHostSettingsHelper.h \
 	CDspHaClusterHelper.h \
 	CDspVm_p.h \
+	CDspVmUptime.h \
 	CDspVmSnapshotInfrastructure.h \
 	CDspVmBackupInfrastructure_p.h \
 	CDspVmBackupInfrastructure.h \
@@ -91,8 +95,10 @@ HEADERS += \
 	CDspDBusHub.h \
 	CDspVmBrand.h \
 	CDspTaskTrace.h \
+	CDspTaskTrace_p.h \
 	CDspTemplateFacade.h \
 	CDspTemplateScanner.h \
+	CDspExecutor.h \
 	CDspTemplateStorage.h \
 	\
 	EditHelpers/CMultiEditDispatcher.h \
@@ -141,6 +147,7 @@ HEADERS += \
 	Tasks/Task_EditVm.h \
 	Tasks/Task_EditVm_p.h \
 	Tasks/Task_VmDataStatistic.h \
+	Tasks/Task_VmDataStatistic_p.h \
 	Tasks/Task_EventLoopBase.h \
 	Tasks/Task_MigrateVm_p.h \
 	Tasks/Task_MigrateVmSource_p.h \
@@ -149,6 +156,7 @@ HEADERS += \
 	Tasks/Task_ConvertCt.h \
 	Tasks/Task_ChangeSID.h \
 	Tasks/Task_GetBackupTree.h \
+	Tasks/Task_GetBackupTree_p.h \
 	Tasks/Task_RemoveVmBackup.h \
 	Tasks/Task_BackupQObject_p.h \
 	Tasks/Task_BackupHelper_p.h \
@@ -206,6 +214,8 @@ SOURCES += \
 	CDspVmAutoTaskManagerBase.cpp \
 	CDspRegistry.cpp \
 	CDspVmStateSender.cpp \
+	CDspVmStateCoalescer.cpp \
+	CDspCtStateReactor.cpp \
 	CDspTestConfig.cpp \
 	CDspBackupHelper.cpp \
 	CDspBugPatcherLogic.cpp \
@@ -214,6 +224,7 @@ SOURCES += \
 	CDspHostSettingsHelper.cpp \
 	CDspHaClusterHelper.cpp \
 	CDspVm_p.cpp \
+	CDspVmUptime.cpp \
 	CDspVmSnapshotInfrastructure.cpp \
 	CDspVmBackupInfrastructure.cpp \
 	CDspSettingsWrap.cpp \
@@ -226,6 +237,7 @@ SOURCES += \
 	CDspTaskTrace.cpp \
 	CDspTemplateFacade.cpp \
 	CDspTemplateScanner.cpp \
+	CDspExecutor.cpp \
 	CDspTemplateStorage.cpp \
 	\
 	EditHelpers/CMultiEditDispatcher.cpp \
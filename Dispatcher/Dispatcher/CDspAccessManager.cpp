@@ -399,17 +399,17 @@ CDspAccessManager::checkAccess( SmartPtr<CDspClient> pSession, PVE::IDispatcherC
 			}
 		}
 
-		// load VM configuration from file
+		// the security descriptor is kept up to date by config commits,
+		// so the config is not loaded here in most cases
 		//////////////////////////////////////////////////////////////////////////
-		SmartPtr<CVmConfiguration> pVmConfig( new CVmConfiguration() );
-		PRL_RESULT res = CDspService::instance()->getVmConfigManager().loadConfig( pVmConfig,
+		Vm::Config::Security d;
+		PRL_RESULT res = CDspService::instance()->getVmConfigManager().getSecurity( d,
 				pVmDirItem->getVmHome(), pSession);
 
 		if( PRL_FAILED(res) )
 			throw PRL_ERR_PARSE_VM_CONFIG;
-		PRL_ASSERT(pVmConfig);
 
-		if ( pVmConfig->getVmIdentification()->getVmUuid() != pVmDirItem->getVmUuid() )
+		if ( d.getVmUuid() != pVmDirItem->getVmUuid() )
 		{
 			if (pErrorInfo)
 			{
@@ -419,7 +419,7 @@ CDspAccessManager::checkAccess( SmartPtr<CDspClient> pSession, PVE::IDispatcherC
 			throw PRL_ERR_VM_CONFIG_INVALID_VM_UUID;
 		}
 
-		if (CDspDispConfigGuard::getServerUuid() != pVmConfig->getVmIdentification()->getServerUuid())
+		if (CDspDispConfigGuard::getServerUuid() != d.getServerUuid())
 		{
 			switch (cmd)
 			{
@@ -431,7 +431,7 @@ CDspAccessManager::checkAccess( SmartPtr<CDspClient> pSession, PVE::IDispatcherC
 			case PVE::DspCmdDirVmClone:
 			case PVE::DspCmdDirVmDelete:
 				/* allow Clone & Reg & Delete for multiple registered templates */
-				if (pVmConfig->getVmSettings()->getVmCommonOptions()->isTemplate())
+				if (d.isTemplate())
 					break;
 			default:
 				if (NULL != pErrorInfo)
@@ -246,6 +246,11 @@ bool CDspClient::getClientEnvinromentVariable( const QString& envVarName, QStrin
 	return true;
 }
 
+bool CDspClient::isVmEventsBatchEnabled() const
+{
+	QString v;
+	return getClientEnvinromentVariable("PRL_VM_EVENTS_BATCH", v) && v == "1";
+}
 
 IOSendJob::Handle CDspClient::sendPackage(const SmartPtr<IOPackage> &p) const
 {
@@ -140,6 +140,11 @@ public:
 	// returns true and "value" when variable was found.
 	bool getClientEnvinromentVariable(  const QString& envVarName, QString& value ) const;
 
+	// returns true when the client asked to receive VM state events
+	// coalesced: only the last event of every type per VM within a short
+	// window is sent, each one in its usual separate package
+	bool isVmEventsBatchEnabled() const;
+
 	/** Returns client flags */
 	quint32 getFlags () const { return m_nFlags; }
 
@@ -51,10 +51,33 @@
 #include <prlxmlmodel/HostHardwareInfo/CHostHardwareInfo.h>
 #include <prlxmlmodel/VmConfig/CVmConfiguration.h>
 #include "CDspVzHelper.h"
+#include "CDspExecutor.h"
 #include "CVmValidateConfig.h"
+#include "CDspUserHelper_p.h"
+#include <boost/bind.hpp>
 
 using namespace Virtuozzo;
 
+namespace
+{
+Login::Memo<QString> g_home;
+Login::Keys g_keys;
+
+QString getHome(const QString& user_)
+{
+	boost::optional<QString> x = g_home.find(user_);
+	if (x)
+		return x.get();
+
+	QString output = CAuthHelper(user_).getHomePath();
+	if (!output.isEmpty())
+		g_home.add(user_, output);
+
+	return output;
+}
+
+} // namespace
+
 /*****************************************************************************/
 
 CDspClientManager::CDspClientManager(CDspService& service_, const Backup::Task::Launcher& backup_):
@@ -240,9 +263,9 @@ void CDspClientManager::handleToDispatcherPackage (
 	BOOST_SCOPE_EXIT(&p)
 	{
 		IOPackage::PODData& d = IODATAMEMBER(p.getImpl())[0];
+		// the login command is wiped by the executor when it is done
 		switch (p->header.type)
 		{
-		case PVE::DspCmdUserLogin:
 		case PVE::DspCmdUserEasyLoginLocal:
 			bzero(p->buffers[0].getImpl(), d.bufferSize);
 		}
@@ -257,10 +280,12 @@ void CDspClientManager::handleToDispatcherPackage (
 	{
 		case PVE::DspCmdUserLogin:
 		{
-			if (CProtoSerializer::ParseCommand(p)->GetCommandFlags() & PLLF_LOGIN_WITH_RSA_KEYS)
-				processPubKeyAuthorizeCmd(h, p);
-			else
-				processAuthorizeCmd(h, p);
+			// a stopped executor refuses the job, reject and wipe it here
+			if (m_service->isServerStopping())
+				return authorize_(h, p);
+
+			Executor::get(Executor::LOGIN).run(boost::bind(&CDspClientManager::authorize_,
+				this, h, p));
 			return;
 		}
 		break;
@@ -797,6 +822,33 @@ PRL_RESULT CDspClientManager::preAuthChecks(const IOSender::Handle& h)
 	return PRL_ERR_SUCCESS;
 }
 
+bool CDspClientManager::isConnected_(const IOSender::Handle& h)
+{
+	// a disconnect is handled under the write lock, thus a session that is
+	// checked and added under that lock is never left behind
+	return m_service->getIOServer().clientState(h) == IOSender::Connected;
+}
+
+void CDspClientManager::authorize_(IOSender::Handle h, SmartPtr<IOPackage> p)
+{
+	BOOST_SCOPE_EXIT(&p)
+	{
+		IOPackage::PODData& d = IODATAMEMBER(p.getImpl())[0];
+		bzero(p->buffers[0].getImpl(), d.bufferSize);
+	}
+	BOOST_SCOPE_EXIT_END;
+	// the logons left in the queue at shutdown are rejected at once
+	if (m_service->isServerStopping())
+	{
+		WRITE_TRACE(DBG_FATAL, "Dispatcher shutdown is in progress, logon is rejected");
+		return (void)m_service->sendSimpleResponseToClient(h, p, PRL_ERR_DISP_SHUTDOWN_IN_PROCESS);
+	}
+	if (CProtoSerializer::ParseCommand(p)->GetCommandFlags() & PLLF_LOGIN_WITH_RSA_KEYS)
+		processPubKeyAuthorizeCmd(h, p);
+	else
+		processAuthorizeCmd(h, p);
+}
+
 void CDspClientManager::processAuthorizeCmd(
 	const IOSender::Handle& h,
 	const SmartPtr<IOPackage>& p)
@@ -839,6 +891,12 @@ void CDspClientManager::processAuthorizeCmd(
 	if (pClient.isValid())
 	{
 		m_rwLock.lockForWrite();
+		if (!isConnected_(h))
+		{
+			m_rwLock.unlock();
+			WRITE_TRACE(DBG_FATAL, "Session with uuid[ %s ] was closed during logon", QSTR2UTF8(h));
+			return;
+		}
 		if (m_clients.isEmpty()
 			/* Check to prevent lock HwInfo mutex before dispatcher init completed */
 			&& m_service->isFirstInitPhaseCompleted()
@@ -859,7 +917,8 @@ void CDspClientManager::processAuthorizeCmd(
 	} else if (bWasPreAuthorized)
 	{
 		m_rwLock.lockForWrite();
-		m_preAuthorizedSessions.insert(h);
+		if (isConnected_(h))
+			m_preAuthorizedSessions.insert(h);
 		m_rwLock.unlock();
 		m_service->sendSimpleResponseToClient(h, p, PRL_ERR_SUCCESS);
 	} else
@@ -913,14 +972,19 @@ void CDspClientManager::processPubKeyAuthorizeCmd
 	}
 
 	QString username = pAuthorizeCommand->GetUserLoginName();
-	CRsaHelper rsa(CAuthHelper(username).getHomePath());
+	QString home = getHome(username);
+	CRsaHelper rsa(home);
 
 	// Check public key is authorized
 	QString public_key = m_service->getUserHelper().decodePassword(pAuthorizeCommand->GetPassword(), h);
-	if (!rsa.isAuthorized(public_key))
+	if (!g_keys.isAuthorized(home, public_key))
 	{
-		m_service->sendSimpleResponseToClient(h, p, PRL_ERR_PUBLIC_KEY_NOT_AUTHORIZED);
-		return;
+		if (!rsa.isAuthorized(public_key))
+		{
+			m_service->sendSimpleResponseToClient(h, p, PRL_ERR_PUBLIC_KEY_NOT_AUTHORIZED);
+			return;
+		}
+		g_keys.authorize(home, public_key);
 	}
 
 	{
@@ -932,6 +996,12 @@ void CDspClientManager::processPubKeyAuthorizeCmd
 			return;
 		}
 		m_rwLock.lockForWrite();
+		if (!isConnected_(h))
+		{
+			m_rwLock.unlock();
+			WRITE_TRACE(DBG_FATAL, "Session with uuid[ %s ] was closed during logon", QSTR2UTF8(h));
+			return;
+		}
 		if (m_clients.isEmpty()
 			/* Check to prevent lock HwInfo mutex before dispatcher init completed */
 			&& m_service->isFirstInitPhaseCompleted()
@@ -230,6 +230,19 @@ private:
 	PRL_RESULT preAuthChecks(
 		const IOSender::Handle& h
 	);
+	/**
+	 * Runs an authorization command on the login executor. PAM and the
+	 * user lookups may take a while, so the receiving thread is not held
+	 * @param handle to dispatcher connection
+	 * @param pointer to authorization package object, wiped at the end
+	 */
+	void authorize_(IOSender::Handle h, SmartPtr<IOPackage> p);
+	/**
+	 * Checks that the connection is still there, the login executor may
+	 * complete a logon after the client has gone
+	 * @param handle to dispatcher connection
+	 */
+	bool isConnected_(const IOSender::Handle& h);
 	/**
 	 * Processes dispatcher auth via password or challenge
 	 * @param handle to dispatcher connection
@@ -0,0 +1,171 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspCtStateReactor.cpp
+///
+/// Container state transitions applied on a pool, serialised per container.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <QThread>
+#include <prlcommon/Logging/Logging.h>
+#include <prlcommon/PrlCommonUtilsBase/PrlStringifyConsts.h>
+#include "CDspCtStateReactor.h"
+
+namespace Ct
+{
+namespace State
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Shell
+
+void Shell::run()
+{
+	forever
+	{
+		QMutexLocker g(&m_entry->m_guard);
+		if (m_entry->m_queue.isEmpty())
+			return;
+
+		VIRTUAL_MACHINE_STATE s = m_entry->m_queue.head();
+		if (s != VMS_UNKNOWN)
+			m_entry->m_last = s;
+		g.unlock();
+
+		m_apply(m_uuid, s);
+
+		g.relock();
+		(void)m_entry->m_queue.dequeue();
+		if (!m_entry->m_queue.isEmpty())
+			continue;
+
+		bool r = m_entry->m_retiring;
+		g.unlock();
+		if (r)
+			m_reactor->retire(m_uuid, m_entry);
+
+		return;
+	}
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Reactor
+
+Reactor::Reactor(const apply_type& apply_): m_apply(apply_)
+{
+	m_pool.setMaxThreadCount(qBound(2, QThread::idealThreadCount(), 8));
+}
+
+Reactor::~Reactor()
+{
+	m_pool.waitForDone();
+}
+
+void Reactor::react(const QString& uuid_, VIRTUAL_MACHINE_STATE state_)
+{
+	// NB. the entry is locked under the reactor lock, so that it cannot
+	// retire in between
+	QMutexLocker l(&m_guard);
+	QSharedPointer<Entry>& e = m_entries[uuid_];
+	if (e.isNull())
+		e = QSharedPointer<Entry>(new Entry());
+
+	QSharedPointer<Entry> x = e;
+	QMutexLocker g(&x->m_guard);
+	l.unlock();
+	VIRTUAL_MACHINE_STATE t = x->m_last;
+	if (x->m_retiring)
+	{
+		// a new life of the container starts from scratch, the one
+		// of the previous life being applied is kept serialised with it
+		x->m_retiring = false;
+		t = x->m_last = VMS_UNKNOWN;
+	}
+	else
+	{
+		foreach (VIRTUAL_MACHINE_STATE s, x->m_queue)
+		{
+			if (s != VMS_UNKNOWN)
+				t = s;
+		}
+	}
+	if (state_ != VMS_UNKNOWN && state_ == t)
+	{
+		WRITE_TRACE(DBG_DEBUG, "duplicate status %s is detected for the Container %s. ignore",
+			PRL_VM_STATE_TO_STRING(state_), QSTR2UTF8(uuid_));
+		return;
+	}
+	// the head of the queue may be applied right now, only the tail is pending
+	if (state_ == VMS_UNKNOWN && x->m_queue.size() > 1 && x->m_queue.last() == VMS_UNKNOWN)
+	{
+		WRITE_TRACE(DBG_DEBUG, "network reconfiguration is already queued for the Container %s. coalesce",
+			QSTR2UTF8(uuid_));
+		return;
+	}
+	bool y = x->m_queue.isEmpty();
+	x->m_queue.enqueue(state_);
+	if (!y)
+		return;
+
+	QRunnable* q = new Shell(uuid_, x, m_apply, *this);
+	q->setAutoDelete(true);
+	m_pool.start(q);
+}
+
+void Reactor::forget(const QString& uuid_)
+{
+	QMutexLocker g(&m_guard);
+	QHash<QString, QSharedPointer<Entry> >::iterator p = m_entries.find(uuid_);
+	if (m_entries.end() == p)
+		return;
+
+	QSharedPointer<Entry> x = p.value();
+	QMutexLocker l(&x->m_guard);
+	if (x->m_queue.isEmpty())
+	{
+		m_entries.erase(p);
+		return;
+	}
+	// the head is being applied right now, drop the rest and let the
+	// shell retire the entry
+	while (x->m_queue.size() > 1)
+		x->m_queue.removeLast();
+
+	x->m_retiring = true;
+}
+
+void Reactor::retire(const QString& uuid_, const QSharedPointer<Entry>& entry_)
+{
+	QMutexLocker g(&m_guard);
+	QHash<QString, QSharedPointer<Entry> >::iterator p = m_entries.find(uuid_);
+	if (m_entries.end() == p || p.value() != entry_)
+		return;
+
+	QMutexLocker l(&entry_->m_guard);
+	// reborn or busy again
+	if (entry_->m_retiring && entry_->m_queue.isEmpty())
+		m_entries.erase(p);
+}
+
+} // namespace State
+} // namespace Ct
@@ -0,0 +1,113 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspCtStateReactor.h
+///
+/// Container state transitions applied on a pool, serialised per container.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDSPCTSTATEREACTOR_H__
+#define __CDSPCTSTATEREACTOR_H__
+
+#include <QHash>
+#include <QQueue>
+#include <QMutex>
+#include <QString>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSharedPointer>
+#include <boost/function.hpp>
+#include <prlsdk/PrlEnums.h>
+
+namespace Ct
+{
+namespace State
+{
+typedef boost::function<void (const QString&, VIRTUAL_MACHINE_STATE)> apply_type;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Entry
+// Per container queue of state transitions. VMS_UNKNOWN stands for
+// network reconfiguration. A forgotten entry retires when its last
+// transition is applied.
+
+struct Entry
+{
+	Entry(): m_last(VMS_UNKNOWN), m_retiring(false)
+	{
+	}
+
+	QMutex m_guard;
+	QQueue<VIRTUAL_MACHINE_STATE> m_queue;
+	VIRTUAL_MACHINE_STATE m_last;
+	bool m_retiring;
+};
+
+struct Reactor;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Shell
+
+struct Shell: QRunnable
+{
+	Shell(const QString& uuid_, const QSharedPointer<Entry>& entry_,
+		const apply_type& apply_, Reactor& reactor_):
+		m_uuid(uuid_), m_entry(entry_), m_apply(apply_), m_reactor(&reactor_)
+	{
+	}
+
+	void run();
+
+private:
+	QString m_uuid;
+	QSharedPointer<Entry> m_entry;
+	apply_type m_apply;
+	Reactor* m_reactor;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Reactor
+// Applies container state transitions on a small pool, serialised per
+// container, instead of a task thread per event.
+
+struct Reactor
+{
+	explicit Reactor(const apply_type& apply_);
+	~Reactor();
+
+	void react(const QString& uuid_, VIRTUAL_MACHINE_STATE state_);
+	void forget(const QString& uuid_);
+	void retire(const QString& uuid_, const QSharedPointer<Entry>& entry_);
+
+private:
+	apply_type m_apply;
+	QMutex m_guard;
+	QHash<QString, QSharedPointer<Entry> > m_entries;
+	QThreadPool m_pool;
+};
+
+} // namespace State
+} // namespace Ct
+
+#endif // __CDSPCTSTATEREACTOR_H__
@@ -0,0 +1,170 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspExecutor.cpp
+///
+/// Dedicated thread pools of the dispatcher subsystems
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "CDspExecutor.h"
+#include <QThread>
+#include <prlcommon/Logging/Logging.h>
+
+namespace Executor
+{
+namespace
+{
+enum
+{
+	// the queue depth worth a notice in the log
+	QUEUE_ALARM = 32
+};
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Gauge
+
+void Gauge::enqueue()
+{
+	int q = m_queued.fetchAndAddOrdered(1) + 1;
+	int p = m_peak.fetchAndAddOrdered(0);
+	while (q > p && !m_peak.testAndSetOrdered(p, q))
+		p = m_peak.fetchAndAddOrdered(0);
+}
+
+void Gauge::begin()
+{
+	m_queued.deref();
+	m_active.ref();
+}
+
+void Gauge::end()
+{
+	m_active.deref();
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Pool::Envelope
+
+struct Pool::Envelope: QRunnable
+{
+	Envelope(QRunnable* load_, Gauge& gauge_): m_load(load_), m_gauge(&gauge_)
+	{
+	}
+	~Envelope()
+	{
+		if (m_load->autoDelete())
+			delete m_load;
+	}
+
+	void run()
+	{
+		m_gauge->begin();
+		m_load->run();
+		m_gauge->end();
+	}
+
+private:
+	QRunnable* m_load;
+	Gauge* m_gauge;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Pool
+
+Pool::Pool(const QString& name_, int limit_): m_name(name_), m_stopped(0)
+{
+	m_pool.setObjectName(name_);
+	m_pool.setMaxThreadCount(limit_);
+}
+
+void Pool::start(QRunnable* job_)
+{
+	if (isStopped())
+	{
+		if (job_->autoDelete())
+			delete job_;
+
+		return;
+	}
+	m_gauge.enqueue();
+	int q = m_gauge.getQueued();
+	if (q > QUEUE_ALARM)
+	{
+		WRITE_TRACE_RL(60, DBG_WARNING, "%s executor: %d jobs queued, %d active",
+			qPrintable(m_name), q, m_gauge.getActive());
+	}
+	Envelope* e = new Envelope(job_, m_gauge);
+	e->setAutoDelete(true);
+	m_pool.start(e);
+}
+
+void Pool::stop()
+{
+	m_stopped.storeRelease(1);
+	// the queued jobs are not dropped for their clients to get responses
+	m_pool.waitForDone();
+	WRITE_TRACE(DBG_INFO, "%s executor stopped, peak queue depth %d",
+		qPrintable(m_name), m_gauge.getPeak());
+}
+
+bool Pool::isStopped() const
+{
+	if (0 == m_stopped.loadAcquire())
+		return false;
+
+	WRITE_TRACE_RL(60, DBG_WARNING, "%s executor is stopped, a job is refused",
+		qPrintable(m_name));
+	return true;
+}
+
+Pool& get(Kind kind_)
+{
+	int c = QThread::idealThreadCount();
+	// lifecycle jobs sleep most of the time waiting for a guest, thus
+	// their limit is high. the others are busy with real work
+	static Pool s_pool[KIND_MAX] =
+	{
+		{"lifecycle", 256},
+		{"statistics", qBound(2, c, 8)},
+		{"template", 2},
+		{"guest", qBound(2, c, 8)},
+		// debug commands (dbgdump) are issued by hand one at a time,
+		// the second thread keeps a slow dump from holding the next one
+		{"internal", 2},
+		{"login", qBound(2, c, 8)},
+		// file copies are bound by the disks, not by the CPUs
+		{"copy", 8}
+	};
+	return s_pool[qBound<int>(0, kind_, KIND_MAX - 1)];
+}
+
+void shutdown()
+{
+	for (int i = 0; i < KIND_MAX; ++i)
+		get(static_cast<Kind>(i)).stop();
+}
+
+} // namespace Executor
@@ -0,0 +1,204 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspExecutor.h
+///
+/// Dedicated thread pools of the dispatcher subsystems
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDSPEXECUTOR_H__
+#define __CDSPEXECUTOR_H__
+
+#include <utility>
+#include <QAtomicInt>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+
+namespace Executor
+{
+///////////////////////////////////////////////////////////////////////////////
+// enum Kind
+// Every subsystem gets its own pool so that long waits of one of them do not
+// starve the others, i.e. graceful shutdowns of many VMs must not stop the
+// statistics.
+
+enum Kind
+{
+	LIFECYCLE,
+	STATISTICS,
+	TEMPLATE,
+	GUEST,
+	INTERNAL,
+	LOGIN,
+	COPY,
+	KIND_MAX
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Gauge
+
+struct Gauge
+{
+	Gauge(): m_queued(0), m_active(0), m_peak(0)
+	{
+	}
+
+	void enqueue();
+	void begin();
+	void end();
+
+	int getQueued() const
+	{
+		return m_queued.fetchAndAddOrdered(0);
+	}
+	int getActive() const
+	{
+		return m_active.fetchAndAddOrdered(0);
+	}
+	int getPeak() const
+	{
+		return m_peak.fetchAndAddOrdered(0);
+	}
+
+private:
+	mutable QAtomicInt m_queued;
+	mutable QAtomicInt m_active;
+	mutable QAtomicInt m_peak;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Job
+
+template<class T>
+struct Job
+{
+	typedef decltype(std::declval<T&>()()) result_type;
+
+	Job(const T& load_, Gauge& gauge_): m_load(load_), m_gauge(&gauge_)
+	{
+	}
+
+	result_type operator()()
+	{
+		Token t(*m_gauge);
+		return m_load();
+	}
+
+private:
+	struct Token
+	{
+		explicit Token(Gauge& gauge_): m_gauge(&gauge_)
+		{
+			m_gauge->begin();
+		}
+		~Token()
+		{
+			m_gauge->end();
+		}
+
+	private:
+		Gauge* m_gauge;
+	};
+
+	T m_load;
+	Gauge* m_gauge;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Refusal
+// A finished future with a default result for a job that a stopped pool does
+// not take.
+
+template<class T>
+struct Refusal
+{
+	static QFuture<T> make()
+	{
+		QFutureInterface<T> x;
+		x.reportStarted();
+		x.reportResult(T());
+		x.reportFinished();
+		return x.future();
+	}
+};
+
+template<>
+struct Refusal<void>
+{
+	static QFuture<void> make()
+	{
+		QFutureInterface<void> x;
+		x.reportStarted();
+		x.reportFinished();
+		return x.future();
+	}
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Pool
+
+struct Pool
+{
+	Pool(const QString& name_, int limit_);
+
+	const QString& getName() const
+	{
+		return m_name;
+	}
+	const Gauge& getGauge() const
+	{
+		return m_gauge;
+	}
+	void start(QRunnable* job_);
+	template<class T>
+	QFuture<typename Job<T>::result_type> run(const T& load_)
+	{
+		if (isStopped())
+			return Refusal<typename Job<T>::result_type>::make();
+
+		m_gauge.enqueue();
+		return QtConcurrent::run(&m_pool, Job<T>(load_, m_gauge));
+	}
+	void stop();
+
+private:
+	struct Envelope;
+
+	bool isStopped() const;
+
+	QString m_name;
+	QAtomicInt m_stopped;
+	Gauge m_gauge;
+	QThreadPool m_pool;
+};
+
+Pool& get(Kind kind_);
+
+// refuses new jobs and waits for all the pools to finish the queued and the
+// running ones
+void shutdown();
+
+} // namespace Executor
+
+#endif // __CDSPEXECUTOR_H__
@@ -1558,13 +1558,14 @@ void Domain::updateConfig(Registry::Access& access_)
 	if (m_agent.getConfig(c).isFailed())
 		return;
 
+	QString a = c.getVmSettings()->getVmStartupOptions()->getOnRebootAction();
 	CVmConfiguration runtime;
 	if ((m_state.getValue() == VMS_RUNNING || m_state.getValue() == VMS_PAUSED)
 		&& m_agent.getConfig(runtime, true).isSucceed())
 		Vm::Config::Repairer<Vm::Config::revise_types>::type::do_(c, runtime);
 
 	m_agent.completeConfig(c);
-	access_.updateConfig(c);
+	access_.updateConfig(c, a);
 	CDspLockedPointer<CDspVmStateSender> x(CDspService::instance()->getVmStateSender());
 	if (x.isValid())
 		x->onVmConfigChanged(QString(), access_.getUuid());
@@ -1631,6 +1632,17 @@ void Domain::switch_(Registry::Access& access_)
 	m_agent.getMaintenance().emitRestored();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Refresh
+
+void Refresh::operator()(Registry::Access& access_)
+{
+	// NB. drop the mark before the conversion so that the event that
+	// comes during it schedules one more refresh.
+	m_pending->fetchAndStoreOrdered(0);
+	m_domain.updateConfig(access_);
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Network
 
@@ -1791,8 +1803,19 @@ namespace Model
 // struct Entry
 
 Entry::Entry(const Registry::Access& access_, Workbench& bench_):
-	Reaction::Demonstrator(access_, bench_), m_last(VMS_UNKNOWN)
+	Reaction::Demonstrator(access_, bench_), m_last(VMS_UNKNOWN),
+	m_refresh(new QAtomicInt(0))
+{
+}
+
+void Entry::refresh(const Callback::Reactor::Domain& domain_)
 {
+	if (!m_refresh->testAndSetOrdered(0, 1))
+	{
+		WRITE_TRACE(DBG_DEBUG, "config refresh is already queued for the VM. coalesce");
+		return;
+	}
+	show(Callback::Reactor::Refresh(domain_, m_refresh));
 }
 
 void Entry::setState(VIRTUAL_MACHINE_STATE value_)
@@ -1974,7 +1997,7 @@ void Coarse::pullInfo(virDomainPtr domain_)
 	Callback::Reactor::Domain r(a);
 	QSharedPointer<System::entry_type> d = m_fine->find(u);
 	if (!d.isNull())
-		d->show(boost::bind(&Callback::Reactor::Domain::updateConfig, r, _1));
+		d->refresh(r);
 	else
 	{
 		if ((d = m_fine->add(u)).isNull())
@@ -2215,6 +2238,43 @@ void Broker::despatch()
 	}
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Metrics
+
+void Metrics::account(unsigned groups_, quint64 duration_)
+{
+	for (unsigned g = 1; g <= groups_; g <<= 1)
+	{
+		if (0 == (g & groups_))
+			continue;
+
+		QString n = QString("libvirt.stats.%1.").arg(getName(g));
+		Stat::Counters::add(n + "calls", 1);
+		Stat::Counters::add(n + "total", duration_);
+		Stat::Counters::set(n + "last", duration_);
+		Stat::Counters::raise(n + "peak", duration_);
+	}
+}
+
+QString Metrics::getName(unsigned group_)
+{
+	switch (group_)
+	{
+	case Stat::Demand::CPU:
+		return "cpu";
+	case Stat::Demand::BALLOON:
+		return "balloon";
+	case Stat::Demand::VCPU:
+		return "vcpu";
+	case Stat::Demand::INTERFACE:
+		return "net";
+	case Stat::Demand::BLOCK:
+		return "block";
+	default:
+		return QString::number(group_);
+	}
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Miner
 
@@ -2224,7 +2284,42 @@ PRL_RESULT Miner::operator()()
 	if (x.isNull())
 		return PRL_ERR_UNINITIALIZED;
 
-	Broker* b = new Broker(m_agent.getPerformance(), x);
+	// one call per distinct set of groups
+	unsigned d = getDue();
+	QSet<QString> b;
+	QHash<unsigned, QStringList> q;
+	Stat::Demand::map_type m = Stat::Demand::getValue();
+	for (Stat::Demand::map_type::const_iterator p = m.constBegin(); p != m.constEnd(); ++p)
+	{
+		unsigned g = p.value() & d;
+		if (p.value() & Stat::Demand::BLOCK)
+		{
+			// a new reader has nothing but old sizes, do not make it
+			// wait for the next block round
+			if (!m_block.contains(p.key()))
+				g |= Stat::Demand::BLOCK;
+
+			b << p.key();
+		}
+		if (0 != g)
+			q[g] << p.key();
+	}
+	m_block = b;
+	if (q.isEmpty())
+		return PRL_ERR_SUCCESS;
+
+	Broker::list_type u;
+	for (QHash<unsigned, QStringList>::const_iterator p = q.constBegin(); p != q.constEnd(); ++p)
+	{
+		quint64 t = PrlGetTimeMonotonic();
+		u << m_agent.getPerformance(convert(p.key()), p.value());
+		t = PrlGetTimeMonotonic() - t;
+		Metrics::account(p.key(), t);
+		WRITE_TRACE(DBG_DEBUG, "sampled stat groups %#x of %d domains in %llu usec",
+			p.key(), p.value().size(), t);
+	}
+
+	Broker* b = new Broker(u, x);
 	QTimer* t = new QTimer();
 	t->setSingleShot(true);
 	b->setParent(t);
@@ -2238,7 +2333,37 @@ PRL_RESULT Miner::operator()()
 
 Miner* Miner::clone() const
 {
-	return new Miner(m_agent, m_view);
+	Miner* output = new Miner(m_agent, m_view);
+	output->m_tick = m_tick;
+	output->m_block = m_block;
+	return output;
+}
+
+unsigned Miner::getDue()
+{
+	unsigned output = Stat::Demand::ALL & ~Stat::Demand::BLOCK;
+	// block stats are expensive on VMs with many disks
+	if (0 == m_tick++ % (BLOCK_STATS_TIMEOUT / PERFORMANCE_TIMEOUT))
+		output |= Stat::Demand::BLOCK;
+
+	return output;
+}
+
+unsigned Miner::convert(unsigned groups_)
+{
+	unsigned output = 0;
+	if (groups_ & Stat::Demand::CPU)
+		output |= VIR_DOMAIN_STATS_CPU_TOTAL;
+	if (groups_ & Stat::Demand::BALLOON)
+		output |= VIR_DOMAIN_STATS_BALLOON;
+	if (groups_ & Stat::Demand::VCPU)
+		output |= VIR_DOMAIN_STATS_VCPU;
+	if (groups_ & Stat::Demand::INTERFACE)
+		output |= VIR_DOMAIN_STATS_INTERFACE;
+	if (groups_ & Stat::Demand::BLOCK)
+		output |= VIR_DOMAIN_STATS_BLOCK;
+
+	return output;
 }
 
 void Miner::timerEvent(QTimerEvent* event_)
@@ -34,6 +34,7 @@
 #define __CDSPLIBVIRT_H__
 
 #include <QThread>
+#include <QStringList>
 #include <utility>
 #include <QWeakPointer>
 #include <prlsdk/PrlTypes.h>
@@ -845,7 +846,7 @@ struct List
 	Unit at(const QString& uuid_) const;
 	Grub getGrub(const CVmConfiguration& image_);
 	Result all(QList<Unit>& dst_);
-	QList<Performance::Unit> getPerformance();
+	QList<Performance::Unit> getPerformance(unsigned groups_, const QStringList& uuids_);
 
 private:
 	QSharedPointer<virConnect> m_link;
@@ -2194,24 +2194,48 @@ Result List::all(QList<Unit>& dst_)
 	return Result();
 }
 
-QList<Performance::Unit> List::getPerformance()
+QList<Performance::Unit> List::getPerformance(unsigned groups_, const QStringList& uuids_)
 {
 	QList<Performance::Unit> output;
+	if (m_link.isNull() || uuids_.isEmpty())
+		return output;
+
+	// only the demanded domains go to libvirt, the rest are not even
+	// looked at by the driver
+	QVector<virDomainPtr> d;
+	foreach (const QString& u, uuids_)
+	{
+		PrlUuid x(u.toUtf8().data());
+		virDomainPtr y = virDomainLookupByUUIDString(m_link.data(),
+				x.toString(PrlUuid::WithoutBrackets).data());
+		if (NULL == y)
+			continue;
+
+		if (virDomainIsPersistent(y) == 1)
+			d << y;
+		else
+			virDomainFree(y);
+	}
+	if (d.isEmpty())
+		return output;
+
+	d << NULL;
 	virDomainStatsRecordPtr* s = NULL;
-	int z = virConnectGetAllDomainStats(m_link.data(), 0, &s, VIR_CONNECT_GET_ALL_DOMAINS_STATS_PERSISTENT);
+	int z = virDomainListGetStats(d.data(), groups_, &s, 0);
 	Performance::Unit::pin_type p(s, &virDomainStatsRecordListFree);
+	// the records hold own references to the domains
+	std::for_each(d.begin(), d.end() - 1, &virDomainFree);
 	if (0 > z)
 	{
-		WRITE_TRACE(DBG_FATAL, "unable to get perfomance statistics for all domains (return %d)", z);
+		WRITE_TRACE(DBG_FATAL, "unable to get perfomance statistics for %d domains (return %d)",
+			d.size() - 1, z);
 		return output;
 	}
 
 	for (int i = 0; i < z; ++i)
 	{
-		if (s[i] == NULL)
-			continue;
-
-		output << Performance::Unit(s[i], p);
+		if (s[i] != NULL)
+			output << Performance::Unit(s[i], p);
 	}
 
 	return output;
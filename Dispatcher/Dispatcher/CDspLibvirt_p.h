@@ -33,6 +33,7 @@
 #ifndef __CDSPLIBVIRT_P_H__
 #define __CDSPLIBVIRT_P_H__
 
+#include <QSet>
 #include <QTimer>
 #include "CDspClient.h"
 #include "CDspLibvirt.h"
@@ -455,6 +456,23 @@ private:
 	State::agent_type m_agent;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Refresh
+
+struct Refresh
+{
+	Refresh(const Domain& domain_, const QSharedPointer<QAtomicInt>& pending_):
+		m_domain(domain_), m_pending(pending_)
+	{
+	}
+
+	void operator()(Registry::Access& access_);
+
+private:
+	Domain m_domain;
+	QSharedPointer<QAtomicInt> m_pending;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Network
 
@@ -589,11 +607,13 @@ struct Entry: Reaction::Demonstrator
 	{
 		return static_cast<VIRTUAL_MACHINE_STATE>(m_last.operator int());
 	}
+	void refresh(const Callback::Reactor::Domain& domain_);
 
 private:
 	void changeAndExecute(VIRTUAL_MACHINE_STATE value_, const boost::function<void ()>& action_);
 
 	QAtomicInt m_last;
+	QSharedPointer<QAtomicInt> m_refresh;
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -659,7 +679,8 @@ namespace Monitor
 enum
 {
 	RECONNECT_TIMEOUT = 1000,
-	PERFORMANCE_TIMEOUT = 10000
+	PERFORMANCE_TIMEOUT = 10000,
+	BLOCK_STATS_TIMEOUT = 30000
 };
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -728,13 +749,27 @@ private:
 	view_type m_view;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Metrics
+// Latency of the libvirt stats calls per Stat::Demand group, published as
+// the dispatcher counters libvirt.stats.<group>.{calls,total,last,peak} in
+// usec. A call that samples several groups is accounted to each of them.
+
+struct Metrics
+{
+	static void account(unsigned groups_, quint64 duration_);
+
+private:
+	static QString getName(unsigned group_);
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Miner
 
 struct Miner: QObject
 {
 	Miner(const Instrument::Agent::Vm::List& agent_, const QWeakPointer<Model::System>& view_):
-		m_agent(agent_), m_view(view_)
+		m_tick(), m_agent(agent_), m_view(view_)
 	{
 	}
 
@@ -745,6 +780,12 @@ protected:
 	void timerEvent(QTimerEvent* );
 
 private:
+	unsigned getDue();
+	static unsigned convert(unsigned groups_);
+
+	quint64 m_tick;
+	// domains whose block stats were wanted at the previous round
+	QSet<QString> m_block;
 	Instrument::Agent::Vm::List m_agent;
 	QWeakPointer<Model::System> m_view;
 };
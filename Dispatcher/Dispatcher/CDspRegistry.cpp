@@ -31,6 +31,8 @@
 ///////////////////////////////////////////////////////////////////////////////
 
 #include <QMutex>
+#include <QCryptographicHash>
+#include "CDspVm.h"
 #include "CDspRegistry.h"
 #include "CDspClient.h"
 #include "CDspInstrument.h"
@@ -38,6 +40,8 @@
 #include "CDspDispConfigGuard.h"
 #include "CDspVmNetworkHelper.h"
 #include "CDspVmStateMachine.h"
+#include "CDspVmGuest.h"
+#include "CDspVmUptime.h"
 #include "Stat/CDspStatStorage.h"
 #include <boost/phoenix/operator.hpp>
 #include <boost/functional/factory.hpp>
@@ -135,7 +139,9 @@ struct Vm: ::Vm::State::Machine
 		process_event(event_);
 	}
 
-	void updateConfig(CVmConfiguration value_);
+	void updateConfig(CVmConfiguration value_,
+		const boost::optional<QString>& onReboot_ = boost::none);
+	void trackUptime(VIRTUAL_MACHINE_STATE value_);
 
 	void initOnRebootState(bool destroyEnabled) { m_upgradeState = destroyEnabled ? VmOnRebootState::CONFIG_DESTROY : VmOnRebootState::NONE; };
 	bool isOnRebootDestroy() const { return m_upgradeState == VmOnRebootState::UPGRADE_TMP_DESTROY || m_upgradeState == VmOnRebootState::CONFIG_DESTROY; };
@@ -155,10 +161,19 @@ struct Vm: ::Vm::State::Machine
 	PRL_VM_TOOLS_STATE getToolsState();
 
 private:
+	typedef QPair<QByteArray, QString> marker_type;
+
+	marker_type getMarker(const QByteArray& digest_) const;
+
 	QMutex m_mutex;
 	QSharedPointer<Stat::Storage> m_storage;
 	QSharedPointer<Network::Routing> m_routing;
 	VmOnRebootState		m_upgradeState;
+	// on_reboot action of the inactive domain, refreshed by libvirt events
+	boost::optional<QString> m_onReboot;
+	// digest of the last applied update along with the stamp of the config
+	// file it was committed to
+	marker_type m_applied;
 };
 
 namespace Update
@@ -333,6 +348,25 @@ Complement::result_type Complement::operator()(PRL_RESULT request_)
 	return PRL_ERR_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Uptime
+
+struct Uptime
+{
+	explicit Uptime(quint64 delta_): m_delta(delta_)
+	{
+	}
+
+	void operator()(CVmConfiguration& config_) const
+	{
+		CVmIdentification* x = config_.getVmIdentification();
+		x->setVmUptimeInSeconds(x->getVmUptimeInSeconds() + m_delta);
+	}
+
+private:
+	quint64 m_delta;
+};
+
 } // namespace Update
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -364,10 +398,13 @@ Vm::Vm(const QString& uuid_, const SmartPtr<CDspClient>& user_,
 	m_storage->addAbsolute("cpu_time");
 }
 
-void Vm::updateConfig(CVmConfiguration value_)
+void Vm::updateConfig(CVmConfiguration value_, const boost::optional<QString>& onReboot_)
 {
 	QMutexLocker l(&m_mutex);
 
+	if (onReboot_)
+		m_onReboot = onReboot_;
+
 	setName(value_.getVmIdentification()->getVmName());
 	boost::signals2::signal<void (CVmConfiguration& )> s;
 	if (value_.getVmIdentification()->getHomePath().isEmpty())
@@ -378,9 +415,13 @@ void Vm::updateConfig(CVmConfiguration value_)
 					::type::do_, boost::ref(value_), _1));
 	}
 	bool should_start = isStartNeeded();
-	CVmConfiguration inactive;
-	Libvirt::Kit.vms().at(value_.getVmIdentification()->getVmUuid()).getConfig(inactive, false);
-	initOnRebootState(inactive.getVmSettings()->getVmStartupOptions()->getOnRebootAction() == "destroy");
+	if (!m_onReboot)
+	{
+		CVmConfiguration inactive;
+		Libvirt::Kit.vms().at(value_.getVmIdentification()->getVmUuid()).getConfig(inactive, false);
+		m_onReboot = inactive.getVmSettings()->getVmStartupOptions()->getOnRebootAction();
+	}
+	initOnRebootState(m_onReboot.get() == "destroy");
 
 	if (is_flag_active< ::Vm::State::Running>())
 	{
@@ -393,7 +434,7 @@ void Vm::updateConfig(CVmConfiguration value_)
 				!pStartupOptions->getBios()->getNVRAM().endsWith(VZ_VM_NVRAM_FILE_NAME) &&
 				m_upgradeState != VmOnRebootState::CONFIG_DESTROY)
 		{
-			pStartupOptions->setOnEfiUpdateAction(inactive.getVmSettings()->getVmStartupOptions()->getOnRebootAction());
+			pStartupOptions->setOnEfiUpdateAction(m_onReboot.get());
 			Libvirt::Kit.vms().at(value_.getVmIdentification()->getVmUuid()).getEditor().setOnRebootLifecycleAction(VIR_DOMAIN_LIFECYCLE_ACTION_DESTROY);
 			m_upgradeState = VmOnRebootState::UPGRADE_TMP_DESTROY;
 		}
@@ -416,11 +457,61 @@ void Vm::updateConfig(CVmConfiguration value_)
 		}
 	}
 
+	// the same update is skipped while nobody else touched the config
+	QByteArray d = QCryptographicHash::hash(value_.toString().toUtf8(),
+		QCryptographicHash::Sha1);
+	if (!m_applied.second.isEmpty() && getMarker(d) == m_applied)
+	{
+		WRITE_TRACE(DBG_DEBUG, "VM config is up to date, skip the update");
+		return;
+	}
+
 	s.connect(boost::phoenix::placeholders::arg1 = boost::phoenix::cref(value_));
 	Update::Workbench w(*this, getUser(), Update::Workbench::base_type(getService()));
-	Update::Adoption(value_, w,
+	PRL_RESULT e = Update::Adoption(value_, w,
 		Update::Compulsion(s, w,
 			Update::Complement(value_, *this)))(getConfigEditor()(s));
+	m_applied = PRL_SUCCEEDED(e) ? getMarker(d) : marker_type();
+}
+
+void Vm::trackUptime(VIRTUAL_MACHINE_STATE value_)
+{
+	DspVm::Uptime& u = CDspVm::getUptimeStore();
+	switch (value_)
+	{
+	case VMS_RUNNING:
+	case VMS_PAUSED:
+		return u.start(getUuid());
+	case VMS_STOPPED:
+	case VMS_SUSPENDED:
+		break;
+	default:
+		return;
+	}
+	quint64 d = u.fold(getUuid());
+	if (0 == d)
+		return;
+
+	PRL_RESULT e = getConfigEditor()(Update::Uptime(d));
+	if (PRL_SUCCEEDED(e))
+		return;
+
+	WRITE_TRACE(DBG_FATAL, "Unable to fold the uptime of the VM %s into its config: %s",
+		qPrintable(getUuid()), PRL_RESULT_TO_STRING(e));
+	// keep the delta to fold it on the next stop
+	u.add(getUuid(), d);
+	u.flush();
+}
+
+Vm::marker_type Vm::getMarker(const QByteArray& digest_) const
+{
+	// the stamp of the config digests: two commits within a millisecond
+	// must differ
+	QString x = ::Vm::Config::Access::Digest::getStamp(getHome());
+	if (x.isEmpty())
+		return marker_type();
+
+	return marker_type(digest_, x);
 }
 
 PRL_VM_TOOLS_STATE Vm::getToolsState()
@@ -517,6 +608,10 @@ void Reactor::updateAgent(const boost::optional<PRL_VM_TOOLS_STATE>& state_)
 
 void Reactor::proceed(VIRTUAL_MACHINE_STATE destination_)
 {
+	QSharedPointer<Vm> x = m_vm.toStrongRef();
+	if (!x.isNull())
+		x->trackUptime(destination_);
+
 	switch(destination_)
 	{
 	case VMS_RUNNING:
@@ -574,6 +669,15 @@ void Access::updateConfig(const CVmConfiguration& value_)
 	x->updateConfig(value_);
 }
 
+void Access::updateConfig(const CVmConfiguration& value_, const QString& onReboot_)
+{
+	QSharedPointer<Vm> x = m_vm.toStrongRef();
+	if (x.isNull())
+		return;
+
+	x->updateConfig(value_, onReboot_);
+}
+
 QWeakPointer<Stat::Storage> Access::getStorage()
 {
 	QSharedPointer<Vm> x = m_vm.toStrongRef();
@@ -691,6 +795,10 @@ void Actual::undefine(const QString& uuid_)
 		return;
 	}
 	l.unlock();
+	CDspVm::getUptimeStore().forget(uuid_);
+	CDspVm::getUptimeStore().flush();
+	::Vm::Guest::Breaker::instance().forget(uuid_);
+	::Vm::Guest::Network::Cache::instance().forget(uuid_);
 	PRL_RESULT e = m_service->getVmDirHelper()
 		.deleteVmDirectoryItem(m->getDirectory(), uuid_);
 	if (PRL_FAILED(e))
@@ -116,6 +116,9 @@ struct Access
 	boost::optional<CVmConfiguration> getConfig() const;
 
 	void updateConfig(const CVmConfiguration& value_);
+	// NB. onReboot_ is the on_reboot action of the inactive domain.
+	// the registry caches it to avoid re-reading the domain XML.
+	void updateConfig(const CVmConfiguration& value_, const QString& onReboot_);
 
 	QWeakPointer<Stat::Storage> getStorage();
 
@@ -116,6 +116,7 @@
 #endif
 
 #include "CDspVzHelper.h"
+#include "CDspExecutor.h"
 
 #if defined(_LIN_)
 #include "Libraries/PrlCommonUtils/RLimits.h"
@@ -487,6 +488,7 @@ m_nStopTimeout(0),
 m_nStopTimerId(-1),
 m_bRebootHost(false),
 m_hostInfoMutex( QMutex::Recursive ),
+m_hostSnapshotGeneration( 0 ),
 m_bWaitForInitCompletion( false ),
 m_bFirstInitPhaseCompleted( false ),
 m_pVmManagerHandler( CDspHandlerRegistrator::instance().findHandler( IOSender::Vm ) ),
@@ -671,6 +673,34 @@ CDspLockedPointer<CDspHostInfo> CDspService::getHostInfo ()
 	return CDspLockedPointer<CDspHostInfo>(&m_hostInfoMutex, &m_hostInfo);
 }
 
+QSharedPointer<const CHostHardwareInfo> CDspService::getHostInfoSnapshot ()
+{
+	{
+		QMutexLocker g(&m_hostSnapshotMutex);
+		if (!m_hostSnapshot.isNull() && m_hostSnapshotGeneration == m_hostInfo.getGeneration())
+			return m_hostSnapshot;
+	}
+	// NOTE: do not hold the snapshot mutex here, the host info owner may
+	// request a snapshot under its lock
+	int n;
+	QSharedPointer<const CHostHardwareInfo> x;
+	{
+		CDspLockedPointer<CDspHostInfo> h = getHostInfo();
+		if (NULL == h->data())
+			return QSharedPointer<const CHostHardwareInfo>(new CHostHardwareInfo());
+
+		n = h->getGeneration();
+		x = QSharedPointer<const CHostHardwareInfo>(new CHostHardwareInfo(h->data()));
+	}
+	QMutexLocker g(&m_hostSnapshotMutex);
+	if (m_hostSnapshot.isNull() || m_hostSnapshotGeneration - n < 0)
+	{
+		m_hostSnapshot = x;
+		m_hostSnapshotGeneration = n;
+	}
+	return m_hostSnapshot;
+}
+
 CDspVmDirManager& CDspService::getVmDirManager ()
 {
 	return *m_vmDirManager;
@@ -1011,9 +1041,13 @@ void CDspService::stop (CDspService::StopMode stop_mode)
 		}
 #endif // _LIBVIRT_
 #endif
+		Executor::shutdown();
 		QThreadPool::globalInstance()->setMaxThreadCount(0);
 		QThreadPool::globalInstance()->waitForDone();
 	}
+	// the VMs outlive the service, keep the time they have run until now
+	CDspVm::getUptimeStore().account();
+	CDspVm::getUptimeStore().flush();
 #ifndef _WIN_
 	// revert sighandler
 	CUnixSignalHandler::removeHandler(SIGTERM);
@@ -1551,6 +1585,9 @@ void CDspService::initHypervisor()
 
 void CDspService::initSyncVmUptimeTask()
 {
+	CDspVm::getUptimeStore().load(QDir(VirtuozzoDirs::getDispatcherConfigDir())
+		.absoluteFilePath("vms.uptime"));
+
 	SmartPtr<CDspClient> pUser( new CDspClient(IOSender::Handle()) );
 	pUser->getAuthHelper().AuthUserBySelfProcessOwner();
 
@@ -35,6 +35,7 @@
 
 #include <QCoreApplication>
 #include <QAtomicInt>
+#include <QSharedPointer>
 #include <QList>
 #include <prlcommon/Interfaces/VirtuozzoNamespace.h>
 #include <prlcommon/PrlCommonUtilsBase/CommandLine.h>
@@ -208,6 +209,9 @@ public:
 	/** Returns host info instance */
 	CDspLockedPointer<CDspHostInfo> getHostInfo ();
 
+	/** Returns immutable copy of the host hardware info, rebuilt only after the data was changed */
+	QSharedPointer<const CHostHardwareInfo> getHostInfoSnapshot ();
+
 	/** Returns vm dir manager */
 	CDspVmDirManager& getVmDirManager();
 
@@ -465,6 +469,10 @@ private:
 	QMutex m_hostInfoMutex;
 	CDspHostInfo m_hostInfo;
 
+	QMutex m_hostSnapshotMutex;
+	int m_hostSnapshotGeneration;
+	QSharedPointer<const CHostHardwareInfo> m_hostSnapshot;
+
 	CDspSettingsWrap m_AppSettings;
 
 	QMutex	m_networkConfigMutex;
@@ -220,27 +220,27 @@ void CDspShellHelper::sendHostHardwareInfo (
 	const SmartPtr<IOPackage>& p )
 {
 
-	SmartPtr<CHostHardwareInfo> hw_info(0);
-	CDspLockedPointer<CDspHostInfo> hostInfo =
-		CDspService::instance()->getHostInfo();
-	hostInfo->refresh();
-
-	hw_info = SmartPtr<CHostHardwareInfo>(
-		new CHostHardwareInfo(hostInfo->data()));
+	// NOTE: host info is kept up to date by the hardware monitor,
+	// do not rescan the host on each request
+	QSharedPointer<const CHostHardwareInfo> s =
+		CDspService::instance()->getHostInfoSnapshot();
+	QString hw_info = s->toString();
 
 	// #440246: always add for client default CD-ROM device
-	if (hw_info->m_lstOpticalDisks.isEmpty())
+	if (s->m_lstOpticalDisks.isEmpty())
 	{
-		hw_info->m_lstOpticalDisks.prepend( new CHwGenericDevice(
+		CHostHardwareInfo h(hw_info);
+		h.m_lstOpticalDisks.prepend( new CHwGenericDevice(
 													PDE_OPTICAL_DISK,
 													PRL_DVD_DEFAULT_DEVICE_NAME,
 													PRL_DVD_DEFAULT_DEVICE_NAME) );
+		hw_info = h.toString();
 	}
 
 	CProtoCommandPtr pResponse = CProtoSerializer::CreateDspWsResponseCommand( p, PRL_ERR_SUCCESS );
 	CProtoCommandDspWsResponse* hostInfoCmd =
 		CProtoSerializer::CastToProtoCommand<CProtoCommandDspWsResponse>(pResponse);
-	hostInfoCmd->SetHostHardwareInfo( hw_info->toString() );
+	hostInfoCmd->SetHostHardwareInfo( hw_info );
 	SmartPtr<IOPackage> response =
 		DispatcherPackage::createInstance( PVE::DspWsResponse, pResponse, p );
 
@@ -214,7 +214,7 @@ void CDspTaskHelper::run()
 		, getRequestFlags()
 		);
 
-	Task::Trace t(m_requestPkg);
+	Task::Trace t(m_requestPkg, m_sRequestVmUuid);
 	t.start();
 	bool bExceptionWasCaught = false;
 	try
@@ -335,6 +335,7 @@ void CDspTaskHelper::parseFlags()
 		CProtoCommandPtr pCmd = CProtoSerializer::ParseCommand(m_requestPkg);
 
 		m_uiRequestFlags = pCmd->GetCommandFlags();
+		m_sRequestVmUuid = pCmd->GetVmUuid();
 
 		//Process common non interactive mode flag
 		if ( m_uiRequestFlags & PACF_NON_INTERACTIVE_MODE )
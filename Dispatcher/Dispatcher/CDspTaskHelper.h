@@ -214,6 +214,7 @@ private:
 	SmartPtr<CDspClient> m_pUser;
 	SmartPtr<IOPackage> m_requestPkg;
 	PRL_UINT32					m_uiRequestFlags;
+	QString						m_sRequestVmUuid;
 
 	// thread uuid
 	Uuid m_JobUuid;
@@ -32,12 +32,124 @@
 
 #include <syslog.h>
 #include "CDspTaskTrace.h"
+#include "CDspTaskTrace_p.h"
 #include <boost/property_tree/json_parser.hpp>
 #include <prlcommon/ProtoSerializer/CProtoSerializer.h>
 #include <prlcommon/PrlCommonUtilsBase/PrlStringifyConsts.h>
 
 namespace Task
 {
+namespace Syslog
+{
+namespace
+{
+
+void write(int priority_, const QByteArray& record_)
+{
+	syslog(priority_, "%s", record_.constData());
+}
+
+Sink& getSink()
+{
+	static Sink s_instance(&write);
+	return s_instance;
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Sink
+
+void Sink::push(const QByteArray& record_)
+{
+	{
+		QMutexLocker g(&m_mutex);
+		if (!m_stop && isRunning())
+		{
+			if (CAPACITY > m_queue.size())
+			{
+				m_queue.enqueue(record_);
+				m_wait.wakeOne();
+			}
+			else
+				++m_dropped;
+
+			return;
+		}
+	}
+	m_write(LOG_INFO, record_);
+}
+
+void Sink::stop()
+{
+	{
+		QMutexLocker g(&m_mutex);
+		m_stop = true;
+		m_wait.wakeOne();
+	}
+	wait();
+	QMutexLocker g(&m_mutex);
+	m_stop = false;
+}
+
+void Sink::run()
+{
+	forever
+	{
+		QQueue<QByteArray> q;
+		quint64 d;
+		bool x;
+		{
+			QMutexLocker g(&m_mutex);
+			while (m_queue.isEmpty() && !m_stop)
+				m_wait.wait(&m_mutex);
+
+			q.swap(m_queue);
+			d = m_dropped;
+			m_dropped = 0;
+			x = m_stop;
+		}
+		foreach (const QByteArray& r, q)
+			m_write(LOG_INFO, r);
+
+		if (0 < d)
+		{
+			m_write(LOG_WARNING, QByteArray::number(d)
+				.append(" task trace records dropped"));
+		}
+		if (x)
+			return;
+	}
+}
+
+QByteArray quote(const QString& value_)
+{
+	QByteArray x = value_.toUtf8(), output;
+	output.reserve(x.size() + 2);
+	output.append('"');
+	foreach (char c, x)
+	{
+		switch (c)
+		{
+		case '"':
+			output.append("\\\"");
+			break;
+		case '\\':
+			output.append("\\\\");
+			break;
+		default:
+			if (0 <= c && c < 0x20)
+				output.append(QString("\\u%1").arg(int(c), 4, 16, QChar('0')).toLatin1());
+			else
+				output.append(c);
+		}
+	}
+	output.append('"');
+	return output;
+}
+
+} // namespace Syslog
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Trace
 
@@ -46,56 +158,70 @@ Trace::Trace(const SmartPtr<IOService::IOPackage>& request_)
 	if (!request_.isValid())
 		return;
 
-	m_uuid = Uuid::toString(request_->header.uuid);
+	QString u;
 	Virtuozzo::CProtoCommandPtr d = Virtuozzo::CProtoSerializer::ParseCommand(request_);
-	if (!d.isValid())
-		return;
+	if (d.isValid())
+		u = d->GetVmUuid();
+
+	assign(request_, u);
+}
 
-	m_type = PVE::DispatcherCommandToString(d->GetCommandId());
-	m_vmUuid = d->GetVmUuid();
+Trace::Trace(const SmartPtr<IOService::IOPackage>& request_, const QString& vmUuid_)
+{
+	if (request_.isValid())
+		assign(request_, vmUuid_);
+}
+
+void Trace::assign(const SmartPtr<IOService::IOPackage>& request_, const QString& vmUuid_)
+{
+	m_uuid = Syslog::quote(Uuid::toString(request_->header.uuid));
+	m_head = "{\"type\":";
+	m_head += Syslog::quote(PVE::DispatcherCommandToString(request_->header.type));
+	m_head += ",\"uuid\":";
+	m_head += m_uuid;
+	if (!vmUuid_.isEmpty())
+	{
+		m_head += ",\"vmUuid\":";
+		m_head += Syslog::quote(vmUuid_);
+	}
+	m_head += ",\"progress\":";
 }
 
 void Trace::start() const
 {
-	boost::property_tree::ptree t;
-	t.put("start", m_uuid.toStdString());
-	report(t);
+	push("{\"start\":" + m_uuid + '}');
 }
 
 void Trace::finish(PRL_RESULT code_) const
 {
-	boost::property_tree::ptree t;
-	t.put("result", PRL_RESULT_TO_STRING(code_));
-	report(t);
+	push("{\"result\":" + Syslog::quote(PRL_RESULT_TO_STRING(code_)) + '}');
 }
 
 void Trace::report(const boost::property_tree::ptree& progress_) const
 {
-	boost::property_tree::ptree t;
-	t.put("type", m_type.toStdString());
-	t.put("uuid", m_uuid.toStdString());
-	if (!m_vmUuid.isEmpty())
-		t.put("vmUuid", m_vmUuid.toStdString());
+	std::stringstream s;
+	boost::property_tree::json_parser::write_json(s, progress_, false);
+	push(QByteArray(s.str().c_str()).trimmed());
+}
 
-	t.put_child("progress", progress_);
+void Trace::push(const QByteArray& progress_) const
+{
+	if (m_head.isEmpty())
+		return;
 
-	std::stringstream s;
-	boost::property_tree::json_parser::write_json(s, t, false);
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wformat-security"
-	syslog(LOG_INFO, s.str().c_str());
-#pragma GCC diagnostic pop
+	Syslog::getSink().push(m_head + progress_ + '}');
 }
 
 void Trace::raze()
 {
+	Syslog::getSink().stop();
 	closelog();
 }
 
 void Trace::setup()
 {
 	openlog("vz-dispatcher", LOG_PID, LOG_INFO | LOG_USER);
+	Syslog::getSink().start(QThread::LowPriority);
 }
 
 } // namespace Task
-
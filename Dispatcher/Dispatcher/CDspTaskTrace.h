@@ -46,6 +46,8 @@ namespace Task
 struct Trace
 {
 	explicit Trace(const SmartPtr<IOService::IOPackage>& request_);
+	// for the callers that have parsed the request already
+	Trace(const SmartPtr<IOService::IOPackage>& request_, const QString& vmUuid_);
 
 	void start() const;
 	void finish(PRL_RESULT code_) const;
@@ -55,7 +57,12 @@ struct Trace
 	static void setup();
 
 private:
-	QString m_type, m_uuid, m_vmUuid;
+	void assign(const SmartPtr<IOService::IOPackage>& request_, const QString& vmUuid_);
+	void push(const QByteArray& progress_) const;
+
+	QByteArray m_uuid;
+	// the common part of all the records of the task
+	QByteArray m_head;
 };
 
 } // namespace Task
@@ -0,0 +1,90 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspTaskTrace_p.h
+///
+/// Private part of the task trace producer.
+///
+/// @author shrike
+///
+/// Copyright (c) 2005-2017 Parallels IP Holdings GmbH
+/// Copyright (c) 2017-2019 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo IP Holdings GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDSPTASKTRACE_P_H__
+#define __CDSPTASKTRACE_P_H__
+
+#include <QMutex>
+#include <QQueue>
+#include <QThread>
+#include <QByteArray>
+#include <QWaitCondition>
+#include <boost/function.hpp>
+
+namespace Task
+{
+namespace Syslog
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Sink
+// Records reach syslog from a thread of its own, thus a slow syslog does not
+// delay the tasks. The records that do not fit into the queue are dropped and
+// counted.
+
+struct Sink: QThread
+{
+	// takes a syslog priority and a record
+	typedef boost::function<void (int, const QByteArray&)> write_type;
+
+	enum { CAPACITY = 4096 };
+
+	explicit Sink(const write_type& write_): m_write(write_), m_stop(false), m_dropped(0)
+	{
+	}
+	~Sink()
+	{
+		if (isRunning())
+			stop();
+	}
+
+	void push(const QByteArray& record_);
+	void stop();
+
+protected:
+	void run();
+
+private:
+	write_type m_write;
+	QMutex m_mutex;
+	QWaitCondition m_wait;
+	QQueue<QByteArray> m_queue;
+	bool m_stop;
+	quint64 m_dropped;
+};
+
+// a JSON string literal of the value
+QByteArray quote(const QString& value_);
+
+} // namespace Syslog
+} // namespace Task
+
+#endif // __CDSPTASKTRACE_P_H__
@@ -32,6 +32,7 @@
 
 #include "CDspService.h"
 #include "CDspTemplateScanner.h"
+#include "CDspExecutor.h"
 #include <prlcommon/Logging/Logging.h>
 #include <prlcommon/PrlCommonUtilsBase/PrlStringifyConsts.h>
 
@@ -100,7 +101,7 @@ PRL_RESULT Folder::schedule(const Facade::Folder& facade_, dao_type dao_)
 
 	Folder* f = new Folder(facade_, x.take());
 	f->setAutoDelete(true);
-	QThreadPool::globalInstance()->start(f);
+	Executor::get(Executor::TEMPLATE).start(f);
 
 	return PRL_ERR_SUCCESS;
 }
@@ -183,7 +184,7 @@ void Engine::execute()
 {
 	Host* h = new Host(m_facade, dao_type(m_helper));
 	h->setAutoDelete(true);
-	QThreadPool::globalInstance()->start(h);
+	Executor::get(Executor::TEMPLATE).start(h);
 	schedule(PERIOD);
 }
 
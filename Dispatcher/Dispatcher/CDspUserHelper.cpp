@@ -53,6 +53,7 @@
 #include "CDspService.h"
 #include "CDspClientManager.h"
 #include "CDspUserHelper.h"
+#include "CDspUserHelper_p.h"
 
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
 
@@ -83,6 +84,12 @@
 
 using namespace Virtuozzo;
 
+namespace
+{
+Login::Memo<Login::Profile> g_profile;
+
+} // namespace
+
 ///////////////////////////////////////////////////////////////////////////////
 
 CDspUserHelper::CDspUserHelper ()
@@ -198,6 +205,23 @@ bool CDspUserHelper::fillUserPreferences (
     // set user state (access token is generated automatically)
     p_NewUser->setUserState( PVE::UserConnectedLoggedOn );
 
+	// a user logged on a moment ago has the record and the VM directory
+	// ready, the account is not looked up again while they are the same
+	boost::optional<Login::Profile> x = g_profile.find( user_name );
+	if( x )
+	{
+		CDspLockedPointer< CDispUser >
+			u = CDspService::instance()->getDispConfigGuard().getDispUserByUuid( x->m_user );
+		if( u && u->getUserName() == user_name
+			&& u->getUserWorkspace()->getVmDirectory() == x->m_directory )
+		{
+			p_NewUser->setUserSettings( x->m_user, user_name );
+			p_NewUser->setVmDirectoryUuid( x->m_directory );
+			return true;
+		}
+		g_profile.drop( user_name );
+	}
+
     /**
      * trying to find user's registration record in the Dispatcher's config
      */
@@ -314,8 +338,14 @@ bool CDspUserHelper::fillUserPreferences (
 					  user_name.toUtf8().data() );
 
 		// #444668 Don't send error  - allow to start session
+		return true;
     }
 
+	Login::Profile y;
+	y.m_user = p_NewUser->getUserSettingsUuid();
+	y.m_directory = p_NewUser->getVmDirectoryUuid();
+	g_profile.add( user_name, y );
+
     return true;
 }
 
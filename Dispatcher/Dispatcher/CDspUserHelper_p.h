@@ -0,0 +1,164 @@
+////////////////////////////////////////////////////////////////////////////////
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/// @file
+///	CDspUserHelper_p.h
+///
+/// @brief
+///	Short-term memory of the user lookups done on logon
+///
+/// @date
+///	2026-10-19
+///
+////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDspUserHelper_p_H_
+#define __CDspUserHelper_p_H_
+
+#include <QDir>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QString>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStringList>
+#include <QElapsedTimer>
+#include <QCryptographicHash>
+#include <boost/optional.hpp>
+
+namespace Login
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Memo
+// Remembers a value looked up for a user. Reconnecting clients skip the
+// lookup, anything is forgotten after the TTL anyway.
+
+template<class T>
+struct Memo
+{
+	enum
+	{
+		TTL = 30 * 1000,
+		CAPACITY = 1024
+	};
+
+	explicit Memo(qint64 ttl_ = TTL): m_ttl(ttl_)
+	{
+	}
+
+	boost::optional<T> find(const QString& key_)
+	{
+		QMutexLocker g(&m_mutex);
+		typename map_type::iterator p = m_data.find(key_);
+		if (m_data.end() == p)
+			return boost::none;
+
+		if (!p->second.hasExpired(m_ttl))
+			return p->first;
+
+		m_data.erase(p);
+		return boost::none;
+	}
+	void add(const QString& key_, const T& value_)
+	{
+		QElapsedTimer t;
+		t.start();
+		QMutexLocker g(&m_mutex);
+		if (CAPACITY <= m_data.size() && !m_data.contains(key_))
+			m_data.clear();
+
+		m_data.insert(key_, qMakePair(value_, t));
+	}
+	void drop(const QString& key_)
+	{
+		QMutexLocker g(&m_mutex);
+		m_data.remove(key_);
+	}
+
+private:
+	typedef QHash<QString, QPair<T, QElapsedTimer> > map_type;
+
+	qint64 m_ttl;
+	QMutex m_mutex;
+	map_type m_data;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Profile
+// The dispatcher record of a user and its VM directory, both ready.
+
+struct Profile
+{
+	QString m_user;
+	QString m_directory;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Keys
+// The public keys that were found authorized, per home. A key is forgotten as
+// soon as the ssh directory of the user changes. Only positive verdicts are
+// kept, thus a new key is always checked against the file.
+
+struct Keys
+{
+	explicit Keys(qint64 ttl_ = Memo<QString>::TTL): m_memo(ttl_)
+	{
+	}
+
+	bool isAuthorized(const QString& home_, const QString& key_)
+	{
+		boost::optional<QString> s = m_memo.find(digest(home_, key_));
+		return s && s.get() == stamp(home_);
+	}
+	void authorize(const QString& home_, const QString& key_)
+	{
+		m_memo.add(digest(home_, key_), stamp(home_));
+	}
+
+private:
+	static QString stamp(const QString& home_)
+	{
+		QString output;
+		QStringList x;
+		x << ".ssh" << ".ssh/authorized_keys";
+		foreach (const QString& n, x)
+		{
+			QFileInfo i(QDir(home_).filePath(n));
+			output.append(QString("%1:%2:%3;").arg(i.exists())
+				.arg(i.lastModified().toMSecsSinceEpoch()).arg(i.size()));
+		}
+		return output;
+	}
+	static QString digest(const QString& home_, const QString& key_)
+	{
+		return QString(QCryptographicHash::hash((home_ + '\n' + key_).toUtf8(),
+			QCryptographicHash::Sha1).toHex());
+	}
+
+	Memo<QString> m_memo;
+};
+
+} // namespace Login
+
+#endif // __CDspUserHelper_p_H_
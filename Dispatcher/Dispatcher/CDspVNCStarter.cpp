@@ -40,6 +40,8 @@
 
 #include <QCoreApplication>
 #include <QStringList>
+#include <QFile>
+#include <QElapsedTimer>
 #include "CDspVmDirHelper.h"
 #include <prlcommon/Interfaces/VirtuozzoQt.h>
 #include <prlcommon/Interfaces/VirtuozzoSdkPrivate.h>
@@ -288,14 +290,59 @@ PRL_RESULT Launcher::operator()(quint16 accept_, QProcess& process_)
 		WRITE_TRACE(DBG_FATAL, "Error: can't start socat");
 		return PRL_ERR_FAILED_TO_START_VNC_SERVER;
 	}
-	if (process_.waitForFinished(WAIT_TO_EXIT_VNC_SERVER_AFTER_START))
+	// socat is ready as soon as it listens on the port
+	QElapsedTimer t;
+	t.start();
+	do
 	{
-		WRITE_TRACE(DBG_FATAL, "Error: the socat has quieted unexpectedly");
-		return PRL_ERR_UNEXPECTED;
-	}
+		if (process_.waitForFinished(WAIT_VNC_SERVER_TO_LISTEN_POLL))
+		{
+			WRITE_TRACE(DBG_FATAL, "Error: the socat has quieted unexpectedly");
+			return PRL_ERR_UNEXPECTED;
+		}
+		if (!isVacant(accept_))
+			return PRL_ERR_SUCCESS;
+	} while (!t.hasExpired(WAIT_TO_EXIT_VNC_SERVER_AFTER_START));
+
+	WRITE_TRACE(DBG_WARNING, "socat is running but does not listen on %d yet", accept_);
 	return PRL_ERR_SUCCESS;
 }
 
+bool Launcher::isVacant(quint16 port_) const
+{
+	// the kernel socket tables tell it without a connection to the
+	// listener and without a probe socket racing with socat for the
+	// port. socat binds with reuseaddr, thus only a listener is in its way
+	QStringList t;
+	t << "/proc/net/tcp" << "/proc/net/tcp6";
+	foreach (const QString& n, t)
+	{
+		QFile f(n);
+		if (!f.open(QIODevice::ReadOnly))
+			continue;
+
+		// the header line goes first
+		f.readLine();
+		forever
+		{
+			QByteArray a = f.readLine();
+			if (a.isEmpty())
+				break;
+
+			// sl local_address rem_address st ...
+			QList<QByteArray> x = a.simplified().split(' ');
+			if (x.size() < 4 || x.at(3) != "0A")
+				continue;
+
+			bool y = false;
+			quint16 p = x.at(1).mid(x.at(1).lastIndexOf(':') + 1).toUShort(&y, 16);
+			if (y && p == port_)
+				return false;
+		}
+	}
+	return true;
+}
+
 } // namespace Socat
 
 namespace Secure
@@ -354,32 +401,48 @@ Subject::Subject(const Socat::Launcher& launcher_):
 {
 }
 
-PRL_RESULT Subject::startStunnel(quint16 begin_, quint16 end_)
+PRL_RESULT Subject::startStunnel(quint16 begin_, quint16 end_, quint16 hint_)
 {
 	if (begin_ > end_)
 		return PRL_ERR_INVALID_ARG;
 
 	QSet<quint16> u;
+	if (begin_ <= hint_ && hint_ <= end_)
+	{
+		u.insert(hint_);
+		if (PRL_SUCCEEDED(launch(hint_)))
+			return PRL_ERR_SUCCESS;
+	}
 	boost::mt19937 g(time(NULL));
 	boost::uniform_int<quint16> d(begin_, end_);
-	quint16 z = d.max() - d.min() + 1;
+	int z = d.max() - d.min() + 1;
 	while (u.size() != z)
 	{
 		quint16 p = d(g);
 		if (u.constEnd() == u.insert(p))
 			continue;
 
-		m_stunnel.reset(new QProcess());
-		if (PRL_SUCCEEDED(m_launcher(p, *m_stunnel)))
-		{
-			m_accept = p;
+		if (PRL_SUCCEEDED(launch(p)))
 			return PRL_ERR_SUCCESS;
-		}
 	}
 	m_stunnel.reset();
 	return PRL_ERR_FAILURE;
 }
 
+PRL_RESULT Subject::launch(quint16 port_)
+{
+	// busy ports are skipped without spawning a process
+	if (!m_launcher.isVacant(port_))
+		return PRL_ERR_FAILURE;
+
+	m_stunnel.reset(new QProcess());
+	PRL_RESULT output = m_launcher(port_, *m_stunnel);
+	if (PRL_SUCCEEDED(output))
+		m_accept = port_;
+
+	return output;
+}
+
 PRL_RESULT Subject::bringUpKeepAlive()
 {
 	m_keepAlive.reset(new QTcpSocket());
@@ -436,7 +499,7 @@ void Script::operator()(Feedback& feedback_)
 	QScopedPointer<Subject> s(m_subject());
 	quint16 p = m_setup.first, e = m_setup.second;
 
-	if (PRL_FAILED(s->startStunnel(p, e)))
+	if (PRL_FAILED(s->startStunnel(p, e, m_hint)))
 		return feedback_.generate(NULL, QString("Can't start Stunnel [%1:%2]").arg(p).arg(e));
 
 	if (PRL_FAILED(s->bringUpKeepAlive()))
@@ -659,6 +722,7 @@ void Frontend::draw(CVmRemoteDisplay& object_, const CVmRemoteDisplay* runtime_,
 				Launch::SetPort(m_commit, &Traits::configure,
 					*m_service));
 	q->setSweepMode(object_.getMode());
+	q->setHint(object_.getPortNumber());
 	QMetaObject::invokeMethod(m_rfb, "start", Qt::AutoConnection,
 				Q_ARG(Launch::Script* , q));
 
@@ -676,6 +740,7 @@ void Frontend::draw(CVmRemoteDisplay& object_, const CVmRemoteDisplay* runtime_,
 				Launch::SetPort(m_commit, &Traits::configureWS,
 					*m_service));
 	q->setSweepMode(PRD_AUTO);
+	q->setHint(object_.getWebSocketPortNumber());
 	QMetaObject::invokeMethod(m_websocket, "start", Qt::AutoConnection,
 				Q_ARG(Launch::Script* , q));
 }
@@ -53,6 +53,7 @@
 
 #define WAIT_VNC_SERVER_TO_START_OR_STOP_PROCESS (30*1000)
 #define WAIT_TO_EXIT_VNC_SERVER_AFTER_START (3*1000)
+#define WAIT_VNC_SERVER_TO_LISTEN_POLL (20)
 #define WAIT_VNC_SERVER_TO_WRITE_AFTER_START (120*1000)
 
 namespace Vnc
@@ -286,6 +286,8 @@ struct Launcher
 
 	PRL_RESULT operator()(quint16 accept_, QProcess& process_);
 	Launcher& setTarget(const QHostAddress& address_, quint16 port_);
+	// checks that nobody listens on the port
+	bool isVacant(quint16 port_) const;
 	const QPair<QHostAddress, quint16>& getServer() const
 	{
 		return m_server;
@@ -414,10 +416,12 @@ struct Subject
 	explicit Subject(const Socat::Launcher& launcher_);
 
 	PRL_RESULT bringUpKeepAlive();
-	PRL_RESULT startStunnel(quint16 begin_, quint16 end_);
+	PRL_RESULT startStunnel(quint16 begin_, quint16 end_, quint16 hint_);
 	Tunnel* getResult();
 
 private:
+	PRL_RESULT launch(quint16 port_);
+
 	quint16 m_accept;
 	Socat::Launcher m_launcher;
 	QScopedPointer<QProcess, Sweeper> m_stunnel;
@@ -474,7 +478,7 @@ struct Script
 	Script(const subject_type& subject_, const range_type& input_,
 		const configure_type& commit_):
 		m_commit(commit_), m_subject(subject_), m_setup(input_),
-		m_sweepMode()
+		m_hint(), m_sweepMode()
 	{
 	}
 
@@ -483,11 +487,17 @@ struct Script
 	{
 		m_sweepMode = value_;
 	}
+	// the port used last time, it is tried first
+	void setHint(quint16 value_)
+	{
+		m_hint = value_;
+	}
 
 private:
 	configure_type m_commit;
 	subject_type m_subject;
 	range_type m_setup;
+	quint16 m_hint;
 	PRL_VM_REMOTE_DISPLAY_MODE m_sweepMode;
 };
 
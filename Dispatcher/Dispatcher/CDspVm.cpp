@@ -35,6 +35,7 @@
 
 #include "CDspVm.h"
 #include "CDspVm_p.h"
+#include "CDspVmUptime.h"
 #include "CDspService.h"
 #include "CDspHandlerRegistrator.h"
 #include "CDspClientManager.h"
@@ -237,6 +238,7 @@ void CDspVmBaseHelper::cleanupObjects()
 
 Storage* CDspVm::g_pStorage = new Storage;
 QReadWriteLock *CDspVm::g_pVmsMapLock = new QReadWriteLock;
+DspVm::Uptime *CDspVm::g_pUptime = new DspVm::Uptime;
 
 void CDspVm::UnregisterVmObject(const SmartPtr<CDspVm> &pVm)
 {
@@ -440,6 +442,11 @@ void CDspVm::updateVmUptime()
 	}
 }
 
+DspVm::Uptime& CDspVm::getUptimeStore()
+{
+	return *g_pUptime;
+}
+
 /**
  * Resets uptime for VM process
  */
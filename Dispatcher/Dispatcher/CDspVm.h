@@ -104,6 +104,7 @@ namespace DspVm
 {
 struct Details;
 struct Storage;
+struct Uptime;
 namespace Start
 {
 struct Demand;
@@ -259,6 +260,11 @@ public:
 	 */
 	void updateVmUptime();
 
+	/**
+	 * Host store of VM uptime that is not folded into configs yet
+	 */
+	static DspVm::Uptime& getUptimeStore();
+
 	/**
 	 * Change VM state to VMS_COMPACTING
 	 */
@@ -409,6 +415,8 @@ private://Global VM wrappers objects map
 	static DspVm::Storage* g_pStorage;
 	/** Global VM wrappers objects map access synchronization object */
 	static QReadWriteLock *g_pVmsMapLock;
+	/** Global store of VM uptime not folded into configs */
+	static DspVm::Uptime* g_pUptime;
 
 private:
 	SmartPtr<DspVm::Details> m_pDetails;
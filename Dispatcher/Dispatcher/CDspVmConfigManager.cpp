@@ -35,7 +35,21 @@
 #include "CDspVmConfigManager.h"
 #include <QReadLocker>
 #include <QWriteLocker>
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#ifdef _LIN_
+#include <errno.h>
+#include <string.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/xattr.h>
+#include <unistd.h>
+#endif // _LIN_
 #include "CDspVmDirManager.h"
+#include "Stat/CDspStatStorage.h"
 #include "CDspService.h"
 #include "CDspVmDirHelper.h"
 #include "CDspVNCStarter_p.h"
@@ -64,6 +78,16 @@ QString getVmHomeDirName(const QString& uuid_)
 	return Uuid(uuid_).toStringWithoutBrackets();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Security
+
+Security::Security(const CVmConfiguration& config_):
+	m_vmUuid(config_.getVmIdentification()->getVmUuid()),
+	m_serverUuid(config_.getVmIdentification()->getServerUuid()),
+	m_template(config_.getVmSettings()->getVmCommonOptions()->isTemplate())
+{
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct MemGuarantee
 
@@ -578,6 +602,20 @@ struct Work
 
 		return PRL_ERR_SUCCESS;
 	}
+	PRL_RESULT serialise(bool saveRelativePath, QByteArray& dst_) const
+	{
+		SmartPtr<CVmConfiguration> x = m_config;
+		if (saveRelativePath)
+		{
+			x = SmartPtr<CVmConfiguration>(new CVmConfiguration(m_config.getImpl()));
+			x->setRelativePath();
+		}
+		QBuffer b(&dst_);
+		if (!b.open(QIODevice::WriteOnly))
+			return PRL_ERR_FAILURE;
+
+		return x->saveToFile(&b);
+	}
 
 private:
 	QString m_path;
@@ -739,6 +777,14 @@ void Backup::operator()(bool replace_, bool saveRelative_) const
 
 bool Backup::prepareTarget() const
 {
+#ifdef _LIN_
+	// after a failed rotation the backup is a hard link of the config, an
+	// in place write into it would modify both
+	struct stat b, c;
+	if (0 == ::stat(QSTR2UTF8(m_path), &b) && 0 == ::stat(QSTR2UTF8(m_work->getPath()), &c)
+		&& b.st_dev == c.st_dev && b.st_ino == c.st_ino)
+		QFile::remove(m_path);
+#endif // _LIN_
 	if (!QFile::exists(m_path) && !CFileHelper::CreateBlankFile(m_path, m_work->getAuth()))
 	{
 		WRITE_TRACE(DBG_FATAL, "Cannot prepare blank file for VM config backup file '%s'!",
@@ -753,6 +799,182 @@ bool Backup::prepareTarget() const
 	return true;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Rotation
+// Writes the serialised document next to the config and swaps it in. The
+// replaced config stays as the backup: its inode gets the backup name
+// before the swap, thus the backup is a separate file again afterwards and
+// costs no second write. PRL_ERR_UNIMPLEMENTED means the plain write should
+// be used.
+
+struct Rotation
+{
+	explicit Rotation(const Work& work_):
+		m_work(&work_), m_backup(Backup::getPath(work_)),
+		m_temporary(work_.getPath() + ".tmp")
+	{
+	}
+
+	PRL_RESULT operator()(const QByteArray& document_) const;
+
+private:
+	bool inherit() const;
+	bool inheritAttributes() const;
+	bool write(const QByteArray& document_) const;
+	bool keep() const;
+	void sync() const;
+
+	const Work* m_work;
+	const QString m_backup;
+	const QString m_temporary;
+};
+
+PRL_RESULT Rotation::operator()(const QByteArray& document_) const
+{
+#ifdef _LIN_
+	if (!QFile::exists(m_work->getPath()))
+		return PRL_ERR_UNIMPLEMENTED;
+
+	if (!write(document_) || !inherit())
+	{
+		QFile::remove(m_temporary);
+		return PRL_ERR_UNIMPLEMENTED;
+	}
+	// the config is committed anyway, a missing backup is not fatal
+	keep();
+	if (0 != ::rename(QSTR2UTF8(m_temporary), QSTR2UTF8(m_work->getPath())))
+	{
+		WRITE_TRACE(DBG_FATAL, "Cannot replace VM config file '%s': %s",
+			QSTR2UTF8(m_work->getPath()), strerror(errno));
+		QFile::remove(m_temporary);
+		return PRL_ERR_SAVE_VM_CONFIG;
+	}
+	sync();
+	return PRL_ERR_SUCCESS;
+#else // _LIN_
+	Q_UNUSED(document_);
+	return PRL_ERR_UNIMPLEMENTED;
+#endif // _LIN_
+}
+
+bool Rotation::write(const QByteArray& document_) const
+{
+	QFile f(m_temporary);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		WRITE_TRACE(DBG_FATAL, "Cannot open temporary VM config file '%s': %s",
+			QSTR2UTF8(m_temporary), QSTR2UTF8(f.errorString()));
+		return false;
+	}
+	if (f.write(document_) != document_.size() || !f.flush())
+	{
+		WRITE_TRACE(DBG_FATAL, "Cannot write temporary VM config file '%s': %s",
+			QSTR2UTF8(m_temporary), QSTR2UTF8(f.errorString()));
+		return false;
+	}
+#ifdef _LIN_
+	// the data must reach the disk before the name does
+	if (0 != ::fsync(f.handle()))
+	{
+		WRITE_TRACE(DBG_FATAL, "Cannot sync temporary VM config file '%s': %s",
+			QSTR2UTF8(m_temporary), strerror(errno));
+		return false;
+	}
+#endif // _LIN_
+	return true;
+}
+
+bool Rotation::keep() const
+{
+#ifdef _LIN_
+	// link the current config under a spare name and swap it in, so that
+	// there is no moment without a backup
+	QString x = m_backup + ".tmp";
+	QFile::remove(x);
+	if (0 == ::link(QSTR2UTF8(m_work->getPath()), QSTR2UTF8(x))
+		&& 0 == ::rename(QSTR2UTF8(x), QSTR2UTF8(m_backup)))
+		return true;
+
+	WRITE_TRACE(DBG_FATAL, "Cannot keep VM config backup file '%s': %s",
+		QSTR2UTF8(m_backup), strerror(errno));
+	QFile::remove(x);
+#endif // _LIN_
+	return false;
+}
+
+void Rotation::sync() const
+{
+#ifdef _LIN_
+	// make both renames durable
+	QString d = QFileInfo(m_work->getPath()).absolutePath();
+	int x = ::open(QSTR2UTF8(d), O_RDONLY | O_DIRECTORY);
+	if (0 > x || 0 != ::fsync(x))
+	{
+		WRITE_TRACE(DBG_FATAL, "Cannot sync VM config directory '%s': %s",
+			QSTR2UTF8(d), strerror(errno));
+	}
+	if (0 <= x)
+		::close(x);
+#endif // _LIN_
+}
+
+bool Rotation::inherit() const
+{
+#ifdef _LIN_
+	// the config keeps its owner, mode, ACLs and other extended attributes
+	// as the plain write does
+	struct stat x;
+	if (0 != ::stat(QSTR2UTF8(m_work->getPath()), &x))
+		return false;
+	if (0 != ::chown(QSTR2UTF8(m_temporary), x.st_uid, x.st_gid))
+		return false;
+	if (0 != ::chmod(QSTR2UTF8(m_temporary), x.st_mode & 07777))
+		return false;
+
+	return inheritAttributes();
+#else // _LIN_
+	return false;
+#endif // _LIN_
+}
+
+bool Rotation::inheritAttributes() const
+{
+#ifdef _LIN_
+	QByteArray s = m_work->getPath().toUtf8(), t = m_temporary.toUtf8();
+	ssize_t n = ::listxattr(s.constData(), NULL, 0);
+	if (0 > n)
+		return ENOTSUP == errno;
+	if (0 == n)
+		return true;
+
+	QByteArray a(n, 0);
+	n = ::listxattr(s.constData(), a.data(), a.size());
+	if (0 > n)
+		return false;
+
+	// the names are separated by zeroes, system.posix_acl_access is one
+	// of them when the config has an ACL
+	for (const char* p = a.constData(); p < a.constData() + n; p += qstrlen(p) + 1)
+	{
+		ssize_t z = ::getxattr(s.constData(), p, NULL, 0);
+		if (0 > z)
+			return false;
+
+		QByteArray v(z, 0);
+		z = ::getxattr(s.constData(), p, v.data(), v.size());
+		if (0 > z || 0 != ::setxattr(t.constData(), p, v.constData(), z, 0))
+		{
+			WRITE_TRACE(DBG_FATAL, "Cannot copy attribute %s of VM config file '%s': %s",
+				p, s.constData(), strerror(errno));
+			return false;
+		}
+	}
+	return true;
+#else // _LIN_
+	return false;
+#endif // _LIN_
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Restore
 
@@ -877,6 +1099,57 @@ PRL_RESULT Restore::prepareTarget()
 	return PRL_ERR_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Digest
+
+Digest::value_type Digest::make(const QByteArray& document_)
+{
+	return QCryptographicHash::hash(document_, QCryptographicHash::Sha1);
+}
+
+bool Digest::match(const QString& path_, const value_type& value_) const
+{
+	QMutexLocker l(&m_mutex);
+	QHash<QString, entry_type>::const_iterator p = m_map.find(path_);
+	if (m_map.constEnd() == p || p.value().first != value_)
+		return false;
+
+	QString s = p.value().second;
+	l.unlock();
+	return !s.isEmpty() && getStamp(path_) == s;
+}
+
+void Digest::remember(const QString& path_, const value_type& value_)
+{
+	QString s = getStamp(path_);
+	QMutexLocker l(&m_mutex);
+	m_map.insert(path_, entry_type(value_, s));
+}
+
+void Digest::forget(const QString& path_)
+{
+	QMutexLocker l(&m_mutex);
+	m_map.remove(path_);
+}
+
+QString Digest::getStamp(const QString& path_)
+{
+#ifdef _LIN_
+	struct stat x;
+	if (0 != ::stat(QSTR2UTF8(path_), &x))
+		return QString();
+
+	return QString("%1:%2.%3:%4").arg(x.st_ino).arg(x.st_mtim.tv_sec)
+		.arg(x.st_mtim.tv_nsec).arg(x.st_size);
+#else // _LIN_
+	QFileInfo x(path_);
+	if (!x.exists())
+		return QString();
+
+	return QString("%1:%2").arg(x.lastModified().toMSecsSinceEpoch()).arg(x.size());
+#endif // _LIN_
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Mixed
 
@@ -884,6 +1157,11 @@ Mixed::Mixed(): Base(new Cache<CVmConfiguration>())
 {
 }
 
+void Mixed::count(const char* counter_)
+{
+	::Stat::Counters::add(QString("vm.config.") + counter_, 1);
+}
+
 PRL_RESULT Mixed::load(Work& dst_, bool direct_)
 {
 	if(!direct_ && dst_.setConfig(getCache()))
@@ -908,21 +1186,51 @@ PRL_RESULT Mixed::load(Work& dst_, bool direct_)
 
 PRL_RESULT Mixed::save(const Work& src_, bool replace_, bool saveRelative_)
 {
-	Backup u(src_);
+	// serialised once for both the digest and the write
+	QByteArray b;
+	PRL_RESULT output = src_.serialise(saveRelative_, b);
+	if (PRL_FAILED(output))
+		return output;
+
+	Digest::value_type d = Digest::make(b);
+	if (m_digest.match(src_.getPath(), d))
+	{
+		count("skipped");
+		src_.save(getCache());
+		return PRL_ERR_SUCCESS;
+	}
+	m_digest.forget(src_.getPath());
+
 	//https://bugzilla.sw.ru/show_bug.cgi?id=267152
 	CAuthHelperImpersonateWrapper _impersonate(src_.getAuth());
-	if (u.prepareTarget())
-		u(replace_, saveRelative_);
+	output = PRL_ERR_UNIMPLEMENTED;
+	if (replace_)
+		output = Rotation(src_)(b);
+
+	if (PRL_ERR_UNIMPLEMENTED == output)
+	{
+		Backup u(src_);
+		if (u.prepareTarget())
+			u(replace_, saveRelative_);
+
+		output = src_.saveConfig(src_.getPath(), replace_, saveRelative_);
+	}
+	else if (PRL_SUCCEEDED(output))
+		count("rotated");
 
-	PRL_RESULT output = src_.saveConfig(src_.getPath(), replace_, saveRelative_);
 	if (PRL_SUCCEEDED(output))
+	{
+		count("saved");
+		m_digest.remember(src_.getPath(), d);
 		src_.save(getCache());
+	}
 
 	return output;
 }
 
 PRL_RESULT Mixed::restore(const Work& unit_, const QString& owner_)
 {
+	m_digest.forget(unit_.getPath());
 	Restore u(unit_);
 	PRL_RESULT e = u.prepareSource();
 	switch (e)
@@ -1016,7 +1324,8 @@ PRL_RESULT Atomic::operator()(const action_type& action_)
 		(m_decorated.getUuid(), d, PVE::DspCmdCtlApplyVmConfig, a);
 	if (PRL_SUCCEEDED(output))
 	{
-		QMutexLocker g(h.getMultiEditDispatcher());
+		CMultiEditDispatcher::CommitLocker g(h.getMultiEditDispatcher(),
+			m_decorated.getUuid());
 		output = m_decorated(action_);
 		g.unlock();
 		h.unregisterExclusiveVmOperation
@@ -1118,7 +1427,7 @@ namespace Trie
 
 struct Node
 {
-	Vm::Config::Access::Base* find(QStringList& path_) const;
+	QSharedPointer<Vm::Config::Access::Base> find(QStringList& path_) const;
 	void set(QStringList& path_, Vm::Config::Access::Base* data_)
 	{
 		if (path_.isEmpty())
@@ -1135,7 +1444,7 @@ private:
 	QSharedPointer<Vm::Config::Access::Base> m_data;
 };
 
-Vm::Config::Access::Base* Node::find(QStringList& path_) const
+QSharedPointer<Vm::Config::Access::Base> Node::find(QStringList& path_) const
 {
 	do
 	{
@@ -1146,12 +1455,12 @@ Vm::Config::Access::Base* Node::find(QStringList& path_) const
 		if (m_children.end() == p)
 			break;
 		path_.pop_front();
-		Vm::Config::Access::Base* x = p.value().find(path_);
-		if (NULL != x)
+		QSharedPointer<Vm::Config::Access::Base> x = p.value().find(path_);
+		if (!x.isNull())
 			return x;
 	} while(false);
 
-	return m_data.data();
+	return m_data;
 }
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -1163,10 +1472,11 @@ struct Root: private Node
 	{
 	}
 
-	Vm::Config::Access::Base& get(const QString& path_) const
+	QSharedPointer<Vm::Config::Access::Base> get(const QString& path_) const
 	{
 		QStringList x = getElements(path_);
-		return *(find(x) ? : m_default.data());
+		QSharedPointer<Vm::Config::Access::Base> output = find(x);
+		return output.isNull() ? m_default : output;
 	}
 	bool set(const QString& path_, Vm::Config::Access::Base* data_)
 	{
@@ -1198,7 +1508,7 @@ private:
 		return output;
 	}
 
-	QScopedPointer<Vm::Config::Access::Base> m_default;
+	QSharedPointer<Vm::Config::Access::Base> m_default;
 };
 
 } // namespace Trie
@@ -1217,8 +1527,98 @@ CDspVmConfigManager::~CDspVmConfigManager(void)
 
 void CDspVmConfigManager::removeFromCache( const QString& path)
 {
-	QWriteLocker locker(&m_mtxAccessLocker);
-	m_trie->get(path).forget(Vm::Config::Access::Work(path, SmartPtr<CDspClient>()));
+	QSharedPointer<Vm::Config::Access::Base> a = getAccess(path);
+	QWriteLocker locker(&getFileLock(path));
+	a->forget(Vm::Config::Access::Work(path, SmartPtr<CDspClient>()));
+	forgetSecurity(path);
+	locker.unlock();
+	// the directory may be moved or removed along with the VM
+	QMutexLocker g(&m_canonicalLocker);
+	m_canonical.remove(QFileInfo(path).absolutePath());
+}
+
+QSharedPointer<Vm::Config::Access::Base> CDspVmConfigManager::getAccess( const QString& path )
+{
+	QReadLocker locker(&m_mtxAccessLocker);
+	return m_trie->get(path);
+}
+
+QReadWriteLock& CDspVmConfigManager::getFileLock( const QString& path )
+{
+	// different spellings of one file must share the stripe. the directory
+	// is resolved instead of the file for a config being created has none
+	QFileInfo i(path);
+	QString d = i.absolutePath();
+	QMutexLocker g(&m_canonicalLocker);
+	QString x = m_canonical.value(d);
+	g.unlock();
+	if (x.isEmpty())
+	{
+		x = QFileInfo(d).canonicalFilePath();
+		// a missing directory is not remembered, it may appear later
+		if (!x.isEmpty())
+		{
+			g.relock();
+			if (m_canonical.size() >= CANONICAL_CACHE_MAX)
+				m_canonical.clear();
+
+			m_canonical.insert(d, x);
+		}
+	}
+	x = x.isEmpty() ? QDir::cleanPath(i.absoluteFilePath()) : x + "/" + i.fileName();
+#ifdef _WIN_
+	x = x.toLower();
+#endif // _WIN_
+	return m_fileLocks[qHash(x) % FILE_LOCK_STRIPES];
+}
+
+PRL_RESULT CDspVmConfigManager::getSecurity( Vm::Config::Security& dst,
+											const QString& config_file,
+											SmartPtr<CDspClient> pUserSession )
+{
+	if (CDspDispConfigGuard::isConfigCacheEnabled())
+	{
+		QString u = pUserSession.isValid() ? pUserSession->getUserName() : QString();
+		// no commit may slip between the stamp and the lookup
+		QReadLocker f(&getFileLock(config_file));
+		QString t = Vm::Config::Access::Digest::getStamp(config_file);
+		QReadLocker g(&m_securityLocker);
+		securityEntry_type x = m_security.value(config_file).value(u);
+		if (!t.isEmpty() && x.first == t)
+		{
+			dst = x.second;
+			return PRL_ERR_SUCCESS;
+		}
+	}
+	SmartPtr<CVmConfiguration> x;
+	PRL_RESULT e = loadConfig(x, config_file, pUserSession);
+	if (PRL_FAILED(e))
+		return e;
+
+	dst = Vm::Config::Security(*x);
+	return PRL_ERR_SUCCESS;
+}
+
+void CDspVmConfigManager::updateSecurity( const QString& path, const QString& stamp,
+										const SmartPtr<CDspClient>& session,
+										const SmartPtr<CVmConfiguration>& config, bool exclusive )
+{
+	if (!config.isValid() || !CDspDispConfigGuard::isConfigCacheEnabled())
+		return forgetSecurity(path);
+
+	securityEntry_type x(stamp, Vm::Config::Security(*config));
+	QString u = session.isValid() ? session->getUserName() : QString();
+	QWriteLocker g(&m_securityLocker);
+	if (exclusive)
+		m_security.remove(path);
+
+	m_security[path].insert(u, x);
+}
+
+void CDspVmConfigManager::forgetSecurity( const QString& path )
+{
+	QWriteLocker g(&m_securityLocker);
+	m_security.remove(path);
 }
 
 /**
@@ -1235,13 +1635,21 @@ PRL_RESULT CDspVmConfigManager::loadConfig( SmartPtr<CVmConfiguration>& pConfig,
 											bool BNeedLoadAbsolutePath,
 											bool bLoadDirectlyFromDisk )
 {
-	QReadLocker locker(&m_mtxAccessLocker);
+	QSharedPointer<Vm::Config::Access::Base> a = getAccess(strFileName);
+	QReadLocker locker(&getFileLock(strFileName));
+	// stamp before the read: a change by another node in between makes the
+	// descriptor look outdated rather than the other way round
+	QString t = Vm::Config::Access::Digest::getStamp(strFileName);
 	Vm::Config::Access::Work w(strFileName, pUserSession);
-	PRL_RESULT e = m_trie->get(strFileName).load(w, bLoadDirectlyFromDisk);
+	PRL_RESULT e = a->load(w, bLoadDirectlyFromDisk);
 	if (PRL_FAILED(e))
+	{
+		forgetSecurity(strFileName);
 		return e;
+	}
 
 	pConfig = w.getConfig();
+	updateSecurity(strFileName, t, pUserSession, pConfig, false);
 	if (!BNeedLoadAbsolutePath)
 		pConfig->setRelativePath();
 
@@ -1268,8 +1676,17 @@ PRL_RESULT CDspVmConfigManager::saveConfig( SmartPtr<CVmConfiguration> pConfig,
 	Vm::Config::Access::Work w(config_file, pUserSession);
 	w.setConfig(pConfig);
 	WRITE_TRACE(DBG_DEBUG, "about to save VM config into %s", qPrintable(config_file));
-	QWriteLocker locker(&m_mtxAccessLocker);
-	return m_trie->get(config_file).save(w, do_replace, BNeedToSaveRelativePath);
+	QSharedPointer<Vm::Config::Access::Base> a = getAccess(config_file);
+	QWriteLocker locker(&getFileLock(config_file));
+	PRL_RESULT output = a->save(w, do_replace, BNeedToSaveRelativePath);
+	if (PRL_SUCCEEDED(output))
+	{
+		// the descriptors of the other users are outdated now
+		updateSecurity(config_file, Vm::Config::Access::Digest::getStamp(config_file),
+			pUserSession, pConfig, true);
+	}
+
+	return output;
 }
 
 /**
@@ -1285,8 +1702,10 @@ PRL_RESULT CDspVmConfigManager::restoreConfig(const QString& config_file,
 	PRL_RESULT output = PRL_ERR_SUCCESS;
 	{
 		Vm::Config::Access::Work w(config_file, pUserSession);
-		QWriteLocker locker(&m_mtxAccessLocker);
-		output = m_trie->get(config_file).restore(w, owner);
+		QSharedPointer<Vm::Config::Access::Base> a = getAccess(config_file);
+		QWriteLocker locker(&getFileLock(config_file));
+		output = a->restore(w, owner);
+		forgetSecurity(config_file);
 	}
 	if (PRL_FAILED(output))
 	{
@@ -1305,25 +1724,18 @@ PRL_RESULT CDspVmConfigManager::restoreConfig(const QString& config_file,
 */
 bool CDspVmConfigManager::canConfigRestore( const QString& config_file, SmartPtr<CDspClient> pUserSession )
 {
-	QWriteLocker locker(&m_mtxAccessLocker);
+	QSharedPointer<Vm::Config::Access::Base> a = getAccess(config_file);
+	QReadLocker locker(&getFileLock(config_file));
 	Vm::Config::Access::Work w(config_file, pUserSession);
-	return m_trie->get(config_file).canRestore(w);
-}
-
-SmartPtr<QWriteLocker> CDspVmConfigManager::lockOnWrite()
-{
-	return SmartPtr<QWriteLocker>( new QWriteLocker(&m_mtxAccessLocker) );
-}
-
-SmartPtr<QReadLocker> CDspVmConfigManager::lockOnRead()
-{
-	return SmartPtr<QReadLocker>( new QReadLocker(&m_mtxAccessLocker) );
+	return a->canRestore(w);
 }
 
 PRL_RESULT CDspVmConfigManager::adopt
 	(const QString& path_, Vm::Config::Access::Base* access_)
 {
+	// a commit in progress completes with the access it has started with
 	QWriteLocker locker(&m_mtxAccessLocker);
+	forgetSecurity(path_);
 	if (m_trie->set(path_, access_))
 		return PRL_ERR_SUCCESS;
 
@@ -38,6 +38,7 @@
 #include <prlcommon/Std/SmartPtr.h>
 #include "Dispatcher/Dispatcher/Cache/Cache.h"
 #include <QReadWriteLock>
+#include <QMutex>
 #include <QHash>
 #include <QObject>
 #include <QVector>
@@ -65,6 +66,36 @@ namespace Config
 
 QString getVmHomeDirName(const QString& uuid_);
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Security
+// Compact part of a VM config required to authorise commands to the VM
+
+struct Security
+{
+	Security(): m_template()
+	{
+	}
+	explicit Security(const CVmConfiguration& config_);
+
+	const QString& getVmUuid() const
+	{
+		return m_vmUuid;
+	}
+	const QString& getServerUuid() const
+	{
+		return m_serverUuid;
+	}
+	bool isTemplate() const
+	{
+		return m_template;
+	}
+
+private:
+	QString m_vmUuid;
+	QString m_serverUuid;
+	bool m_template;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct MemGuarantee
 
@@ -457,6 +488,29 @@ struct Subject: Base
 
 } // namespace InMemory
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Digest
+// Hashes of the documents last persisted per path along with the stamps of
+// the written files. A document matches only while the file is untouched.
+
+struct Digest
+{
+	typedef QByteArray value_type;
+
+	static value_type make(const QByteArray& document_);
+	bool match(const QString& path_, const value_type& value_) const;
+	void remember(const QString& path_, const value_type& value_);
+	void forget(const QString& path_);
+	// the inode, the mtime with its full resolution and the size
+	static QString getStamp(const QString& path_);
+
+private:
+	typedef QPair<value_type, QString> entry_type;
+
+	mutable QMutex m_mutex;
+	QHash<QString, entry_type> m_map;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Mixed
 
@@ -468,6 +522,12 @@ struct Mixed: Base
 	PRL_RESULT save(const Work& src_, bool replace_, bool saveRelative_);
 	PRL_RESULT restore(const Work& unit_, const QString& owner_);
 	bool canRestore(const Work& unit_) const;
+
+private:
+	// the dispatcher counters vm.config.{saved,skipped,rotated}
+	static void count(const char* counter_);
+
+	Digest m_digest;
 };
 
 } // namespace Access
@@ -641,10 +701,15 @@ public:
 	void removeFromCache( const QString& path );
 
 	/**
-	 * Helper lock functions for specific logic of working with VM configs
-	 */
-	SmartPtr<QWriteLocker> lockOnWrite();
-	SmartPtr<QReadLocker> lockOnRead();
+	* @brief Get the security descriptor of the config. The config is
+	* loaded only if the descriptor of the user is unknown yet or the file
+	* changed since, then the descriptor is kept up to date by loads and
+	* commits of the config. Nothing is kept when the config cache is off,
+	* i.e. on a shared storage.
+	*/
+	PRL_RESULT getSecurity( Vm::Config::Security& dst,
+							const QString& config_file,
+							SmartPtr<CDspClient> pUserSession );
 
 	template <typename T>
 	PRL_RESULT modifyConfig(const QString& path,
@@ -695,13 +760,36 @@ public:
 	}
 
 	PRL_RESULT adopt(const QString& path_, Vm::Config::Access::Base* access_);
+
 private:
-	// FIXME: May be need implement lock for every config exclude common lock
-	// mutex for lock access from other thread
+	enum
+	{
+		FILE_LOCK_STRIPES = 64,
+		CANONICAL_CACHE_MAX = 4096
+	};
+
+	typedef QPair<QString, Vm::Config::Security> securityEntry_type;
+
+	void updateSecurity( const QString& path, const QString& stamp,
+						const SmartPtr<CDspClient>& session,
+						const SmartPtr<CVmConfiguration>& config, bool exclusive );
+	void forgetSecurity( const QString& path );
+	QSharedPointer<Vm::Config::Access::Base> getAccess( const QString& path );
+	QReadWriteLock& getFileLock( const QString& path );
+
+	// guards the trie only, config files are guarded by the stripes
 	QReadWriteLock	m_mtxAccessLocker;
+	QReadWriteLock	m_fileLocks[FILE_LOCK_STRIPES];
+	// config directory -> its resolved path, saves the symlink walk
+	QMutex m_canonicalLocker;
+	QHash<QString, QString> m_canonical;
 
 	CHardDiskConfigCache m_HardDiskCache;
 	QScopedPointer<Trie::Root> m_trie;
+
+	QReadWriteLock m_securityLocker;
+	// path -> user -> (file stamp, descriptor)
+	QHash<QString, QHash<QString, securityEntry_type> > m_security;
 };
 
 #endif // CDSP_VM_CONFIG_ACCESS_SYNCH_H
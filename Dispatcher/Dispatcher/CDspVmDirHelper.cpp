@@ -56,6 +56,7 @@
 #include "CDspClientManager.h"
 #include "CDspSync.h"
 #include "CDspVm.h"
+#include "CDspVmUptime.h"
 #include "CDspVmStateSender.h"
 #include "CDspVNCStarter_p.h"
 #include <prlxmlmodel/DispConfig/CDispUser.h>
@@ -3016,12 +3017,11 @@ void CDspVmDirHelper::appendAdvancedParamsToVmConfig(
 
 	//Update VM uptime
 	//https://bugzilla.sw.ru/show_bug.cgi?id=464218
-    SmartPtr<CDspVm> pVm = CDspVm::GetVmInstanceByUuid(ident);
-	if ( pVm )
-		pOutVmConfig->getVmIdentification()->setVmUptimeInSeconds(
-			pOutVmConfig->getVmIdentification()->getVmUptimeInSeconds() +
-			pVm->getVmUptimeInSecs()
-		);
+	//Uptime of a running VM is folded into the config on stop only
+	pOutVmConfig->getVmIdentification()->setVmUptimeInSeconds(
+		pOutVmConfig->getVmIdentification()->getVmUptimeInSeconds() +
+		CDspVm::getUptimeStore().get(ident.first)
+	);
 
 	if (pOutVmConfig->getVmSettings()->getVmRemoteDisplay() &&
 		pOutVmConfig->getVmSettings()->getVmRemoteDisplay()->getMode() == PRD_DISABLED)
@@ -3105,8 +3105,12 @@ PRL_RESULT CDspVmDirHelper::UpdateHardDiskInformation(SmartPtr<CVmConfiguration>
 	if (pConfig->getVmSettings()->getVmCommonOptions()->isTemplate())
 		return PRL_ERR_SUCCESS;
 
-	QSharedPointer< ::Stat::Storage> s = m_registry.find(pConfig->getVmIdentification()->getVmUuid())
-		.getStorage();
+	QString u = pConfig->getVmIdentification()->getVmUuid();
+	// the sizes are sampled by the libvirt miner for known readers only.
+	// after a long pause the values are old until the next miner round
+	// that samples the newly leased VMs first
+	::Stat::Demand::lease(u, ::Stat::Demand::BLOCK);
+	QSharedPointer< ::Stat::Storage> s = m_registry.find(u).getStorage();
 	if (s.isNull())
 		return PRL_ERR_INVALID_HANDLE;
 
@@ -34,6 +34,7 @@
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
 #include <prlcommon/HostUtils/HostUtils.h>
 #include "CDspVmNetworkHelper.h"
+#include "CDspExecutor.h"
 #include <libvirt/virterror.h>
 
 namespace Vm {
@@ -104,7 +105,7 @@ void Watcher::timerEvent(QTimerEvent *ev_)
 	--m_retries;
 	QRunnable* q = new Spin(m_ident, *this);
 	q->setAutoDelete(true);
-	QThreadPool::globalInstance()->start(q);
+	Executor::get(Executor::GUEST).start(q);
 }
 
 void Watcher::adopt(PRL_VM_TOOLS_STATE state_, const QString& version_)
@@ -148,6 +149,7 @@ void Spin::run()
 		Libvirt::Kit.vms().at(m_ident.first).getGuest().getAgentVersion(0);
 	if (r.isSucceed())
 	{
+		Breaker::instance().pass(m_ident.first);
 		// emit or smth.
 		WRITE_TRACE(DBG_INFO, "%s spin tools installed %s",
 			qPrintable(m_ident.first), qPrintable(r.value()));
@@ -167,6 +169,7 @@ void Spin::run()
 			// agent is not started - retry 10 minutes with 20 secs interval
 			WRITE_TRACE(DBG_INFO, "%s Spin::run agent not responed",
 				qPrintable(m_ident.first));
+			Breaker::instance().trip(m_ident.first);
 			s = PTS_POSSIBLY_INSTALLED;
 		default:
 			WRITE_TRACE(DBG_INFO, "%s Spin::run retry %d errcode %d",
@@ -184,6 +187,147 @@ void Spin::run()
 	m_watcher->deleteLater();
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Breaker
+
+bool Breaker::isOpen(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Entry>::const_iterator p = m_data.constFind(uuid_);
+	if (m_data.constEnd() == p || !p->m_until.isValid())
+		return false;
+
+	return QDateTime::currentDateTimeUtc() < p->m_until;
+}
+
+void Breaker::pass(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	Entry& e = m_data[uuid_];
+	if (0 < e.m_failures)
+		WRITE_TRACE(DBG_INFO, "%s guest agent is responsive again", qPrintable(uuid_));
+
+	e.m_failures = 0;
+	e.m_until = QDateTime();
+	e.m_good = QDateTime::currentDateTimeUtc();
+}
+
+void Breaker::trip(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	Entry& e = m_data[uuid_];
+	int c = COOLDOWN_MIN << qMin(e.m_failures++, 7);
+	c = qMin<int>(c, COOLDOWN_MAX);
+	e.m_until = QDateTime::currentDateTimeUtc().addSecs(c);
+	WRITE_TRACE(DBG_INFO, "%s guest agent failed %d time(s) in a row, leave it alone for %d s",
+		qPrintable(uuid_), e.m_failures, c);
+}
+
+void Breaker::forget(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	m_data.remove(uuid_);
+}
+
+qint64 Breaker::getStaleness(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Entry>::const_iterator p = m_data.constFind(uuid_);
+	if (m_data.constEnd() == p)
+		return -1;
+	if (0 == p->m_failures)
+		return 0;
+	if (!p->m_good.isValid())
+		return -1;
+
+	return p->m_good.secsTo(QDateTime::currentDateTimeUtc());
+}
+
+Breaker& Breaker::instance()
+{
+	static Breaker s_instance;
+	return s_instance;
+}
+
+namespace Network
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Cache
+
+bool Cache::find(const QString& uuid_, const QByteArray& stamp_, Snapshot& dst_, bool& stale_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Snapshot>::const_iterator p = m_data.constFind(uuid_);
+	if (m_data.constEnd() == p || !p->age.isValid() || p->stamp != stamp_ ||
+		p->age.hasExpired(p->ttl))
+		return false;
+
+	dst_ = p.value();
+	stale_ = p->age.hasExpired(p->ttl / 2);
+	return true;
+}
+
+bool Cache::lease(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	Snapshot& x = m_data[uuid_];
+	if (x.busy)
+		return false;
+
+	return x.busy = true;
+}
+
+void Cache::update(const QString& uuid_, const QByteArray& stamp_,
+	const QByteArray& data_, int exitcode_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Snapshot>::iterator p = m_data.find(uuid_);
+	if (m_data.end() == p)
+		return;
+
+	Snapshot& x = p.value();
+	if (x.stamp == stamp_ && x.data == data_ && x.exitcode == exitcode_)
+		x.ttl = qMin<int>(x.ttl * 2, Snapshot::TTL_MAX);
+	else
+		x.ttl = Snapshot::TTL_MIN;
+
+	x.stamp = stamp_;
+	x.data = data_;
+	x.exitcode = exitcode_;
+	x.age.start();
+	x.busy = false;
+}
+
+void Cache::release(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Snapshot>::iterator p = m_data.find(uuid_);
+	if (m_data.end() != p)
+		p->busy = false;
+}
+
+void Cache::drop(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	QHash<QString, Snapshot>::iterator p = m_data.find(uuid_);
+	if (m_data.end() != p && !p->busy)
+		m_data.erase(p);
+}
+
+void Cache::forget(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	m_data.remove(uuid_);
+}
+
+Cache& Cache::instance()
+{
+	static Cache s_instance;
+	return s_instance;
+}
+
+} // namespace Network
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Connector
 
@@ -35,6 +35,10 @@
 
 #include "CDspVmGuest_p.h"
 
+#include <QHash>
+#include <QMutex>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <prlsdk/PrlEnums.h>
 #include <prlxmlmodel/VmConfig/CVmConfiguration.h>
 
@@ -130,6 +134,104 @@ private:
 	Watcher* m_watcher;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Breaker
+// Guest agent health shared by all the probes of a VM. An agent that failed
+// is not asked again until a cool down passes, thus a hung guest does not pin
+// the pool threads over and over.
+
+struct Breaker
+{
+	enum
+	{
+		// seconds
+		COOLDOWN_MIN = 30,
+		COOLDOWN_MAX = 3600
+	};
+
+	bool isOpen(const QString& uuid_);
+	void pass(const QString& uuid_);
+	void trip(const QString& uuid_);
+	void forget(const QString& uuid_);
+	// seconds since the last good answer while the agent fails, 0 while it
+	// answers, -1 if it is unknown
+	qint64 getStaleness(const QString& uuid_);
+
+	static Breaker& instance();
+
+private:
+	struct Entry
+	{
+		Entry(): m_failures()
+		{
+		}
+
+		int m_failures;
+		QDateTime m_good;
+		QDateTime m_until;
+	};
+
+	QMutex m_mutex;
+	QHash<QString, Entry> m_data;
+};
+
+namespace Network
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Snapshot
+// The last prl_nettool answer of a guest. It is served while fresh and is
+// refreshed in the background when it ages. An answer that does not change
+// lives longer, a changed one resets the interval. No answer older than
+// TTL_MAX is ever served.
+
+struct Snapshot
+{
+	enum
+	{
+		// milliseconds
+		TTL_MIN = 2000,
+		TTL_MAX = 10000
+	};
+
+	Snapshot(): exitcode(), ttl(TTL_MIN), busy()
+	{
+	}
+
+	QByteArray stamp;
+	QByteArray data;
+	int exitcode;
+	int ttl;
+	QElapsedTimer age;
+	bool busy;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Cache
+
+struct Cache
+{
+	// false if there is no fresh answer, stale_ tells to refresh it
+	bool find(const QString& uuid_, const QByteArray& stamp_, Snapshot& dst_, bool& stale_);
+	// true if the caller is the one to refresh the answer
+	bool lease(const QString& uuid_);
+	// keeps the answer of the lease holder
+	void update(const QString& uuid_, const QByteArray& stamp_,
+		const QByteArray& data_, int exitcode_);
+	void release(const QString& uuid_);
+	// drops an answer nobody refreshes now
+	void drop(const QString& uuid_);
+	// drops an answer of the gone VM, a refresh in flight is not kept
+	void forget(const QString& uuid_);
+
+	static Cache& instance();
+
+private:
+	QMutex m_mutex;
+	QHash<QString, Snapshot> m_data;
+};
+
+} // namespace Network
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Connector
 
@@ -35,6 +35,7 @@
 
 #include "CDspVmManager.h"
 #include "CDspVmManager_p.h"
+#include "CDspVmUptime.h"
 #include "CDspService.h"
 #include "CDspHandlerRegistrator.h"
 #include "CDspClientManager.h"
@@ -72,7 +73,9 @@
 #include <boost/phoenix/statement.hpp>
 #include <boost/phoenix/core/argument.hpp>
 #include "Libraries/CpuFeatures/CCpuHelper.h"
-#include <QtConcurrent/QtConcurrent>
+#include "CDspExecutor.h"
+#include "CDspVmGuest.h"
+#include <QCryptographicHash>
 
 #ifdef _WIN_
 	#include <process.h>
@@ -122,10 +125,11 @@ const CVmIdent& Scope::getIdent() const
 // struct Context
 
 Context::Context(const SmartPtr<CDspClient>& session_, const SmartPtr<IOPackage>& package_):
-	m_package(package_), m_trace(package_)
+	m_package(package_),
+	m_request(CProtoSerializer::ParseCommand((PVE::IDispatcherCommands)package_->header.type,
+						UTF8_2QSTR(package_->buffers[0].getImpl()))),
+	m_trace(package_, m_request.isValid() ? m_request->GetVmUuid() : QString())
 {
-	m_request = CProtoSerializer::ParseCommand((PVE::IDispatcherCommands)m_package->header.type,
-						UTF8_2QSTR(m_package->buffers[0].getImpl()));
 	PRL_ASSERT(m_request.isValid());
 	PRL_ASSERT(m_request->IsValid());
 	(Scope& )*this = Scope(session_, m_request->GetVmUuid());
@@ -535,7 +539,7 @@ struct Log: T
 	{
 		boost::property_tree::ptree p;
 		p.put("snapshot_uuid", this->getCommand()->GetSnapshotUuid().toStdString());
-		Task::Trace t(this->getContext().getPackage());
+		Task::Trace t(this->getContext().getPackage(), this->getContext().getVmUuid());
 		t.report(p);
 
 		return T::operator()();
@@ -615,7 +619,7 @@ struct Revert: Need::Context, Need::Config, Need::Command<CProtoSwitchToSnapshot
 	{
 		boost::property_tree::ptree p;
 		p.put("snapshot_uuid", getCommand()->GetSnapshotUuid().toStdString());
-		Task::Trace t(getContext().getPackage());
+		Task::Trace t(getContext().getPackage(), getContext().getVmUuid());
 		t.report(p);
 
 		QString h(getConfig()->getVmIdentification()->getHomePath());
@@ -745,19 +749,108 @@ CHostHardwareInfo parsePrlNetToolOut(const QString &data)
 	return h;
 }
 
+namespace Network
+{
+typedef ::Vm::Guest::Network::Snapshot Snapshot;
+typedef ::Vm::Guest::Network::Cache Cache;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Poll
+
+struct Poll
+{
+	typedef Libvirt::Instrument::Agent::Vm::Exec::Request request_type;
+	typedef Prl::Expected<Libvirt::Instrument::Agent::Vm::Exec::Result,
+		Error::Simple> result_type;
+
+	Poll(const Libvirt::Instrument::Agent::Vm::Unit& agent_, const request_type& request_,
+		const QString& uuid_, const QByteArray& stamp_):
+		m_agent(agent_), m_request(request_), m_uuid(uuid_), m_stamp(stamp_)
+	{
+	}
+
+	// runs prl_nettool and keeps its answer. the lease must be taken
+	result_type operator()() const;
+
+private:
+	Libvirt::Instrument::Agent::Vm::Unit m_agent;
+	request_type m_request;
+	QString m_uuid;
+	QByteArray m_stamp;
+};
+
+Poll::result_type Poll::operator()() const
+{
+	result_type output = Libvirt::Instrument::Agent::Vm::Unit(m_agent)
+		.getGuest().runProgram(m_request);
+	if (output.isFailed() || output.value().stdOut.isEmpty())
+		Cache::instance().release(m_uuid);
+	else
+	{
+		Cache::instance().update(m_uuid, m_stamp, output.value().stdOut,
+			output.value().exitcode);
+	}
+	return output;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Refresh
+
+struct Refresh
+{
+	Refresh(const Poll& poll_, const QString& uuid_): m_poll(poll_), m_uuid(uuid_)
+	{
+	}
+
+	void operator()() const
+	{
+		// only the background refresh spares a failing agent, a client
+		// request always goes to the guest
+		if (Vm::Guest::Breaker::instance().isOpen(m_uuid))
+			Cache::instance().release(m_uuid);
+		else
+			m_poll();
+	}
+
+private:
+	Poll m_poll;
+	QString m_uuid;
+};
+
+} // namespace Network
+
 template<>
 struct Essence<PVE::DspCmdVmGuestGetNetworkSettings>: Need::Agent, Need::Config,
 	Need::Context
 {
 	Libvirt::Result operator()()
 	{
-		namespace vm = Libvirt::Instrument::Agent::Vm;
-		Prl::Expected<vm::Exec::Result, Error::Simple> e = getAgent()
-						.getGuest().runProgram(getRequest());
+		QString u = getContext().getVmUuid();
+		QByteArray t = getStamp();
+		Network::Poll p(getAgent(), getRequest(), u, t);
+
+		VIRTUAL_MACHINE_STATE s = VMS_UNKNOWN;
+		getAgent().getState().getValue(s);
+		Network::Snapshot x;
+		bool y = false;
+		if (VMS_RUNNING != s)
+			Network::Cache::instance().drop(u);
+		else if (Network::Cache::instance().find(u, t, x, y))
+		{
+			if (y && Network::Cache::instance().lease(u))
+				Executor::get(Executor::GUEST).run(Network::Refresh(p, u));
+
+			respond(parsePrlNetToolOut(QString(x.data)).toString(), x.exitcode);
+			return Libvirt::Result();
+		}
+
+		// nobody asked recently, thus poll synchronously
+		Network::Poll::result_type e = Network::Cache::instance().lease(u) ?
+			p() : getAgent().getGuest().runProgram(getRequest());
 		if (e.isFailed())
 		{
 			WRITE_TRACE(DBG_FATAL, "GetNetworkSettings for VM '%s' is failed: %s",
-				qPrintable(getContext().getVmUuid()),
+				qPrintable(u),
 				PRL_RESULT_TO_STRING(e.error().code()));
 			return e.error();
 		}
@@ -773,6 +866,16 @@ struct Essence<PVE::DspCmdVmGuestGetNetworkSettings>: Need::Agent, Need::Config,
 	}
 
 private:
+	// a change of the adapters configuration outdates the snapshot
+	QByteArray getStamp() const
+	{
+		QCryptographicHash h(QCryptographicHash::Sha1);
+		foreach (CVmGenericNetworkAdapter* a,
+			getConfig()->getVmHardwareList()->m_lstNetworkAdapters)
+			h.addData(a->toString().toUtf8());
+
+		return h.result();
+	}
 	Libvirt::Instrument::Agent::Vm::Exec::Request getRequest() const
 	{
 		namespace vm = Libvirt::Instrument::Agent::Vm;
@@ -1889,6 +1992,8 @@ void Body<Tag::Special<PVE::DspCmdVmResetUptime> >::run(Context& context_)
 		SmartPtr<CDspVm> m = CDspVm::GetVmInstanceByUuid(context_.getIdent());
 		if (m.isValid())
 			m->resetUptime();
+		CDspVm::getUptimeStore().reset(context_.getVmUuid());
+		CDspVm::getUptimeStore().flush();
 	}
 	//Reset uptime at configuration
 	// Save config
@@ -1944,7 +2049,7 @@ struct Body<Tag::Fork<T> >: QRunnable
 	{
 		QRunnable* q = new Body(context_);
 		q->setAutoDelete(true);
-		QThreadPool::globalInstance()->start(q);
+		Executor::get(Executor::LIFECYCLE).start(q);
 	}
 
 private:
@@ -2179,7 +2284,7 @@ void Dispatcher::do_(const SmartPtr<CDspClient>& session_, const SmartPtr<IOPack
 
 	if (y == PVE::DspCmdVmInternal)
 	{
-		QtConcurrent::run(this, &Dispatcher::doInternal_, x);
+		Executor::get(Executor::INTERNAL).run(boost::bind(&Dispatcher::doInternal_, this, x));
 		return;
 	}
 
@@ -2445,28 +2550,9 @@ void CDspVmManager::syncVMsUptime()
 {
 	WRITE_TRACE(DBG_FATAL, "Synchronizing VMs uptime values");
 
-	QReadLocker locker( &m_rwLock );
-	QList< SmartPtr<CDspVm> > lstVms = m_vms.values();
-	locker.unlock();
-
-	foreach(SmartPtr<CDspVm> pVm, lstVms)
-	{
-		if (!pVm)
-			continue;
-
-		VIRTUAL_MACHINE_STATE state = pVm->getVmState();
-		switch (state)
-		{
-			case VMS_STOPPED:
-			case VMS_STOPPING:
-			case VMS_SUSPENDED:
-			case VMS_SUSPENDING:
-				continue;
-			default:
-				break;
-		}
-		pVm->updateVmUptime();
-	}
+	// the running VMs are registered in the store by the registry
+	CDspVm::getUptimeStore().account();
+	CDspVm::getUptimeStore().flush();
 
 	WRITE_TRACE(DBG_FATAL, "Synchronization of VMs uptime was completed");
 }
@@ -33,6 +33,8 @@
 #include <prlcommon/PrlCommonUtilsBase/StringUtils.h>
 #include <prlcommon/HostUtils/HostUtils.h>
 #include <QSet>
+#include <QElapsedTimer>
+#include <algorithm>
 #include <dlfcn.h>
 #include <guestfs.h>
 #include "CDspLibvirt.h"
@@ -40,6 +42,7 @@
 #include "CDspService.h"
 #include "CDspVmDirHelper.h"
 #include "CDspVmStateSender.h"
+#include "Stat/CDspStatStorage.h"
 #include <boost/preprocessor/tuple/elem.hpp>
 #include <boost/preprocessor/seq/for_each.hpp>
 
@@ -64,6 +67,7 @@ enum {GFS_PROGRAM_ERROR = 1, GFS_CANNOT_UNMOUNT = 2, GFS_NOT_MOUNTED = 3};
 ((void, guestfs_free_statvfs, (struct guestfs_statvfs *))) \
 ((int, guestfs_close, (guestfs_h *g))) \
 ((int, guestfs_shutdown, (guestfs_h *g))) \
+((int, guestfs_set_autosync, (guestfs_h *g, int autosync))) \
 ((guestfs_h*, guestfs_create, (void)))
 
 #define GUESTFS_NAME(elem) BOOST_PP_TUPLE_ELEM(3, 1, elem)
@@ -118,6 +122,69 @@ __attribute__((constructor)) void init()
 }       
 #undef GUESTFS_DEFINE
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Latency
+
+/* Time spent in the steps of a mount. A successful one is traced and
+ * accounted in the dispatcher counters guestfs.mount.<step>.{total,last,peak}.
+ */
+struct Latency
+{
+	enum Step {LAUNCH, PROBE, MOUNT, TOTAL, STEP_MAX};
+
+	Latency(): m_last(0)
+	{
+		m_timer.start();
+		std::fill(m_steps, m_steps + STEP_MAX, 0);
+	}
+
+	void mark(Step step_)
+	{
+		qint64 x = m_timer.elapsed();
+		m_steps[step_] = x - m_last;
+		m_steps[TOTAL] = m_last = x;
+	}
+
+	void report(const QString& uuid_) const;
+
+private:
+	static QString getName(int step_);
+
+	QElapsedTimer m_timer;
+	qint64 m_last;
+	qint64 m_steps[STEP_MAX];
+};
+
+void Latency::report(const QString& uuid_) const
+{
+	WRITE_TRACE(DBG_INFO, "VM %s is mounted in %lld ms (launch %lld, probe %lld, mount %lld)",
+		QSTR2UTF8(uuid_), m_steps[TOTAL], m_steps[LAUNCH], m_steps[PROBE], m_steps[MOUNT]);
+
+	Stat::Counters::add("guestfs.mount.calls", 1);
+	for (int i = 0; i < STEP_MAX; ++i)
+	{
+		QString n = QString("guestfs.mount.%1.").arg(getName(i));
+		Stat::Counters::add(n + "total", m_steps[i]);
+		Stat::Counters::set(n + "last", m_steps[i]);
+		Stat::Counters::raise(n + "peak", m_steps[i]);
+	}
+}
+
+QString Latency::getName(int step_)
+{
+	switch (step_)
+	{
+	case LAUNCH:
+		return "launch";
+	case PROBE:
+		return "probe";
+	case MOUNT:
+		return "mount";
+	default:
+		return "total";
+	}
+}
+
 } // namespace
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -158,8 +225,12 @@ PRL_RESULT GuestFS::addDrive(const CVmHardDisk &hardDisk, bool readOnly)
 	return PRL_ERR_SUCCESS;
 }
 
-PRL_RESULT GuestFS::launch() const
+PRL_RESULT GuestFS::launch(bool readOnly) const
 {
+	// nothing to flush on the appliance shutdown when all drives are read-only
+	if (readOnly)
+		CAPI.guestfs_set_autosync(m_gfsHandle, 0);
+
 	if (CAPI.guestfs_launch(m_gfsHandle)) {
 		WRITE_TRACE(DBG_FATAL, "Failed to launch guestfs appliance");
 		return PRL_ERR_FAILURE;
@@ -406,6 +477,7 @@ Prl::Expected<SmartPtr<CDspVmMount>, PRL_RESULT> mountVm(
 		return PRL_ERR_FAILURE;
 
 	GuestFS gfs(gfsHandle);
+	Latency latency;
 	PRL_RESULT res;
 
 	do {
@@ -415,13 +487,16 @@ Prl::Expected<SmartPtr<CDspVmMount>, PRL_RESULT> mountVm(
 				break;
 		}
 
-		if (PRL_FAILED(res = gfs.launch()))
+		if (PRL_FAILED(res = gfs.launch(readOnly)))
 			break;
 
+		latency.mark(Latency::LAUNCH);
 		QStringList partitions;
 		if (PRL_FAILED(res = gfs.getMountablePartitions(partitions)))
 			break;
 
+		latency.mark(Latency::PROBE);
+
 		foreach(const QString &partition, partitions) {
 			if (PRL_FAILED(res = gfs.mountPartition(partition)))
 				break;
@@ -442,6 +517,8 @@ Prl::Expected<SmartPtr<CDspVmMount>, PRL_RESULT> mountVm(
 			infos << info;
 		}
 		QString mountInfo = infos.join("\n");
+		latency.mark(Latency::MOUNT);
+		latency.report(pVmConfig->getVmIdentification()->getVmUuid());
 
 		return SmartPtr<CDspVmMount>(new CDspVmMount(
 					MakeVmIdent(pVmConfig->getVmIdentification()->getVmUuid(),dirUuid),
@@ -94,7 +94,7 @@ struct GuestFS
 	// Add drive to handle. Must be called before launch().
 	PRL_RESULT addDrive(const CVmHardDisk &hardDisk, bool readOnly);
 	// Run guestfs appliance.
-	PRL_RESULT launch() const;
+	PRL_RESULT launch(bool readOnly) const;
 	// Get partitions in format "/dev/sdXN" or "/dev/VG/LV".
 	PRL_RESULT getMountablePartitions(QStringList &partitions);
 	// Create mountpoint(s) and mount partition to it.
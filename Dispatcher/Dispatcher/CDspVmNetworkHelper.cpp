@@ -426,13 +426,15 @@ Libvirt::Result Dao::attachExisting(CVirtualNetwork model_,
 
 void Routing::configure(const CVmConfiguration& config_, bool enable_)
 {
+	QList<const CVmGenericNetworkAdapter* > r;
 	foreach(const CVmGenericNetworkAdapter* a, config_.getVmHardwareList()->m_lstNetworkAdapters)
 	{
 		if (NULL == a || a->getEmulatedType() != PNA_ROUTED)
 			continue;
 
-		execute(*a, enable_);
+		r << a;
 	}
+	execute(r.constBegin(), r.constEnd(), enable_);
 }
 
 void Routing::reconfigure(const CVmConfiguration& old_, const CVmConfiguration& new_)
@@ -443,12 +445,12 @@ void Routing::reconfigure(const CVmConfiguration& old_, const CVmConfiguration&
 	QList<CVmGenericNetworkAdapter*>::iterator d = std::partition(o.begin(), o.end(), 
 			boost::bind(&Routing::find, _1, boost::cref(n)));
 
-	std::for_each(d, o.end(), boost::bind(&Routing::execute, this, _1, false));
+	execute(d, o.end(), false);
 
 	QList<CVmGenericNetworkAdapter*>::iterator e = std::partition(n.begin(), n.end(),
 			boost::bind(&Routing::find, _1, boost::cref(o)));
 
-	std::for_each(e, n.end(), boost::bind(&Routing::execute, this, _1, true));
+	execute(e, n.end(), true);
 }
 
 bool Routing::find(const CVmGenericNetworkAdapter* adapter_, const QList<CVmGenericNetworkAdapter*>& search_)
@@ -126,17 +126,18 @@ private:
 
 struct Paver: QRunnable
 {
-	Paver(const CVmGenericNetworkAdapter& adapter_, bool enable_): m_adapter(adapter_), m_enable(enable_)
+	Paver(const QList<CVmGenericNetworkAdapter>& adapters_, bool enable_):
+		m_adapters(adapters_), m_enable(enable_)
 	{
 	}
 
 	void run()
 	{
-		Task_ManagePrlNetService::updateAdapter(m_adapter, m_enable);
+		Task_ManagePrlNetService::updateAdapters(m_adapters, m_enable);
 	}
 
 private:
-	CVmGenericNetworkAdapter m_adapter;
+	QList<CVmGenericNetworkAdapter> m_adapters;
 	bool m_enable;
 };
 
@@ -163,9 +164,17 @@ struct Routing
 
 private:
 	static bool find(const CVmGenericNetworkAdapter* adapter_, const QList<CVmGenericNetworkAdapter*>& search_);
-	void execute(const CVmGenericNetworkAdapter& adapter_, bool enable_)
+	template<class T>
+	void execute(T begin_, T end_, bool enable_)
 	{
-		QRunnable* q = new Paver(adapter_, enable_);
+		QList<CVmGenericNetworkAdapter> a;
+		for (; begin_ != end_; ++begin_)
+			a << **begin_;
+
+		if (a.isEmpty())
+			return;
+
+		QRunnable* q = new Paver(a, enable_);
 		q->setAutoDelete(true);
 		m_thread.start(q);
 	}
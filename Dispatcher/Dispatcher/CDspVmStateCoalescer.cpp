@@ -0,0 +1,85 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmStateCoalescer.cpp
+///
+/// Collector of the VM events sent to clients in the batch mode.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#include "CDspVmStateCoalescer.h"
+
+namespace Vm
+{
+namespace State
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Coalescer
+
+void Coalescer::add(const CVmIdent& vm_, PRL_EVENT_TYPE type_, const QByteArray& event_,
+	const Event::recipients_type& recipients_)
+{
+	key_type k(vm_, type_);
+	QMutexLocker g(&m_mutex);
+	++m_metrics.queued;
+	if (m_queue.contains(k))
+		++m_metrics.coalesced;
+	else
+		m_order << k;
+
+	Event& e = m_queue[k];
+	e.vm = vm_;
+	e.body = event_;
+	e.recipients.unite(recipients_);
+	m_metrics.depth = m_queue.size();
+	m_metrics.peak = qMax(m_metrics.peak, m_metrics.depth);
+}
+
+QList<Coalescer::event_type> Coalescer::take()
+{
+	QList<event_type> output;
+	QMutexLocker g(&m_mutex);
+	foreach (const key_type& k, m_order)
+	{
+		output << m_queue.value(k);
+	}
+	m_order.clear();
+	m_queue.clear();
+	m_metrics.depth = 0;
+	return output;
+}
+
+void Coalescer::count(int packages_)
+{
+	QMutexLocker g(&m_mutex);
+	m_metrics.packages += packages_;
+}
+
+Metrics Coalescer::getMetrics() const
+{
+	QMutexLocker g(&m_mutex);
+	return m_metrics;
+}
+
+} // namespace State
+} // namespace Vm
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmStateCoalescer.h
+///
+/// Collector of the VM events sent to clients in the batch mode.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDSPVMSTATECOALESCER_H__
+#define __CDSPVMSTATECOALESCER_H__
+
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QMutex>
+#include <QByteArray>
+#include "CVmIdent.h"
+#include <prlsdk/PrlEnums.h>
+
+namespace Vm
+{
+namespace State
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Metrics
+
+struct Metrics
+{
+	Metrics(): queued(), coalesced(), packages(), depth(), peak()
+	{
+	}
+
+	quint64 queued;		///< events put into the queue
+	quint64 coalesced;	///< events superseded by a newer one within a window
+	quint64 packages;	///< event packages sent when the windows expired
+	int depth;		///< events waiting for the window to expire
+	int peak;		///< maximum depth ever observed
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Event
+// The serialised event and the sessions that were subscribed to the VM
+// when it was queued.
+
+struct Event
+{
+	typedef QSet<QString> recipients_type;
+
+	Event()
+	{
+	}
+	Event(const CVmIdent& vm_, const QByteArray& body_, const recipients_type& recipients_):
+		vm(vm_), body(body_), recipients(recipients_)
+	{
+	}
+
+	CVmIdent vm;
+	QByteArray body;
+	recipients_type recipients;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Coalescer
+// Keeps the last serialised event of every type per VM until the window
+// is flushed. The order of the first appearance is preserved. A superseded
+// event passes its recipients on to the one that replaces it.
+
+struct Coalescer
+{
+	typedef Event event_type;
+
+	void add(const CVmIdent& vm_, PRL_EVENT_TYPE type_, const QByteArray& event_,
+		const Event::recipients_type& recipients_);
+	QList<event_type> take();
+	void count(int packages_);
+	Metrics getMetrics() const;
+
+private:
+	typedef QPair<CVmIdent, int> key_type;
+
+	mutable QMutex m_mutex;
+	QList<key_type> m_order;
+	QHash<key_type, Event> m_queue;
+	Metrics m_metrics;
+};
+
+} // namespace State
+} // namespace Vm
+
+#endif // __CDSPVMSTATECOALESCER_H__
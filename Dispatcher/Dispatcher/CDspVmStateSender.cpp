@@ -62,7 +62,21 @@
 
 #include <prlcommon/PrlCommonUtilsBase/PrlStringifyConsts.h>
 
-CDspVmStateSender::CDspVmStateSender()
+#include <QSet>
+#include <QTimerEvent>
+
+namespace
+{
+enum
+{
+	// events for clients with the batch mode are collected within this window
+	EVENTS_COALESCE_WINDOW = 200
+};
+
+} // namespace
+
+
+CDspVmStateSender::CDspVmStateSender(): m_timer()
 {
 	bool bConnected = connect( this
 		, SIGNAL( signalSendVmStateChanged( unsigned int, QString ,QString, bool ) )
@@ -200,14 +214,7 @@ void CDspVmStateSender::slotSendVmStateChanged(
 		, QString("%1").arg((int)nVmState)
 		, EVT_PARAM_VMINFO_VM_STATE ) );
 
-	SmartPtr<IOPackage> pUpdateVmStatePkg = DispatcherPackage::createInstance( PVE::DspVmEvent, event );
-
-	CDspService::instance()->getClientManager()
-		.sendPackageToVmClients(
-			pUpdateVmStatePkg,
-			dirUuid,
-			vmUuid
-			);
+	send(MakeVmIdent(vmUuid, dirUuid), event);
 }
 
 void CDspVmStateSender::slotSendVmAdditionStateChanged( unsigned int nVmAdditionState,
@@ -227,14 +234,74 @@ void CDspVmStateSender::slotSendVmAdditionStateChanged( unsigned int nVmAddition
 		, QString("%1").arg((int)nVmAdditionState)
 		, EVT_PARAM_VMINFO_VM_ADDITION_STATE ) );
 
-	SmartPtr<IOPackage> pUpdateVmAdditionStatePkg = DispatcherPackage::createInstance( PVE::DspVmEvent, event );
+	send(MakeVmIdent(vmUuid, dirUuid), event);
+}
 
-	CDspService::instance()->getClientManager()
-		.sendPackageToVmClients(
-		pUpdateVmAdditionStatePkg,
-		dirUuid,
-		vmUuid
-		);
+void CDspVmStateSender::send(const CVmIdent& vm_, const CVmEvent& event_)
+{
+	// serialise once for all the recipients
+	QString x = event_.toString();
+	QList<SmartPtr<CDspClient> > d;
+	Vm::State::Event::recipients_type b;
+	CDspClientManager& m = CDspService::instance()->getClientManager();
+	foreach (const SmartPtr<CDspClient>& c, m.getSessionListByVm(vm_.second, vm_.first).values())
+	{
+		if (c->isVmEventsBatchEnabled())
+			b.insert(c->getClientHandle());
+		else
+			d << c;
+	}
+	if (!d.isEmpty())
+		m.sendPackageToClientList(DispatcherPackage::createInstance(PVE::DspVmEvent, x), d);
+
+	if (b.isEmpty())
+		return;
+
+	// the recipients are fixed now: a session that subscribes within the
+	// window has not seen the earlier state and will query it by itself
+	m_coalescer.add(vm_, event_.getEventType(), x.toUtf8(), b);
+	if (0 == m_timer)
+		m_timer = startTimer(EVENTS_COALESCE_WINDOW);
+}
+
+void CDspVmStateSender::timerEvent(QTimerEvent* event_)
+{
+	if (event_->timerId() != m_timer)
+		return QObject::timerEvent(event_);
+
+	killTimer(m_timer);
+	m_timer = 0;
+
+	int n = 0;
+	QSet<IOSender::Handle> r;
+	CDspClientManager& m = CDspService::instance()->getClientManager();
+	QList<Vm::State::Coalescer::event_type> q = m_coalescer.take();
+	foreach (const Vm::State::Coalescer::event_type& e, q)
+	{
+		QList<SmartPtr<CDspClient> > d;
+		foreach (const IOSender::Handle& h, e.recipients)
+		{
+			// the session may have gone while the event was waiting
+			SmartPtr<CDspClient> c = m.getUserSession(h);
+			if (c.isValid())
+			{
+				d << c;
+				r.insert(h);
+			}
+		}
+		if (d.isEmpty())
+			continue;
+
+		// the usual event package, clients need no new format
+		m.sendPackageToClientList(DispatcherPackage::createInstance(PVE::DspVmEvent,
+			QString::fromUtf8(e.body)), d);
+		++n;
+	}
+
+	Vm::State::Metrics x = m_coalescer.getMetrics();
+	WRITE_TRACE(DBG_DEBUG, "flushed %d VM events to %d clients: queued %llu, coalesced %llu, peak depth %d",
+		q.size(), r.size(), x.queued, x.coalesced, x.peak);
+	m_coalescer.count(n);
 }
 
 namespace Vm
@@ -47,10 +47,13 @@
 #include <QHash>
 #include <QThread>
 #include "CVmIdent.h"
+#include "CDspVmStateCoalescer.h"
 #include "CDspSync.h"
 #include <prlcommon/Std/SmartPtr.h>
 #include <prlsdk/PrlEnums.h>
 
+class CVmEvent;
+
 class CDspVmStateSenderThread;
 class CDspVmStateSender: public QObject
 {
@@ -87,10 +90,17 @@ public slots:
 	void slotSendVmStateChanged( unsigned int nVmState, QString vmUuid, QString dirUuid, bool notifyVm );
 	void slotSendVmAdditionStateChanged( unsigned int nVmAdditionState, QString vmUuid, QString dirUuid );
 
+protected:
+	void timerEvent(QTimerEvent* event_);
+
 private:
 	typedef QHash<CVmIdent, VIRTUAL_MACHINE_STATE> cache_type;
 
+	void send(const CVmIdent& vm_, const CVmEvent& event_);
+
 	cache_type m_cache;
+	int m_timer;
+	Vm::State::Coalescer m_coalescer;
 };
 
 
@@ -0,0 +1,227 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmUptime.cpp
+///
+/// Host store of the VM uptime not folded into the configs yet
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#include <stdio.h>
+#ifdef _LIN_
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <unistd.h>
+#endif // _LIN_
+#include <QFile>
+#include <QFileInfo>
+#include <QStringList>
+#include <QTextStream>
+#include <prlcommon/Logging/Logging.h>
+#include <prlcommon/Std/PrlTime.h>
+#include "CDspVmUptime.h"
+
+namespace DspVm
+{
+namespace
+{
+quint64 getSeconds()
+{
+	return PrlGetTickCount64() / PrlGetTicksPerSecond();
+}
+
+} // namespace
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Uptime
+
+Uptime::Uptime(): m_clock(&getSeconds), m_dirty()
+{
+}
+
+Uptime::Uptime(const clock_type& clock_): m_clock(clock_), m_dirty()
+{
+}
+
+void Uptime::load(const QString& path_)
+{
+	QMutexLocker g(&m_mutex);
+	m_path = path_;
+	QFile f(m_path);
+	if (!f.open(QIODevice::ReadOnly | QIODevice::Text))
+		return;
+
+	while (!f.atEnd())
+	{
+		QStringList x = QString(f.readLine()).trimmed().split(' ');
+		if (x.size() != 2)
+			continue;
+
+		bool o = false;
+		quint64 v = x.last().toULongLong(&o);
+		if (o && 0 < v)
+			m_map[x.first()] += v;
+	}
+	WRITE_TRACE(DBG_INFO, "%d VM uptime records are loaded from %s",
+		m_map.size(), QSTR2UTF8(m_path));
+}
+
+void Uptime::start(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	if (!m_running.contains(uuid_))
+		m_running.insert(uuid_, m_clock());
+}
+
+void Uptime::account()
+{
+	QMutexLocker g(&m_mutex);
+	quint64 n = m_clock();
+	QHash<QString, quint64>::iterator p = m_running.begin();
+	for (; p != m_running.end(); ++p)
+	{
+		if (n <= p.value())
+			continue;
+
+		m_map[p.key()] += n - p.value();
+		p.value() = n;
+		m_dirty = true;
+	}
+}
+
+quint64 Uptime::get(const QString& uuid_) const
+{
+	QMutexLocker g(&m_mutex);
+	quint64 output = m_map.value(uuid_);
+	QHash<QString, quint64>::const_iterator p = m_running.find(uuid_);
+	if (m_running.constEnd() != p)
+		output += qMax(m_clock(), p.value()) - p.value();
+
+	return output;
+}
+
+bool Uptime::isRunning(const QString& uuid_) const
+{
+	QMutexLocker g(&m_mutex);
+	return m_running.contains(uuid_);
+}
+
+quint64 Uptime::fold(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	quint64 output = m_map.take(uuid_);
+	if (m_running.contains(uuid_))
+		output += qMax(m_clock(), m_running.value(uuid_)) - m_running.take(uuid_);
+
+	if (0 < output)
+	{
+		m_dirty = true;
+		store();
+	}
+	return output;
+}
+
+void Uptime::add(const QString& uuid_, quint64 delta_)
+{
+	if (0 == delta_)
+		return;
+
+	QMutexLocker g(&m_mutex);
+	m_map[uuid_] += delta_;
+	m_dirty = true;
+}
+
+void Uptime::reset(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	m_dirty |= (0 < m_map.take(uuid_));
+	if (m_running.contains(uuid_))
+		m_running.insert(uuid_, m_clock());
+}
+
+void Uptime::forget(const QString& uuid_)
+{
+	QMutexLocker g(&m_mutex);
+	m_running.remove(uuid_);
+	m_dirty |= (0 < m_map.take(uuid_));
+}
+
+void Uptime::flush()
+{
+	QMutexLocker g(&m_mutex);
+	store();
+}
+
+void Uptime::store()
+{
+	if (!m_dirty || m_path.isEmpty())
+		return;
+
+	QString t = m_path + ".tmp";
+	QFile f(t);
+	if (!f.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to open %s: %s",
+			QSTR2UTF8(t), QSTR2UTF8(f.errorString()));
+		return;
+	}
+	QTextStream x(&f);
+	QHash<QString, quint64>::const_iterator p = m_map.constBegin();
+	for (; p != m_map.constEnd(); ++p)
+		x << p.key() << ' ' << p.value() << '\n';
+
+	x.flush();
+	bool o = f.flush();
+#ifdef _LIN_
+	// the records must reach the disk before the name does
+	o = o && 0 == ::fsync(f.handle());
+#endif // _LIN_
+	f.close();
+	if (!o || f.error() != QFile::NoError ||
+		0 != ::rename(QFile::encodeName(t).constData(), QFile::encodeName(m_path).constData()))
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to store VM uptime records into %s",
+			QSTR2UTF8(m_path));
+		return;
+	}
+	m_dirty = false;
+	sync();
+}
+
+void Uptime::sync() const
+{
+#ifdef _LIN_
+	QByteArray d = QFile::encodeName(QFileInfo(m_path).absolutePath());
+	int x = ::open(d.constData(), O_RDONLY | O_DIRECTORY);
+	if (0 > x || 0 != ::fsync(x))
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to sync the directory of %s: %s",
+			QSTR2UTF8(m_path), strerror(errno));
+	}
+	if (0 <= x)
+		::close(x);
+#endif // _LIN_
+}
+
+} // namespace DspVm
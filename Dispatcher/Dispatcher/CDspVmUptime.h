@@ -0,0 +1,88 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmUptime.h
+///
+/// Host store of the VM uptime not folded into the configs yet
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __CDSPVMUPTIME_H__
+#define __CDSPVMUPTIME_H__
+
+#include <QHash>
+#include <QMutex>
+#include <QString>
+#include <boost/function.hpp>
+
+namespace DspVm
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Uptime
+// Uptime of VMs that is not folded into their configs yet. A VM is
+// registered here when it starts and the periodic sync moves the time it
+// runs into the pending deltas which are flushed into one host file. The
+// pending delta is folded into the VM config when the VM stops.
+
+struct Uptime
+{
+	// seconds of a monotonic clock
+	typedef boost::function<quint64 ()> clock_type;
+
+	Uptime();
+	explicit Uptime(const clock_type& clock_);
+
+	void load(const QString& path_);
+	// registers a running VM, a VM that runs already keeps its start
+	void start(const QString& uuid_);
+	// moves the time of all the running VMs into their pending deltas
+	void account();
+	quint64 get(const QString& uuid_) const;
+	bool isRunning(const QString& uuid_) const;
+	// unregisters the VM and hands its whole delta out. the store forgets
+	// the delta on disk before it is returned, thus a crash before the
+	// config commit may lose it but never counts it twice
+	quint64 fold(const QString& uuid_);
+	void add(const QString& uuid_, quint64 delta_);
+	// drops the delta, a running VM starts counting anew
+	void reset(const QString& uuid_);
+	void forget(const QString& uuid_);
+	void flush();
+
+private:
+	void store();
+	void sync() const;
+
+	clock_type m_clock;
+	mutable QMutex m_mutex;
+	QString m_path;
+	// pending deltas
+	QHash<QString, quint64> m_map;
+	// start of the last period of running VMs
+	QHash<QString, quint64> m_running;
+	bool m_dirty;
+};
+
+} // namespace DspVm
+
+#endif // __CDSPVMUPTIME_H__
@@ -121,7 +121,8 @@ namespace
 struct CopyProgress: QFile
 {
 	CopyProgress(const QString& filename_, const QString& uuid_, CDspTaskHelper* taskHelper_,
-			PRL_DEVICE_TYPE devType_, int devNum_)
+			PRL_DEVICE_TYPE devType_, int devNum_,
+			const CFileHelperDepPart::progress_type& progress_)
 		: QFile(filename_),
 			m_uuid(uuid_),
 			m_total(0),
@@ -129,7 +130,8 @@ struct CopyProgress: QFile
 			m_currentPercent(0),
 			m_taskHelper(taskHelper_),
 			m_devType(devType_),
-			m_devNum(devNum_)
+			m_devNum(devNum_),
+			m_progress(progress_)
 	{
 		m_total = QFile::size();
 	}
@@ -148,6 +150,9 @@ protected:
 private:
 	void handleWrittenBytes(qint64 bytes_)
 	{
+		if (bytes_ > 0 && m_progress)
+			m_progress(bytes_);
+
 		m_read += bytes_;
 		quint32 c(((double)m_read)/((double)m_total) * 100.0 + 0.5);
 		if (m_currentPercent == c || c == 100)
@@ -186,6 +191,7 @@ private:
 	CDspTaskHelper* m_taskHelper;
 	PRL_DEVICE_TYPE m_devType;
 	int m_devNum;
+	CFileHelperDepPart::progress_type m_progress;
 };
 
 } // anonymous namespace
@@ -196,7 +202,8 @@ PRL_RESULT CFileHelperDepPart::CopyFileWithNotifications(const QString & source_
 																  CAuthHelper* owner_,
 																  CDspTaskHelper* taskHelper_,
 																  PRL_DEVICE_TYPE devType_,
-																  int devNum_
+																  int devNum_,
+																  const progress_type& progress_
 																  )
 {
 	NotifyCopyEvent(taskHelper_, PET_VM_INF_START_BUNCH_COPYING, devType_, devNum_);
@@ -206,7 +213,7 @@ PRL_RESULT CFileHelperDepPart::CopyFileWithNotifications(const QString & source_
 
 	NotifyCopyEvent(taskHelper_, PET_VM_INF_START_FILE_COPYING, devType_, devNum_);
 
-	CopyProgress p(source_, Uuid().toString(), taskHelper_, devType_, devNum_);
+	CopyProgress p(source_, Uuid().toString(), taskHelper_, devType_, devNum_, progress_);
 	if (!p.open(QIODevice::ReadOnly | QIODevice::Unbuffered))
 		return PRL_ERR_FILE_NOT_FOUND;
 	if (!p.copy(dest_))
@@ -36,19 +36,24 @@
 
 #include <prlsdk/PrlErrors.h>
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
+#include <boost/function.hpp>
 
 class CDspTaskHelper;
 
 class CFileHelperDepPart : public CFileHelper
 {
 public:
+	 // receives the number of bytes read since the previous call
+	 typedef boost::function<void (qint64)> progress_type;
+
 	 // file copy with cancel check
 	 static PRL_RESULT CopyFileWithNotifications(const QString & source_,
 		 const QString& dest_,
 		 CAuthHelper* owner_,
 		 CDspTaskHelper* taskHelper_,
 		 PRL_DEVICE_TYPE devType_,
-		 int devNum_);
+		 int devNum_,
+		 const progress_type& progress_ = progress_type());
 
 	 static PRL_RESULT CopyDirectoryWithNotifications(const QString& strSourceDir,
 		 const QString& strTargetDir,
@@ -46,11 +46,61 @@
 CMultiEditDispatcher::CMultiEditDispatcher()
 :QMutex( QMutex::Recursive )
 {
-
+	for (int i = 0; i < COMMIT_LOCK_STRIPES; ++i)
+		m_lstCommitLocks << new QMutex( QMutex::Recursive );
 }
 
 CMultiEditDispatcher::~CMultiEditDispatcher()
 {
+	qDeleteAll(m_lstCommitLocks);
+}
+
+int CMultiEditDispatcher::getCommitLockIndex(const QString& objectUuid) const
+{
+	return qHash(objectUuid) % COMMIT_LOCK_STRIPES;
+}
+
+CMultiEditDispatcher::CommitLocker::CommitLocker(CMultiEditDispatcher* pDispatcher
+		, const QString& objectUuid)
+{
+	lock(pDispatcher, QStringList(objectUuid));
+}
+
+CMultiEditDispatcher::CommitLocker::CommitLocker(CMultiEditDispatcher* pDispatcher
+		, const QStringList& lstObjectUuids)
+{
+	lock(pDispatcher, lstObjectUuids);
+}
+
+CMultiEditDispatcher::CommitLocker::~CommitLocker()
+{
+	unlock();
+}
+
+void CMultiEditDispatcher::CommitLocker::lock(CMultiEditDispatcher* pDispatcher
+		, const QStringList& lstObjectUuids)
+{
+	QList<int> lstIndexes;
+	foreach(const QString& u, lstObjectUuids)
+	{
+		int i = pDispatcher->getCommitLockIndex(u);
+		if (!lstIndexes.contains(i))
+			lstIndexes << i;
+	}
+	// the fixed order excludes a deadlock between two lockers
+	qSort(lstIndexes);
+	foreach(int i, lstIndexes)
+	{
+		QMutex* m = pDispatcher->m_lstCommitLocks.at(i);
+		m->lock();
+		m_lstLocked << m;
+	}
+}
+
+void CMultiEditDispatcher::CommitLocker::unlock()
+{
+	while (!m_lstLocked.isEmpty())
+		m_lstLocked.takeLast()->unlock();
 }
 
 void CMultiEditDispatcher::registerBeginEdit(const QString& objectUuid, const IOSender::Handle& userUuid)
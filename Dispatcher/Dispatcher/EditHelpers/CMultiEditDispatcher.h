@@ -38,7 +38,9 @@
 #define CMultiEditDispatcher_H
 
 #include <QHash>
+#include <QList>
 #include <QMutex>
+#include <QStringList>
 
 #include <prlcommon/IOService/IOCommunication/IOServer.h>
 #include <prlsdk/PrlErrors.h>
@@ -72,6 +74,32 @@ public:
 		QMutex::unlock();
 	}
 
+	/**
+	 * Serializes commits of the specified configs. Configs are spread over
+	 * a fixed set of stripes, so commits of different configs seldom wait
+	 * for each other. All the stripes needed are taken at once in the
+	 * ascending order of their indexes, thus two lockers never wait for
+	 * each other crosswise. A thread that holds a locker must not create
+	 * another one for different configs.
+	 * @NOTE: THE COMMIT LOCK SHOULD BE TAKEN BEFORE lock().
+	 */
+	class CommitLocker
+	{
+	public:
+		CommitLocker(CMultiEditDispatcher* pDispatcher, const QString& sObjectId);
+		CommitLocker(CMultiEditDispatcher* pDispatcher, const QStringList& lstObjectIds);
+		~CommitLocker();
+
+		void unlock();
+
+	private:
+		Q_DISABLE_COPY(CommitLocker)
+
+		void lock(CMultiEditDispatcher* pDispatcher, const QStringList& lstObjectIds);
+
+		QList<QMutex* > m_lstLocked;
+	};
+
 	/**
 	 * Registries beginning of editing config by user
 	 * @param editing config id
@@ -139,6 +167,11 @@ private:
 	typedef SmartPtr<EditCommitInfo> EditCommitInfoPtr;
 
 	QHash<QString, EditCommitInfoPtr >  m_hashCommitsByObject;
+
+	enum { COMMIT_LOCK_STRIPES = 64 };
+	QList<QMutex* > m_lstCommitLocks;
+
+	int getCommitLockIndex(const QString& sObjectId) const;
 };
 
 #endif
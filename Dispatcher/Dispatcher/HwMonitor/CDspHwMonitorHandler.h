@@ -73,6 +73,11 @@ public:
 	*/
 	void stopHandleDevices();
 	/**
+	* Returns true when device changes are reported by the system events,
+	* so periodic rescans are needed only as a safety net
+	*/
+	bool isEventDriven() const;
+	/**
 	* Device changed handler function
 	* @param dev_name platform dependent device name
 	* @param event_code new device state connected/disconnected
@@ -94,11 +99,15 @@ protected:
 #ifdef _LIN_
 	BOOL		m_bRunFlag;
 	pthread_t	m_thread_id;
+	int		m_uevent;
+	int		m_route;
 #endif // _LIN_
 
 signals:
 	/** Device changed signal */
 	void deviceChanged(PRL_DEVICE_TYPE dev_type, QString dev_name, unsigned int event_code );
+	/** Host classes other than devices (memory, cpu) changed signal */
+	void hostChanged(quint64 mask);
 
 };
 
@@ -42,9 +42,16 @@
 #include <sys/types.h>
 #include <sys/time.h>
 #include <sys/socket.h>
+#include <net/if.h>
 #include <linux/netlink.h>
 #include <linux/rtnetlink.h>
+#include <linux/if_addr.h>
+#include <linux/if_link.h>
 #include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <QFile>
+#include <QElapsedTimer>
 
 #define MSECS_IN_SEC 1000
 #define USECS_IN_MSEC 1000
@@ -55,17 +62,232 @@
 */
 CDspHwMonitorHandler::CDspHwMonitorHandler( QObject * parent )
 : QThread (parent)
+, m_bRunFlag(FALSE)
 , m_thread_id(0)
+, m_uevent(-1)
+, m_route(-1)
 {
 	WRITE_TRACE( DBG_DEBUG, "Create Harware Monitor Handler" );
 }
 
+static const int NL_RCVBUF_SIZE = 256 * 1024;
+
+// device classes tracked by kernel events
+static const quint64 EVENT_DEVICES =
+		( HI_MAKE_UPDATE_DEVICE_MASK(PDE_USB_DEVICE)
+		| HI_MAKE_UPDATE_DEVICE_MASK(PDE_HARD_DISK)
+		| HI_MAKE_UPDATE_DEVICE_MASK(PDE_OPTICAL_DISK)
+		| HI_MAKE_UPDATE_DEVICE_MASK(PDE_GENERIC_NETWORK_ADAPTER)
+		| HI_MAKE_UPDATE_DEVICE_MASK(PDE_SERIAL_PORT)
+		| HI_MAKE_UPDATE_DEVICE_MASK(PDE_PRINTER)
+		| CDspHostInfo::uhiPci
+		| CDspHostInfo::uhiMemory
+		| CDspHostInfo::uhiCpu
+		);
+
+static const unsigned int UEVENT_GROUPS = 1;
+static const unsigned int ROUTE_GROUPS =
+		RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+static int openNetlinkSock(int protocol, unsigned int groups)
+{
+	int sock = ::socket(PF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, protocol);
+	if (sock < 0)
+		return -1;
+
+	int rcvbuf_size = NL_RCVBUF_SIZE;
+	if ( ::setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
+			&rcvbuf_size, sizeof(rcvbuf_size)) < 0 ) {
+		// Don't return an error. Just log the event.
+		WRITE_TRACE_RL(3600, DBG_FATAL, "setsockopt for SO_RCVBUF failed with %d", errno);
+	}
+
+	struct sockaddr_nl local;
+	memset(&local, 0, sizeof(local));
+	local.nl_family = AF_NETLINK;
+	local.nl_groups = groups;
+	if (::bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
+		WRITE_TRACE_RL(3600, DBG_FATAL, "Failed to bind netlink socket %d: %d", protocol, errno);
+		::close(sock);
+		return -1;
+	}
+
+	return sock;
+}
+
+// VM taps, container veths and the like come and go with the guests
+// and are not reported as host network adapters.
+static bool isTransientNetDevice(const QByteArray& name)
+{
+	static const char* s_prefixes[] = { "tap", "tun", "veth", "vme", "vnet", "macvtap" };
+	for (unsigned i = 0; i < sizeof(s_prefixes) / sizeof(s_prefixes[0]); ++i) {
+		if (name.startsWith(s_prefixes[i]))
+			return true;
+	}
+	// a tun/tap device of any name
+	return QFile::exists(QString("/sys/class/net/%1/tun_flags").arg(QString(name)));
+}
+
+// Check if some rtnetlink message concerns a host network adapter.
+static bool isHostNetEvent(char* buf, int len)
+{
+	for (struct nlmsghdr* h = (struct nlmsghdr* )buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len))
+	{
+		char name[IF_NAMESIZE + 1] = {0};
+		switch (h->nlmsg_type) {
+		case RTM_NEWLINK:
+		case RTM_DELLINK: {
+			struct ifinfomsg* i = (struct ifinfomsg* )NLMSG_DATA(h);
+			int l = IFLA_PAYLOAD(h);
+			for (struct rtattr* a = IFLA_RTA(i); RTA_OK(a, l); a = RTA_NEXT(a, l)) {
+				if (a->rta_type == IFLA_IFNAME)
+					::strncpy(name, (const char* )RTA_DATA(a), IF_NAMESIZE);
+			}
+			break;
+		}
+		case RTM_NEWADDR:
+		case RTM_DELADDR: {
+			struct ifaddrmsg* i = (struct ifaddrmsg* )NLMSG_DATA(h);
+			int l = IFA_PAYLOAD(h);
+			for (struct rtattr* a = IFA_RTA(i); RTA_OK(a, l); a = RTA_NEXT(a, l)) {
+				if (a->rta_type == IFA_LABEL)
+					::strncpy(name, (const char* )RTA_DATA(a), IF_NAMESIZE);
+			}
+			// NB. the device of the address may be gone already, then
+			// its RTM_DELLINK tells the rest
+			if (0 == name[0] && NULL == ::if_indextoname(i->ifa_index, name))
+				continue;
+			break;
+		}
+		default:
+			continue;
+		}
+		if (0 != name[0] && !isTransientNetDevice(name))
+			return true;
+	}
+	return false;
+}
+
+// Map a kernel uevent onto the host info classes it affects.
+// @return 0 if the event is of no interest.
+static quint64 classifyUevent(const char* buf, int len)
+{
+	QByteArray action, subsystem, devtype, devname, iface;
+	for (int i = 0; i < len; i += ::strnlen(buf + i, len - i) + 1)
+	{
+		QByteArray x = QByteArray::fromRawData(buf + i, ::strnlen(buf + i, len - i));
+		if (x.startsWith("ACTION="))
+			action = x.mid(sizeof("ACTION=") - 1);
+		else if (x.startsWith("SUBSYSTEM="))
+			subsystem = x.mid(sizeof("SUBSYSTEM=") - 1);
+		else if (x.startsWith("DEVTYPE="))
+			devtype = x.mid(sizeof("DEVTYPE=") - 1);
+		else if (x.startsWith("DEVNAME="))
+			devname = x.mid(sizeof("DEVNAME=") - 1);
+		else if (x.startsWith("INTERFACE="))
+			iface = x.mid(sizeof("INTERFACE=") - 1);
+	}
+	// memory blocks and cpus are hotplugged by online/offline
+	if (action == "online" || action == "offline")
+	{
+		if (subsystem == "memory")
+			return CDspHostInfo::uhiMemory;
+		if (subsystem == "cpu")
+			return CDspHostInfo::uhiCpu;
+		return 0;
+	}
+	if (action != "add" && action != "remove" && action != "change" && action != "move")
+		return 0;
+
+	PRL_DEVICE_TYPE t = PDE_GENERIC_DEVICE;
+	if (subsystem == "usb")
+		t = devtype == "usb_device" ? PDE_USB_DEVICE : PDE_GENERIC_DEVICE;
+	else if (subsystem == "block")
+		t = devname.startsWith("sr") ? PDE_OPTICAL_DISK : PDE_HARD_DISK;
+	else if (subsystem == "net")
+		t = isTransientNetDevice(iface) ? PDE_GENERIC_DEVICE : PDE_GENERIC_NETWORK_ADAPTER;
+	else if (subsystem == "tty")
+	{
+		t = devname.startsWith("ttyS") || devname.startsWith("ttyUSB")
+			|| devname.startsWith("ttyACM") ? PDE_SERIAL_PORT : PDE_GENERIC_DEVICE;
+	}
+	else if (subsystem == "usbmisc" && devname.contains("lp"))
+		t = PDE_PRINTER;
+	else if (subsystem == "printer")
+		t = PDE_PRINTER;
+	else if (subsystem == "pci" && action != "change")
+		t = PDE_GENERIC_PCI_DEVICE;
+	else if (subsystem == "memory" && action != "change")
+		return CDspHostInfo::uhiMemory;
+
+	return t == PDE_GENERIC_DEVICE ? 0 : HI_MAKE_UPDATE_DEVICE_MASK(t);
+}
+
+// Read all pending messages from the netlink socket.
+// @return number of the messages of interest or -1 if the socket is
+// broken and must be reopened.
+static int readNetlinkSock(int sock, int protocol, quint64& mask_)
+{
+	char buf[8192];
+	int output = 0;
+
+	while(1) {
+		int s = ::recv(sock, buf, sizeof(buf) - 1, MSG_DONTWAIT);
+		if (s < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				return output;
+			// the kernel dropped messages, the caller must rescan
+			// every event driven class
+			if (errno == ENOBUFS) {
+				mask_ |= EVENT_DEVICES;
+				++output;
+				continue;
+			}
+			return -1;
+		}
+		if (s == 0) {
+			WRITE_TRACE(DBG_DEBUG, "EOF on netlink socket.");
+			return -1;
+		}
+		buf[s] = 0;
+		quint64 m = 0;
+		if (protocol != NETLINK_ROUTE)
+			m = classifyUevent(buf, s);
+		else if (isHostNetEvent(buf, s))
+			m = HI_MAKE_UPDATE_DEVICE_MASK(PDE_GENERIC_NETWORK_ADAPTER);
+
+		if (0 != m) {
+			mask_ |= m;
+			++output;
+		}
+	}
+}
+
+// Replace a broken netlink socket with a new one. The events in between
+// are lost, so the caller must rescan every event driven class.
+// @return the new socket or -1, then the socket leaves the poll set.
+static int reopenNetlinkSock(int sock, int protocol, unsigned int groups)
+{
+	WRITE_TRACE_RL(3600, DBG_FATAL, "Netlink socket %d is broken: %d, reopen it",
+		protocol, errno);
+	::close(sock);
+	int output = openNetlinkSock(protocol, groups);
+	if (output < 0) {
+		WRITE_TRACE(DBG_FATAL, "Failed to reopen netlink socket %d: %d, the events are not tracked",
+			protocol, errno);
+	}
+	return output;
+}
+
 /**
 * Starts handle device configuration changes
 */
 void CDspHwMonitorHandler::startHandleDevices()
 {
 	WRITE_TRACE( DBG_DEBUG, "Start Harware Monitor Handler" );
+	// kernel uevents, multicast group 1
+	m_uevent = openNetlinkSock(NETLINK_KOBJECT_UEVENT, UEVENT_GROUPS);
+	m_route = openNetlinkSock(NETLINK_ROUTE, ROUTE_GROUPS);
 	m_bRunFlag = TRUE;
 	QThread::start();
 }
@@ -79,212 +301,113 @@ void CDspHwMonitorHandler::stopHandleDevices()
 	if (0 != m_thread_id)
 		pthread_kill(m_thread_id, SIGUSR1);
 	QThread::wait();
+	if (m_uevent >= 0)
+		::close(m_uevent);
+	if (m_route >= 0)
+		::close(m_route);
+	m_uevent = m_route = -1;
 	WRITE_TRACE( DBG_DEBUG, "Stop Harware Monitor Handler" );
 }
 
-static const int NL_RCVBUF_SIZE = 8092;
-
-// Devices/Usb commented out by request from CP team
-//static int openNetlinkSock()
-//{
-//	int sock = ::socket(PF_NETLINK, SOCK_DGRAM, NETLINK_ROUTE);
-//	if (sock < 0)
-//		return -1;
-//
-//	int rcvbuf_size = NL_RCVBUF_SIZE;
-//	if ( ::setsockopt(sock, SOL_SOCKET, SO_RCVBUF,
-//			&rcvbuf_size, sizeof(rcvbuf_size)) < 0 ) {
-//		// Don't return an error. Just log the event.
-//		WRITE_TRACE_RL(3600, DBG_FATAL, "setsockopt for SO_RCVBUF failed with %d", errno);
-//	}
-//
-//	struct sockaddr_nl local;
-//	memset(&local, 0, sizeof(local));
-//	local.nl_family = AF_NETLINK;
-//	local.nl_groups = RTMGRP_LINK;
-//	if (::bind(sock, (struct sockaddr *)&local, sizeof(local)) < 0) {
-//		WRITE_TRACE_RL(3600, DBG_FATAL, "Failed to bind netlink_sock: %d", errno);
-//		::close(sock);
-//		return -1;
-//	}
-//
-//	return sock;
-//}
-
-// Devices/Usb commented out by request from CP team
-//// Read all messages from the network-link socket.
-//// @return -1 if some error is occured on socket.
-//static int readNetlinkSock(int sock)
-//{
-//	struct sockaddr_nl nladdr;
-//	struct iovec iov;
-//	struct msghdr msg;
-//	char buf[NL_RCVBUF_SIZE];
-//
-//	msg.msg_name = &nladdr;
-//	msg.msg_namelen = sizeof(nladdr);
-//	msg.msg_iov = &iov;
-//	msg.msg_iovlen = 1;
-//
-//	memset(&nladdr, 0, sizeof(nladdr));
-//	nladdr.nl_family = AF_NETLINK;
-//	iov.iov_base = buf;
-//
-//	// Note: we are not interested in the data and discarding the message
-//	while(1) {
-//		iov.iov_len = sizeof(buf);
-//		int s = ::recvmsg(sock, &msg, MSG_DONTWAIT);
-//		if (s < 0) {
-//			if (errno == EINTR || errno == EAGAIN)
-//				return 0;
-//			return -1;
-//		}
-//		if (s == 0) {
-//			WRITE_TRACE(DBG_DEBUG, "EOF on netlink socket.");
-//			return -1;
-//		}
-//	}
-//}
+/**
+* Returns true when device classes are tracked by kernel events
+*/
+bool CDspHwMonitorHandler::isEventDriven() const
+{
+	return m_uevent >= 0;
+}
 
 /**
 * Overridden method of thread working body
 *
-* We use poll() on /dev/prl_usb_connect and /proc/bus/usb/devices,
-* if these things exist. Also we check mtime sysfs /sys/bus/usb/devices/.
+* We use poll() on the kernel uevent and rtnetlink sockets. Events
+* usually come in bursts, so they are accumulated into a device class
+* mask which is reported once no event of interest came for a second,
+* or after 10 seconds of the steady stream of them.
 */
 void CDspHwMonitorHandler::run()
 {
-// Devices/Usb commented out by request from CP team
-//	WRITE_TRACE( DBG_FATAL, "Started Hardware Monitor thread" );
-//	m_thread_id = pthread_self();
-//
-//	enum {
-//		devs_poll_idx,
-//		prlusb_poll_idx,
-//		nl_poll_idx,
-//		poll_entries_num
-//	};
-//
-//	struct pollfd p[poll_entries_num];
-//
-//	for (int i = 0; i < poll_entries_num; ++i)
-//		p[i].fd = -1;
-//
-//	// do stat of sysfs periodically
-//	int sysfs_fd = open(PRL_USB_SYSFS_PATH, O_RDONLY);
-//
-//	time_t ts_sec = 0;
-//	int ts_nsec = 0;
-//
-//	// timeouts in milliseconds
-//	const int netEventTimeout = 100;
-//	const int pollTimeout = 1000;
-//
-//	// Network events usually come in group,
-//	// So we must not send HWChanged on each event.
-//	// On the other side, we must not keep the HwChanged event for too long.
-//	int netEventsCount = 0;
-//
-//	// Maximum number of unsent network events
-//	const int MAX_NETEVENT_COUNT = 10;
-//
-//	/* Workaround for bug/feature in linux>2.6.32: sysfs does not maintain inode attributes,
-//	 * unless someone changed the attributes with explicit vfs operation.
-//	 */
-//	(void)utimes(PRL_USB_SYSFS_PATH, NULL);
-//
-//	while (m_bRunFlag) {
-//
-//		if (p[prlusb_poll_idx].fd < 0)
-//			p[prlusb_poll_idx].fd = open(PRL_USB_CONNECT_PATH, O_RDONLY);
-//
-//		if (p[devs_poll_idx].fd < 0)
-//			p[devs_poll_idx].fd = open(PRL_USB_USBFS_PATH "/devices", O_RDONLY);
-//
-//		if (p[nl_poll_idx].fd < 0)
-//			p[nl_poll_idx].fd = openNetlinkSock();
-//
-//		// use fact that if fd is <0, it is ignored.
-//		// So we don't check whether descriptors are valid.
-//		for (int i = 0; i<poll_entries_num; ++i) {
-//			p[i].events = POLLIN;
-//			p[i].revents = 0;
-//		}
-//
-//		BOOL wake_usb = FALSE;
-//
-//		int res = poll(p, poll_entries_num,
-//						netEventsCount ? netEventTimeout : pollTimeout);
-//
-//		if (sysfs_fd >= 0) {
-//			struct stat stb;
-//
-//			if (fstat(sysfs_fd, &stb) == 0 &&
-//				(stb.st_mtim.tv_sec  != ts_sec ||
-//				 stb.st_mtim.tv_nsec != ts_nsec)) {
-//				ts_sec  = stb.st_mtim.tv_sec;
-//				ts_nsec = stb.st_mtim.tv_nsec;
-//				wake_usb = TRUE;
-//			}
-//		}
-//
-//		if (res == 0) {
-//			if (netEventsCount)
-//				netEventsCount = MAX_NETEVENT_COUNT;
-//			goto continue_loop;
-//		}
-//
-//		// not consume 100% CPU on accidental fail of poll
-//		if (res < 0) {
-//			// Errors other then EINTR are unexpected.
-//			// To process them, we are closing all fds and do sleeping.
-//			if (errno == EINTR) {
-//				res = 0;
-//				goto continue_loop;
-//			}
-//			for (int i = 0; i<poll_entries_num; ++i) {
-//				::close(p[i].fd);
-//				p[i].fd = -1;
-//			}
-//
-//			if (netEventsCount)
-//				netEventsCount = MAX_NETEVENT_COUNT;
-//
-//			goto continue_loop;
-//		}
-//
-//		if ( p[prlusb_poll_idx].revents & POLLIN
-//			|| p[devs_poll_idx].revents & POLLIN ) {
-//			wake_usb = TRUE;
-//		}
-//
-//		if (p[nl_poll_idx].revents & POLLIN) {
-//			// ToDo: Usually, there will be several network events;
-//			// We should wait some time before signaling changes.
-//			if (readNetlinkSock(p[nl_poll_idx].fd) < 0) {
-//				::close(p[nl_poll_idx].fd);
-//				p[nl_poll_idx].fd = -1;
-//			}
-//			else
-//				++netEventsCount;
-//		}
-//
-//continue_loop:
-//		if (wake_usb)
-//			onDeviceChange(PDE_USB_DEVICE, "", 2);
-//
-//		if (netEventsCount >= MAX_NETEVENT_COUNT) {
-//			netEventsCount = 0;
-//			onDeviceChange(PDE_GENERIC_NETWORK_ADAPTER, "", 1);
-//		}
-//		if (res < 0)
-//			QThread::msleep(1000);
-//	}
-//
-//	close(p[prlusb_poll_idx].fd);
-//	close(sysfs_fd);
-//	close(p[devs_poll_idx].fd);
-//	close(p[nl_poll_idx].fd);
+	WRITE_TRACE( DBG_FATAL, "Started Hardware Monitor thread" );
+	m_thread_id = pthread_self();
+
+	enum {
+		uevent_poll_idx,
+		route_poll_idx,
+		poll_entries_num
+	};
+
+	struct pollfd p[poll_entries_num];
+	p[uevent_poll_idx].fd = m_uevent;
+	p[route_poll_idx].fd = m_route;
+
+	// timeouts in milliseconds
+	const int settleTimeout = MSECS_IN_SEC;
+	const int pollTimeout = MSECS_IN_SEC;
+	// do not keep the changes for too long if events keep coming
+	const int maxDelay = 10 * MSECS_IN_SEC;
+
+	quint64 mask = 0;
+	QElapsedTimer pending, quiet;
+
+	while (m_bRunFlag) {
+		// use fact that if fd is <0, it is ignored.
+		for (int i = 0; i < poll_entries_num; ++i) {
+			p[i].events = POLLIN;
+			p[i].revents = 0;
+		}
+
+		int res = poll(p, poll_entries_num, mask ?
+			qMax<qint64>(0, settleTimeout - quiet.elapsed()) : pollTimeout);
+		if (res < 0 && errno != EINTR) {
+			WRITE_TRACE_RL(3600, DBG_FATAL, "poll on netlink sockets failed: %d", errno);
+			// not consume 100% CPU on accidental fail of poll
+			QThread::msleep(MSECS_IN_SEC);
+		}
+
+		quint64 m = mask;
+		int n = 0;
+		// an error or hangup is reported without POLLIN, the read
+		// finds it out
+		if (res > 0 && p[uevent_poll_idx].revents) {
+			int x = readNetlinkSock(p[uevent_poll_idx].fd, NETLINK_KOBJECT_UEVENT, m);
+			if (x < 0) {
+				m_uevent = p[uevent_poll_idx].fd = reopenNetlinkSock(
+					p[uevent_poll_idx].fd, NETLINK_KOBJECT_UEVENT, UEVENT_GROUPS);
+				m |= EVENT_DEVICES;
+				x = 1;
+			}
+			n += x;
+		}
+		if (res > 0 && p[route_poll_idx].revents) {
+			int x = readNetlinkSock(p[route_poll_idx].fd, NETLINK_ROUTE, m);
+			if (x < 0) {
+				m_route = p[route_poll_idx].fd = reopenNetlinkSock(
+					p[route_poll_idx].fd, NETLINK_ROUTE, ROUTE_GROUPS);
+				m |= HI_MAKE_UPDATE_DEVICE_MASK(PDE_GENERIC_NETWORK_ADAPTER);
+				x = 1;
+			}
+			n += x;
+		}
+		// the events of no interest (taps, veths) neither start nor
+		// prolong the debounce period
+		if (0 < n) {
+			if (0 == mask)
+				pending.start();
+			quiet.start();
+		}
+		mask = m;
+		if (0 == mask || (quiet.elapsed() < settleTimeout && pending.elapsed() < maxDelay))
+			continue;
+
+		for (int t = PDE_GENERIC_DEVICE + 1; t < PDE_MAX; ++t) {
+			if (mask & HI_MAKE_UPDATE_DEVICE_MASK(t))
+				onDeviceChange((PRL_DEVICE_TYPE)t, "", 1);
+		}
+		// memory and cpus are not devices
+		if (mask & (CDspHostInfo::uhiMemory | CDspHostInfo::uhiCpu))
+			emit hostChanged(mask & (CDspHostInfo::uhiMemory | CDspHostInfo::uhiCpu));
+		mask = 0;
+	}
 }
 
 /**
@@ -74,6 +74,14 @@ void CDspHwMonitorHandler::startHandleDevices()
 	QThread::start();
 }
 
+/**
+* Returns true when device changes are reported by the system events
+*/
+bool CDspHwMonitorHandler::isEventDriven() const
+{
+	return false;
+}
+
 /**
 * Stop handling device configuration changes
 */
@@ -50,18 +50,81 @@
 
 using namespace Virtuozzo;
 
-const quint64 HI_ALL_EVENT_DEVICES =
-		( CDspHostInfo::uhiUsb
-		| CDspHostInfo::uhiNet
+// Device classes scanned on the private probe. Usb and network adapters
+// carry the dispatcher state, pci list is supplied by libvirt.
+const quint64 HI_PROBE_DEVICES =
+		( CDspHostInfo::uhiCpu
+		| CDspHostInfo::uhiMemory
+		| CDspHostInfo::uhiHdd
+		| CDspHostInfo::uhiCd
+		| CDspHostInfo::uhiFloppy
+		| CDspHostInfo::uhiSerial
+		| CDspHostInfo::uhiParallel
+		| CDspHostInfo::uhiPrinter
+		| CDspHostInfo::uhiScsi
 		);
 
+namespace
+{
+template<class T>
+QStringList digest(const QList<T* >& list_)
+{
+	QStringList output;
+	foreach (T* d, list_)
+		output << d->getDeviceId() + '\t' + d->getDeviceName();
+
+	return output;
+}
+
+QStringList digest(CHostHardwareInfo& info_, quint64 class_)
+{
+	QStringList output;
+	switch (class_)
+	{
+	case CDspHostInfo::uhiCpu:
+		if (NULL != info_.getCpu())
+		{
+			output << info_.getCpu()->getModel()
+				<< QString::number(info_.getCpu()->getNumber());
+		}
+		break;
+	case CDspHostInfo::uhiMemory:
+		// https://jira.sw.ru/browse/PDFM-20092
+		// Exclude non-hardware information
+		output << QString::number(info_.getMemorySettings()->getHostRamSize());
+		break;
+	case CDspHostInfo::uhiHdd:
+		return digest(info_.m_lstHardDisks);
+	case CDspHostInfo::uhiCd:
+		return digest(info_.m_lstOpticalDisks);
+	case CDspHostInfo::uhiFloppy:
+		return digest(info_.m_lstFloppyDisks);
+	case CDspHostInfo::uhiSerial:
+		return digest(info_.m_lstSerialPorts);
+	case CDspHostInfo::uhiParallel:
+		return digest(info_.m_lstParallelPorts);
+	case CDspHostInfo::uhiPrinter:
+		return digest(info_.m_lstPrinters);
+	case CDspHostInfo::uhiScsi:
+		return digest(info_.m_lstGenericScsiDevices);
+	}
+	return output;
+}
+
+} // namespace
+
 /*
 * Class default constructor
 */
 CDspHwMonitorNotifier::CDspHwMonitorNotifier ()
 	: m_mtxUsbExcludeDev(QMutex::Recursive)
 	, m_delayedRefreshFlags(0)
+	, m_probe(new CDspHostInfo)
 {
+	// the first scan only remembers the device classes state
+	m_probe->updateData(0);
+	probe(HI_PROBE_DEVICES);
+
 	//https://bugzilla.sw.ru/show_bug.cgi?id=444188
 	//Init USB authentic data
 	{
@@ -120,39 +183,54 @@ void CDspHwMonitorNotifier::onCheckHwChanges()
 	CPowerWatcher::CNoSleepLocker nosleep;
 	if ( CPowerWatcher::isSleeping() )
 	{
-		m_delayedRefreshFlags |= (~HI_ALL_EVENT_DEVICES);
+		// the probe keeps its own baseline, changes will be found on the next check
 		WRITE_TRACE(DBG_FATAL,
 			"Check HW changes: skip refresh (system sleeping), mask = 0x%llx",
 			m_delayedRefreshFlags);
 		return;
 	}
-	bool bChanged = false;
+	// scan without holding the shared host info, it is locked
+	// only when some device class was really changed
+	quint64 f = probe(HI_PROBE_DEVICES) | m_delayedRefreshFlags;
+	m_delayedRefreshFlags = 0;
+	bool bChanged = (0 != f);
+	if( bChanged )
 	{
-		CDspLockedPointer<CDspHostInfo> p_lockedHostInfo = CDspService::instance()->getHostInfo();
-		SmartPtr< CHostHardwareInfo > pOldHostInfo( new CHostHardwareInfo( p_lockedHostInfo->data() ) );
-
-		p_lockedHostInfo->refresh( m_delayedRefreshFlags | (~HI_ALL_EVENT_DEVICES) );
-		m_delayedRefreshFlags = 0;
-
-		SmartPtr< CHostHardwareInfo > pNewHostInfo( new CHostHardwareInfo( p_lockedHostInfo->data() ) );
-
-		// https://jira.sw.ru/browse/PDFM-20092
-		// Exclude non-hardware information
-		pOldHostInfo->getMemorySettings()->setAdvancedMemoryInfo(0);
-		pNewHostInfo->getMemorySettings()->setAdvancedMemoryInfo(0);
-
-		// copy to prevent deadlock ( notifyVms() / notifyClients() locks its mutex )
-		if( pNewHostInfo->toString() != pOldHostInfo->toString() )
-		{
-			WRITE_TRACE(DBG_FATAL, "Hardware Configuration was changed !" );
-			bChanged = true;
-		}
+		WRITE_TRACE(DBG_FATAL, "Hardware Configuration was changed, mask = 0x%llx", f );
+		CDspService::instance()->getHostInfo()->refresh( f );
 	}
 
 	if( bChanged )
 		onDeviceChange();
 }
 
+/*
+* Process hostChanged signal: memory or cpus were hotplugged
+*/
+void CDspHwMonitorNotifier::onHostChange(quint64 mask_)
+{
+	CPowerWatcher::CNoSleepLocker nosleep;
+	if ( CPowerWatcher::isSleeping() )
+	{
+		m_delayedRefreshFlags |= mask_;
+		WRITE_TRACE(DBG_FATAL,
+			"Host change: skip refresh (system sleeping), mask = 0x%llx",
+			m_delayedRefreshFlags);
+		return;
+	}
+	// unlike devices these are refreshed regardless of clients: the
+	// snapshot served on request is never rescanned
+	quint64 f = probe(mask_ & HI_PROBE_DEVICES);
+	if ( 0 == f )
+	{
+		WRITE_TRACE(DBG_FATAL, "Host change: no changes found, mask = 0x%llx", mask_);
+		return;
+	}
+	WRITE_TRACE(DBG_FATAL, "Host configuration was changed, mask = 0x%llx", f );
+	CDspService::instance()->getHostInfo()->refresh( f );
+	onDeviceChange();
+}
+
 /*
 * Process deviceChanged signal
 */
@@ -173,20 +251,25 @@ void CDspHwMonitorNotifier::onDeviceChange(PRL_DEVICE_TYPE dev_type, QString dev
 		return;
 	}
 
-	// #PDFM-26528
-	bool bRefreshHostInfo =
-			dev_type == PDE_USB_DEVICE
-		||
-			// skip double refresh host info after onCheckHwChanges() call
-			// and do not refresh host info if there are no clients and no running VMs
-			( dev_type != PDE_GENERIC_DEVICE && hasConnectedClientsOrRunningVMs() );
+	// skip double refresh host info after onCheckHwChanges() call.
+	// NB. the events are debounced and the snapshot served on request is
+	// never rescanned, so refresh even if there are no clients and no
+	// running VMs (#PDFM-26528 was about the periodic rescan)
+	bool bRefreshHostInfo = ( dev_type != PDE_GENERIC_DEVICE );
+
+	quint64 f = HI_MAKE_UPDATE_DEVICE_MASK(dev_type);
+	if ( bRefreshHostInfo && (f & HI_PROBE_DEVICES) && 0 == probe(f) )
+	{
+		WRITE_TRACE(DBG_FATAL, "Device change: no changes found for dev_type = %d", (int)dev_type);
+		return;
+	}
 
 	SmartPtr< CHostHardwareInfo > pHostInfo;
 	{
 		CDspLockedPointer<CDspHostInfo> p_lockedHostInfo = CDspService::instance()->getHostInfo();
 
 		if ( bRefreshHostInfo )
-			p_lockedHostInfo->refresh(HI_MAKE_UPDATE_DEVICE_MASK(dev_type));
+			p_lockedHostInfo->refresh(f);
 		else
 			WRITE_TRACE(DBG_FATAL, "Device change: host hardware info refreshing was skipped !");
 
@@ -713,6 +796,7 @@ void CDspHwMonitorNotifier::processVmStop( const CVmIdent & ident, CDspLockedPoi
 					QSTR2UTF8( pUsbDevice->getDeviceId() ),
 					lstVmUuids.size() );
 	}
+	spHostInfo->touch();
 }
 
 void CDspHwMonitorNotifier::processPrinterChange( const SmartPtr< CHostHardwareInfo >& pHostInfo )
@@ -801,6 +885,25 @@ void CDspHwMonitorNotifier::sendPrinterChangeNotifyToVms( const SmartPtr<CHwPrin
 		, PUDT_OTHER, changed_flags, pDev->toString() );
 }
 
+quint64 CDspHwMonitorNotifier::probe(quint64 mask_)
+{
+	m_probe->refresh(mask_);
+
+	quint64 output = 0;
+	for (quint64 c = 1; c != 0 && c <= HI_PROBE_DEVICES; c <<= 1)
+	{
+		if (!(c & HI_PROBE_DEVICES & mask_))
+			continue;
+
+		QStringList d = digest(*m_probe->data(), c);
+		if (m_digest.contains(c) && m_digest[c] != d)
+			output |= c;
+
+		m_digest[c] = d;
+	}
+	return output;
+}
+
 bool CDspHwMonitorNotifier::hasConnectedClientsOrRunningVMs() const
 {
 	return ! CDspService::instance()->getClientManager().getSessionsListSnapshot().isEmpty()
@@ -42,6 +42,7 @@
 #include <QMutex>
 #include <QPair>
 #include <QHash>
+#include <QScopedPointer>
 #include "CDspClient.h"
 #include <prlxmlmodel/HostHardwareInfo/CHwGenericPciDevice.h>
 
@@ -102,6 +103,12 @@ private:
 
 	quint64 m_delayedRefreshFlags;
 
+	/** Private host info scanned without locking the shared one */
+	QScopedPointer<CDspHostInfo> m_probe;
+
+	/** Per device class digest of the last probe scan */
+	QHash<quint64, QStringList> m_digest;
+
 private:
 	/** Notify connected clients */
 	void notifyClients();
@@ -146,6 +153,9 @@ private slots:
 						QString dev_name = "",
 						unsigned int event_code = 0);
 
+	/** Process hostChanged signal */
+	void onHostChange(quint64 mask_);
+
 private:
 	void processUsbDeviceChange( const SmartPtr< CHostHardwareInfo >& pHostInfo
 		, const CUsbAuthenticNameList& lstAuth
@@ -154,6 +164,9 @@ private:
 	void processPrinterChange( const SmartPtr< CHostHardwareInfo >& pHostInfo );
 
 	bool hasConnectedClientsOrRunningVMs() const;
+
+	/** Rescan the device classes on the probe, returns mask of the changed ones */
+	quint64 probe(quint64 mask_);
 };
 
 #endif//_DSP_HW_MONITOR_NOTIFIER_H_
@@ -44,6 +44,8 @@
 #include <Libraries/CpuFeatures/CCpuHelper.h>
 
 #define CHECK_HW_INTERVAL_IN_MSEC  (5 * 60 * 1000)
+// safety net rescan when device changes are reported by kernel events
+#define CHECK_HW_SAFETY_INTERVAL_IN_MSEC  (30 * 60 * 1000)
 
 
 CDspHwMonitorThread::CDspHwMonitorThread()
@@ -75,6 +77,13 @@ void CDspHwMonitorThread::run()
 		);
 		PRL_ASSERT(bConnected);
 
+		bConnected = connect( pHwMonitorHandler
+			, SIGNAL( hostChanged(quint64) )
+			, m_pNotifier
+			, SLOT( onHostChange(quint64) )
+		);
+		PRL_ASSERT(bConnected);
+
 		bConnected = pHwMonitorHandler->connect(CDspService::instance(),
 			SIGNAL(onConfigChanged(const SmartPtr<CDispCommonPreferences>,
 					const SmartPtr<CDispCommonPreferences>)),
@@ -96,7 +105,8 @@ void CDspHwMonitorThread::run()
 
 		Q_UNUSED(bConnected);
 
-		m_pTimer->start( CHECK_HW_INTERVAL_IN_MSEC );
+		m_pTimer->start( pHwMonitorHandler->isEventDriven() ?
+			CHECK_HW_SAFETY_INTERVAL_IN_MSEC : CHECK_HW_INTERVAL_IN_MSEC );
 
 		// Start thread's event loop needed for QTimer
 		QThread::exec();
@@ -43,6 +43,8 @@
 #include "CDspStatStorage.h"
 #include "CDspLibvirt.h"
 #include "CDspLibvirtExec.h"
+#include "CDspExecutor.h"
+#include "CDspVmGuest.h"
 #include <prlcommon/ProtoSerializer/CProtoSerializer.h>
 #include <prlsdk/PrlPerfCounters.h>
 #include <prlsdk/PrlIOStructs.h>
@@ -160,11 +162,20 @@ bool Vm::operator()()
 	if (PTS_INSTALLED != t && PTS_OUTDATED != t)
 		return false;
 
+	::Vm::Guest::Breaker& b = ::Vm::Guest::Breaker::instance();
+	// the stale statistics are reported by the guest.fs.stale counter
+	if (b.isOpen(m_ident.first))
+		return false;
+
 	Libvirt::Instrument::Agent::Vm::Unit u = Libvirt::Kit.vms().at(m_ident.first);
 	Prl::Expected< QList<boost::tuple<quint64,quint64,QString,QString,QString> >,
 		::Error::Simple> r = u.getGuest().getFsInfo();
 	if (r.isFailed())
+	{
+		b.trip(m_ident.first);
 		return false;
+	}
+	b.pass(m_ident.first);
 
 	QSharedPointer<Stat::Storage> s = m_access.getStorage().toStrongRef();
 	if (s.isNull())
@@ -198,7 +209,7 @@ bool Vm::operator()()
 // struct Farmer
 
 Farmer::Farmer(const CVmIdent& ident_, getAccess_type access_):
-	m_timer(startTimer(0)), m_ident(ident_), m_getAccess(access_)
+	m_timer(startTimer(jitter(0))), m_ident(ident_), m_getAccess(access_)
 {
 	qint64 c = CDspService::instance()->getDispConfigGuard()
 		.getDispWorkSpacePrefs()->getVmGuestCollectPeriod() * 1000;
@@ -210,16 +221,18 @@ void Farmer::reset()
 	if (!m_watcher)
 		return;
 	if (sender() == m_watcher.data()) {
-		if (!m_watcher->result()) {
+		if (!m_watcher->result() &&
+			!::Vm::Guest::Breaker::instance().isOpen(m_ident.first)) {
 			/* error, doubling polling period */
 			m_period *= 2;
 			if (m_period > STAT_COLLECTING_FS_TIMEOUT_MAX)
 				m_period = STAT_COLLECTING_FS_TIMEOUT_MAX;
 		} else {
-			/* success, polling with initial period */
+			/* success or the guest agent breaker spaces the
+			 * calls, polling with initial period */
 			m_period = m_initialPeriod;
 		}
-		m_timer = startTimer(m_period);	
+		m_timer = startTimer(jitter(m_period));
 	}
 	m_watcher->disconnect(this, SLOT(reset()));
 	m_watcher->waitForFinished();
@@ -240,7 +253,13 @@ void Farmer::handle(unsigned state_, QString uuid_, QString dir_, bool flag_)
 	if (0 != m_timer)
 		killTimer(m_timer);
 
-	m_timer = VMS_RUNNING == state_ ? startTimer(0) : 0;
+	m_timer = VMS_RUNNING == state_ ? startTimer(jitter(0)) : 0;
+}
+
+int Farmer::jitter(quint64 period_)
+{
+	// spread the probes of VMs started at once over time
+	return period_ + qrand() % (period_ / 10 + STAT_COLLECTING_FS_SPREAD);
 }
 
 void Farmer::timerEvent(QTimerEvent *event_)
@@ -254,9 +273,16 @@ void Farmer::timerEvent(QTimerEvent *event_)
 		PRL_VM_TYPE t = PVT_VM;
 		CDspService::instance()->getVmDirManager().getVmTypeByUuid(m_ident.first, t);
 		if (PVT_VM == t)
-			m_watcher->setFuture(QtConcurrent::run(Harvester::Vm(m_ident, m_getAccess())));
+		{
+			// the guest agent calls share the limit with the tools probes
+			m_watcher->setFuture(Executor::get(Executor::GUEST)
+				.run(Harvester::Vm(m_ident, m_getAccess())));
+		}
 		else
-			m_watcher->setFuture(QtConcurrent::run(Harvester::Ct(m_ident.first)));
+		{
+			m_watcher->setFuture(Executor::get(Executor::STATISTICS)
+				.run(Harvester::Ct(m_ident.first)));
+		}
 	}
 }
 
@@ -843,6 +869,9 @@ struct Perf: private perfList_type
 	QList<CVmIdent> select(const mapped_type& user_) const;
 	template<class P>
 	void report(P provider_);
+	Demand::map_type getDemand() const;
+
+	static unsigned getGroups(const QString& filter_);
 };
 
 void Perf::remove(const CVmIdent& vm_, const mapped_type& user_)
@@ -899,6 +928,56 @@ QList<CVmIdent> Perf::select(const mapped_type& user_) const
 	return output;
 }
 
+Demand::map_type Perf::getDemand() const
+{
+	Demand::map_type output;
+	for (const_iterator p = begin(), e = end(); p != e; ++p)
+	{
+		// the dispatcher counters do not come from libvirt
+		if (IsValidVmIdent(p->first.first))
+			output[p->first.first.first] |= getGroups(p->first.second);
+	}
+	return output;
+}
+
+unsigned Perf::getGroups(const QString& filter_)
+{
+	// the literal head of the filter is compared with the counter names
+	// of every group. this errs on the side of sampling too much.
+	QString h = filter_.left(filter_.indexOf(QRegExp("[*#]")));
+	if (h.isEmpty())
+		return Demand::ALL;
+
+	typedef QPair<unsigned, QString> name_type;
+	QList<name_type> n;
+	n << name_type(Demand::CPU, PRL_GUEST_CPU_USAGE_PTRN)
+		<< name_type(Demand::CPU, PRL_GUEST_CPU_TIME_PTRN)
+		<< name_type(Demand::CPU, PRL_HOST_CPU_TIME_PTRN)
+		<< name_type(Demand::VCPU, "guest.vcpu")
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_USAGE_PTRN)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_CACHED_PTRN)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_TOTAL_PTRN)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_BALLOON_ACTUAL)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_AVAILABLE)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_SWAP_IN)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_SWAP_OUT)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_MINOR_FAULT)
+		<< name_type(Demand::BALLOON, PRL_GUEST_RAM_MAJOR_FAULT)
+		<< name_type(Demand::INTERFACE, "net.nic")
+		<< name_type(Demand::INTERFACE, PRL_NET_CLASSFUL_TRAFFIC_IPV4_PTRN)
+		<< name_type(Demand::INTERFACE, PRL_NET_CLASSFUL_TRAFFIC_IPV6_PTRN)
+		<< name_type(Demand::INTERFACE, PRL_NET_CLASSFUL_TRAFFIC_PTRN)
+		<< name_type(Demand::BLOCK, "devices.");
+
+	unsigned output = 0;
+	foreach (const name_type& x, n)
+	{
+		if (h.startsWith(x.second) || x.second.startsWith(h))
+			output |= x.first;
+	}
+	return output;
+}
+
 namespace Counter
 {
 ///////////////////////////////////////////////////////////////////////////////
@@ -1432,6 +1511,34 @@ CVmEventParameter *ClassfulOnline<Flavor>::getParam() const
 }
 
 } // namespace Network
+
+///////////////////////////////////////////////////////////////////////////////
+// struct FsStaleness
+
+struct FsStaleness
+{
+	explicit FsStaleness(const QString& uuid_): m_uuid(uuid_)
+	{
+	}
+
+	static const char* getName()
+	{
+		return "guest.fs.stale";
+	}
+
+	CVmEventParameter *getParam() const
+	{
+		qint64 s = ::Vm::Guest::Breaker::instance().getStaleness(m_uuid);
+		if (0 > s)
+			return NULL;
+
+		return Conversion::Uint64::convert(s);
+	}
+
+private:
+	const QString m_uuid;
+};
+
 } // namespace Counter
 } // namespace
 } // namespace Vm
@@ -2070,6 +2177,31 @@ typedef ::Stat::Counter::Enumerable<Names::Filesystem::MountPoint, Flavor> Mount
 namespace
 {
 
+///////////////////////////////////////////////////////////////////////////////
+// struct DispatcherCounter
+
+struct DispatcherCounter
+{
+	DispatcherCounter(const QString& name_, quint64 value_):
+		m_name(name_), m_value(value_)
+	{
+	}
+
+	QString getName() const
+	{
+		return m_name;
+	}
+
+	CVmEventParameter *getParam() const
+	{
+		return Conversion::Uint64::convert(m_value);
+	}
+
+private:
+	QString m_name;
+	quint64 m_value;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Collector
 
@@ -2082,6 +2214,7 @@ struct Collector {
 	void collectVm(const QString &uuid, const CVmConfiguration &config);
 
 	void collectVmOffline(const QString &uuid_);
+	void collectDispatcher();
 private:
 
 	template <typename Counter>
@@ -2237,6 +2370,7 @@ void Collector::collectVm(const QString &uuid, const CVmConfiguration &config)
 		collect(ctc::Filesystem::MountPoint(i, fs));
 
 	}
+	collect(vmc::FsStaleness(uuid));
 }
 
 void Collector::collectVmOffline(const QString &uuid_)
@@ -2247,6 +2381,23 @@ void Collector::collectVmOffline(const QString &uuid_)
 	collect(Vm::Counter::Network::ClassfulOffline<ext::Total>(uuid_));
 }
 
+void Collector::collectDispatcher()
+{
+	Stat::Counters::map_type m = Stat::Counters::getValue();
+	for (Stat::Counters::map_type::const_iterator p = m.constBegin(); p != m.constEnd(); ++p)
+		collect(DispatcherCounter(p.key(), p.value()));
+
+	// the executor gauges are read as they are now
+	for (int i = 0; i < Executor::KIND_MAX; ++i)
+	{
+		const Executor::Pool& p = Executor::get(static_cast<Executor::Kind>(i));
+		QString n = QString("executor.%1.").arg(p.getName());
+		collect(DispatcherCounter(n + "queued", p.getGauge().getQueued()));
+		collect(DispatcherCounter(n + "active", p.getGauge().getActive()));
+		collect(DispatcherCounter(n + "peak", p.getGauge().getPeak()));
+	}
+}
+
 template <typename Counter>
 void Collector::collect(const Counter &c)
 {
@@ -2343,6 +2494,21 @@ bool CDspStatCollectingThread::ExistPerfCountersSubscribers()
 	return !g_pPerfStatsSubscribers->empty();
 }
 
+void CDspStatCollectingThread::publishDemand()
+{
+	QMutexLocker _lock(g_pSubscribersMutex);
+	Stat::Demand::map_type d = g_pPerfStatsSubscribers->getDemand();
+	VmStatisticsSubscribersMap::const_iterator e = g_pVmsGuestStatisticsSubscribers->end();
+	VmStatisticsSubscribersMap::const_iterator p = g_pVmsGuestStatisticsSubscribers->begin();
+	for (; p != e; ++p)
+		d[p->first.first] |= Stat::Demand::ALL;
+
+	foreach (const CVmIdent& k, g_pVmStatGetters->keys())
+		d[k.first] |= Stat::Demand::ALL;
+
+	Stat::Demand::publish(d);
+}
+
 void CDspStatCollectingThread::timerEvent(QTimerEvent* event_)
 {
 	COMMON_TRY
@@ -2361,6 +2527,7 @@ void CDspStatCollectingThread::timerEvent(QTimerEvent* event_)
 		}
 
 		QMutexLocker _lock(g_pSubscribersMutex);
+		publishDemand();
 		bool bDoPerfStats = ExistPerfCountersSubscribers();
 		bool bDoStats = ExistStatSubscribers();
 		if (bDoStats)
@@ -2800,6 +2967,10 @@ void CDspStatCollectingThread::SendPerfStatsRequest(const SmartPtr<CDspClient> &
 
 		vm_ident = pUser->getVmIdent(sVmUuid) ;
 	}
+	// keep the counters fresh for the pollers
+	if (IsValidVmIdent(vm_ident))
+		Stat::Demand::lease(vm_ident.first, Stat::Perf::getGroups(sFilter));
+
 	SmartPtr<CVmEvent> pPerfCountersEvent(GetPerformanceStatistics(vm_ident, sFilter)) ;
 	if (!pPerfCountersEvent.isValid() || PRL_FAILED(pPerfCountersEvent->getEventCode())) {
 		PRL_RESULT nRetCode = pPerfCountersEvent.isValid() ? pPerfCountersEvent->getEventCode() : PRL_ERR_FAILURE;
@@ -2913,6 +3084,7 @@ SmartPtr<CVmEvent> CDspStatCollectingThread::GetPerformanceStatistics(const CVmI
 		QString uuid = CDspService::instance()->getDispConfigGuard().
 			getDispConfig()->getVmServerIdentification()->getServerUuid() ;
 		SmartPtr<CVmEvent> e(new CVmEvent(PET_DSP_EVT_PERFSTATS, uuid, PIE_DISPATCHER));
+		Collector(filter, *e).collectDispatcher();
 		e->setEventCode(PRL_ERR_SUCCESS);
 		return e;
 	}
@@ -2979,6 +3151,7 @@ void CDspStatCollectingThread::SendVmGuestStatistics(
 	SmartPtr<CDspClient> &pUser,
 	const SmartPtr<IOPackage>& p )
 {
+	Stat::Demand::lease(sVmUuid, Stat::Demand::ALL);
 	if( IsAvalableStatisctic() )
 	{
 		// send response
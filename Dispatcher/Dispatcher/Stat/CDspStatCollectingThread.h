@@ -105,7 +105,8 @@ class Farmer: public QObject
 		 * #PSBM-53264
 		 */
 		STAT_COLLECTING_FS_TIMEOUT_MIN = 10*1000,
-		STAT_COLLECTING_FS_TIMEOUT_MAX = 3600*1000
+		STAT_COLLECTING_FS_TIMEOUT_MAX = 3600*1000,
+		STAT_COLLECTING_FS_SPREAD = 2*1000
 	};
 
 	Q_OBJECT
@@ -120,6 +121,8 @@ protected:
 	void timerEvent(QTimerEvent* event_);
 
 private:
+	static int jitter(quint64 period_);
+
 	int m_timer;
 	quint64 m_period;
 	quint64 m_initialPeriod;
@@ -323,6 +326,7 @@ private:
 		const SmartPtr<IOPackage>& p,
 		const QString& statAsString );
 	static void schedule();
+	static void publishDemand();
 
 	explicit CDspStatCollectingThread(Registry::Public& registry_);
 
@@ -33,6 +33,7 @@
 #include <QPair>
 #include <boost/foreach.hpp>
 #include <prlcommon/Interfaces/VirtuozzoQt.h>
+#include <prlcommon/Std/PrlTime.h>
 #include "CDspStatStorage.h"
 
 namespace Stat
@@ -88,6 +89,91 @@ void Storage::write(const QString& name_, quint64 value_, quint64 time_)
 		m_incremental[name_] = timedValue_type(value_, time_);
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Demand
+
+QMutex Demand::s_mutex;
+Demand::map_type Demand::s_published;
+Demand::lease_type Demand::s_leased;
+
+void Demand::publish(const map_type& value_)
+{
+	QMutexLocker l(&s_mutex);
+	s_published = value_;
+}
+
+bool Demand::lease(const QString& uuid_, unsigned groups_)
+{
+	quint64 n = PrlGetTimeMonotonic();
+	quint64 t = n + LEASE_TIMEOUT;
+	QMutexLocker l(&s_mutex);
+	bool output = 0 == (s_published.value(uuid_) & groups_);
+	for (unsigned g = 1; g <= groups_; g <<= 1)
+	{
+		if (0 == (g & groups_))
+			continue;
+
+		quint64& x = s_leased[qMakePair(uuid_, g)];
+		if (n <= x)
+			output = false;
+
+		x = t;
+	}
+
+	return output;
+}
+
+Demand::map_type Demand::getValue()
+{
+	quint64 t = PrlGetTimeMonotonic();
+	QMutexLocker l(&s_mutex);
+	map_type output = s_published;
+	lease_type::iterator p = s_leased.begin();
+	while (p != s_leased.end())
+	{
+		if (p.value() < t)
+		{
+			p = s_leased.erase(p);
+			continue;
+		}
+		output[p.key().first] |= p.key().second;
+		++p;
+	}
+
+	return output;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Counters
+
+QMutex Counters::s_mutex;
+Counters::map_type Counters::s_value;
+
+void Counters::set(const QString& name_, quint64 value_)
+{
+	QMutexLocker l(&s_mutex);
+	s_value[name_] = value_;
+}
+
+void Counters::add(const QString& name_, quint64 delta_)
+{
+	QMutexLocker l(&s_mutex);
+	s_value[name_] += delta_;
+}
+
+void Counters::raise(const QString& name_, quint64 value_)
+{
+	QMutexLocker l(&s_mutex);
+	quint64& x = s_value[name_];
+	x = qMax(x, value_);
+}
+
+Counters::map_type Counters::getValue()
+{
+	QMutexLocker l(&s_mutex);
+	return s_value;
+}
+
 namespace Name
 {
 
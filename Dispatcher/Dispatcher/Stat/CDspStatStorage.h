@@ -35,6 +35,7 @@
 
 #include <QPair>
 #include <QHash>
+#include <QMutex>
 #include <QString>
 #include <QReadWriteLock>
 #include <prlxmlmodel/VmConfig/CVmConfiguration.h>
@@ -65,6 +66,65 @@ private:
 	hash_type m_incremental;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Demand
+// Groups of the VM performance counters wanted by the consumers of the
+// storages. Standing subscriptions are published as a whole by the stat
+// collecting thread, one-shot readers lease groups for a while.
+
+struct Demand
+{
+	enum
+	{
+		CPU = 1,
+		BALLOON = 2,
+		VCPU = 4,
+		INTERFACE = 8,
+		BLOCK = 16,
+		ALL = CPU | BALLOON | VCPU | INTERFACE | BLOCK
+	};
+
+	enum
+	{
+		// usec
+		LEASE_TIMEOUT = 120000000
+	};
+
+	typedef QHash<QString, unsigned> map_type;
+
+	static void publish(const map_type& value_);
+	// returns true when none of the groups was wanted for the VM before,
+	// i.e. the sampled values may be arbitrary old
+	static bool lease(const QString& uuid_, unsigned groups_);
+	static map_type getValue();
+
+private:
+	typedef QHash<QPair<QString, unsigned>, quint64> lease_type;
+
+	static QMutex s_mutex;
+	static map_type s_published;
+	static lease_type s_leased;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Counters
+// Counters of the dispatcher itself. They are reported by the performance
+// statistics request for the dispatcher, i.e. without a VM uuid.
+
+struct Counters
+{
+	typedef QHash<QString, quint64> map_type;
+
+	static void set(const QString& name_, quint64 value_);
+	static void add(const QString& name_, quint64 delta_);
+	static void raise(const QString& name_, quint64 value_);
+	static map_type getValue();
+
+private:
+	static QMutex s_mutex;
+	static map_type s_value;
+};
+
 namespace Name
 {
 
@@ -1415,6 +1415,10 @@ void Connector::reactAccept()
 	{
 		a = QSharedPointer<QTcpSocket>(s->nextPendingConnection());
 		a->setReadBufferSize(1 << 24);
+		// a reply comes out of the tunnel in pieces and the client waits
+		// for all of them before the next request. with Nagle the piece
+		// after the first one waits for the delayed ACK of the client
+		a->setSocketOption(QAbstractSocket::LowDelayOption, 1);
 		a->setProperty("channel", s->property("channel"));
 		handle(a);
 	}
@@ -1581,15 +1585,23 @@ Factory::result_type Factory::operator()(quint32 flags_) const
 {
 	value_type output;
 	if (flags_ & PBT_DIRECT_DATA_CONNECTION)
+	{
+		WRITE_TRACE(DBG_INFO, "backup data go directly to %s on request", qPrintable(m_target));
 		return output;
+	}
 
 	CDispBackupSourcePreferences* pPref = CDspService::instance()->getDispConfigGuard().getDispCommonPrefs()->getBackupSourcePreferences();
 	if (!pPref->isTunnel())
-			return output;
+	{
+		WRITE_TRACE(DBG_INFO, "backup data go directly to %s by preferences", qPrintable(m_target));
+		return output;
+	}
 
 	if (CDspService::instance()->getShellServiceHelper().isLocalAddress(m_target))
 		return output;
 
+	WRITE_TRACE(DBG_INFO, "backup data go to %s through the dispatcher tunnel", qPrintable(m_target));
+
 	output = value_type(new Unit());
 	PRL_RESULT e = (*output)(m_channel);
 	if (PRL_FAILED(e))
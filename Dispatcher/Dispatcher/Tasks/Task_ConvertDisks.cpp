@@ -39,6 +39,7 @@
 #include "CDspService.h"
 #include "CDspVmSnapshotStoreHelper.h"
 #include "EditHelpers/CMultiEditMergeVmConfig.h"
+#include <QEventLoop>
 
 QMutex						Task_ConvertDisks::s_lockConvertDisks;
 QMap<CVmIdent , QString >	Task_ConvertDisks::s_mapVmIdTaskId;
@@ -54,19 +55,16 @@ Task_ConvertDisks::Task_ConvertDisks(const SmartPtr<CDspClient>& pClient,
   m_nFlags(nFlags),
   m_bVmConfigWasChanged(false),
   m_flgLockRegistered(false),
-  m_pProcess(0),
-  m_nCurHddIndex((unsigned int )-1),
-  m_nCurHddItemId(0)
+  m_pLoop(0),
+  m_nConverted(0),
+  m_nTotalSize(0),
+  m_nTotalPercent(0)
 {
 }
 
 Task_ConvertDisks::~Task_ConvertDisks()
 {
-	if ( m_pProcess )
-	{
-		delete m_pProcess;
-		m_pProcess = 0;
-	}
+	qDeleteAll(m_mapRunning.keys());
 }
 
 PRL_RESULT Task_ConvertDisks::prepareTask()
@@ -132,18 +130,6 @@ PRL_RESULT Task_ConvertDisks::prepareTask()
 									QSTR2UTF8(m_qsDTName) );
 			throw PRL_ERR_DISK_TOOL_NOT_FOUND;
 		}
-
-		// Success
-
-		m_pProcess = new QProcess;
-		connect( m_pProcess, SIGNAL(readyReadStandardError()), this, SLOT(onReadyReadStandardError()),
-			Qt::DirectConnection );
-		connect( m_pProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(onReadyReadStandardOutput()),
-			Qt::DirectConnection);
-		connect( m_pProcess,
-			SIGNAL(finished(int , QProcess::ExitStatus)), this,
-			SLOT(onFinished(int, QProcess::ExitStatus)),
-			Qt::DirectConnection);
 	}
 	catch (PRL_RESULT code)
 	{
@@ -205,7 +191,8 @@ void Task_ConvertDisks::finalizeTask()
 
 		if ( ! qsVmHome.isEmpty() )
 		{
-			QMutexLocker lock(CDspService::instance()->getVmDirHelper().getMultiEditDispatcher());
+			CMultiEditDispatcher::CommitLocker lock(CDspService::instance()->getVmDirHelper()
+				.getMultiEditDispatcher(), m_vmIdent.first);
 			const IOSender::Handle
 				hFakeClientHandle = QString("%1-%2").arg( m_vmIdent.second ).arg( m_vmIdent.first );
 
@@ -253,20 +240,26 @@ void Task_ConvertDisks::cancelOperation(SmartPtr<CDspClient> pUserSession, const
 {
 	CancelOperationSupport::cancelOperation(pUserSession, p);
 
-	if (m_pProcess)
+	// the disks that are done already stay converted
+	QMutexLocker lock(&m_lockRunning);
+	foreach (QProcess* pProcess, m_mapRunning.keys())
+	{
 #ifdef _WIN_
 		// FIXME: Do graceful cancel for disk tool when it'll be implemented
-		m_pProcess->kill();
+		pProcess->kill();
 #else
-		m_pProcess->terminate();
+		pProcess->terminate();
 #endif
+	}
 }
 
 void Task_ConvertDisks::onReadyReadStandardError()
 {
-	if ( m_pProcess && PRL_SUCCEEDED(getLastErrorCode()) && ! operationIsCancelled() )
+	QProcess* pProcess = qobject_cast<QProcess* >(sender());
+	if ( pProcess && PRL_SUCCEEDED(getLastErrorCode()) && ! operationIsCancelled() )
 	{
-		QString qsErrOut = UTF8_2QSTR(m_pProcess->readAllStandardError().constData());
+		m_setFailed.insert(pProcess);
+		QString qsErrOut = UTF8_2QSTR(pProcess->readAllStandardError().constData());
 
 		WRITE_TRACE(DBG_FATAL, "Convert disks: disk tool internal error: %s !",
 						QSTR2UTF8(qsErrOut));
@@ -279,16 +272,24 @@ void Task_ConvertDisks::onReadyReadStandardError()
 
 void Task_ConvertDisks::onReadyReadStandardOutput()
 {
-	if ( ! m_pProcess )
+	QProcess* pProcess = qobject_cast<QProcess* >(sender());
+	if ( ! pProcess )
 		return;
 
-	QString qsOutput = UTF8_2QSTR(m_pProcess->readAllStandardOutput().constData());
+	QString qsOutput = UTF8_2QSTR(pProcess->readAllStandardOutput().constData());
 
-	sendCoversionProgressParams(qsOutput);
+	sendCoversionProgressParams(qsOutput, m_mapRunning.value(pProcess));
 }
 
 void Task_ConvertDisks::onFinished( int nExitCode, QProcess::ExitStatus nExitStatus )
 {
+	QProcess* pProcess = qobject_cast<QProcess* >(sender());
+	CVmHardDisk* pHdd = m_mapRunning.value(pProcess);
+	if ( ! pHdd )
+		return;
+
+	WRITE_TRACE(DBG_WARNING, "Convert disks: disk tool was stopped for '%s' !",
+				QSTR2UTF8(pHdd->getSystemName()));
 	if ( nExitStatus == QProcess::CrashExit )
 	{
 		if ( PRL_SUCCEEDED(getLastErrorCode()) && ! operationIsCancelled() )
@@ -310,6 +311,30 @@ void Task_ConvertDisks::onFinished( int nExitCode, QProcess::ExitStatus nExitSta
 			setLastErrorCode(PRL_ERR_CONV_HD_EXIT_WITH_ERROR);
 		}
 	}
+
+	bool bSucceeded = nExitStatus == QProcess::NormalExit && nExitCode == 0
+			&& ! m_setFailed.contains(pProcess);
+	{
+		QMutexLocker lock(&m_lockRunning);
+		m_mapRunning.remove(pProcess);
+	}
+	m_setFailed.remove(pProcess);
+	pProcess->disconnect(this);
+	pProcess->deleteLater();
+	sendTotalProgress(pHdd, 100);
+
+	completeConversion(pHdd, bSucceeded && ! operationIsCancelled());
+
+	// no new disks after a failure or a cancel
+	if ( ! m_lstQueue.isEmpty() && PRL_SUCCEEDED(getLastErrorCode()) && ! operationIsCancelled() )
+	{
+		PRL_RESULT ret = launchConversion();
+		if (PRL_FAILED(ret))
+			setLastErrorCode(ret);
+	}
+
+	if ( m_mapRunning.isEmpty() && m_pLoop )
+		m_pLoop->quit();
 }
 
 void Task_ConvertDisks::cancelAndWait()
@@ -357,20 +382,18 @@ PRL_RESULT Task_ConvertDisks::convertDisks()
 		return PRL_ERR_CONV_HD_CONFLICT;
 	}
 
-	QString qsConvMode;
-	QString qsConvFlags;
 	if ((m_nFlags & PCVD_MERGE_ALL_SNAPSHOTS) != 0)
 	{
-		qsConvMode = " merge ";
+		m_qsConvMode = " merge ";
 	}
 	else
 	{
-		qsConvMode = " convert ";
+		m_qsConvMode = " convert ";
 
 		if ((m_nFlags & PCVD_TO_PLAIN_DISK) != 0)
-			qsConvFlags += " --plain";
+			m_qsConvFlags += " --plain";
 		else if ((m_nFlags & PCVD_TO_EXPANDING_DISK) != 0)
-			qsConvFlags += " --expanding";
+			m_qsConvFlags += " --expanding";
 	}
 
 	// Refresh disks configuration (from DiskDescriptor.xml)
@@ -425,95 +448,129 @@ PRL_RESULT Task_ConvertDisks::convertDisks()
 
 	// Disks conversion
 
+	m_lstQueue = lstHardDisks;
 	foreach(CVmHardDisk* pHdd, lstHardDisks)
+		m_nTotalSize += qMax<quint64>(pHdd->getSize(), 1);
+
+	QEventLoop loop;
+	m_pLoop = &loop;
+	PRL_RESULT ret = PRL_ERR_SUCCESS;
+	for (int i = 0; i < CONVERT_DISKS_PARALLEL_MAX && ! m_lstQueue.isEmpty(); ++i)
 	{
-		// Index needs for progress event
-		m_nCurHddIndex = pHdd->getIndex();
-		m_nCurHddItemId = pHdd->getItemId();
-
-		QString qsCmd = QString("\"%1\" %2 %3 \"%4\" %5")
-			.arg(m_qsDTName,
-				 qsConvMode, QString("--hdd "),
-				 pHdd->getSystemName(),
-				 qsConvFlags);
-
-		WRITE_TRACE(DBG_WARNING, "Convert disks: start process '%s' ...",
-					QSTR2UTF8(qsCmd));
-		{
-			CAuthHelperImpersonateWrapper impersonate(&getClient()->getAuthHelper());
-			m_pProcess->start(qsCmd);
-		}
-		if ( ! m_pProcess->waitForStarted() )
-		{
-			WRITE_TRACE(DBG_FATAL, "Convert disks: disk tool cannot be started !");
+		if ( PRL_FAILED(ret = launchConversion()) )
+			break;
+	}
+	if ( ! m_mapRunning.isEmpty() )
+		loop.exec();
 
-			getLastError()->addEventParameter(
-				new CVmEventParameter(PVE::String, qsCmd, EVT_PARAM_MESSAGE_PARAM_0) );
-			return PRL_ERR_CONV_HD_DISK_TOOL_NOT_STARTED;
-		}
+	m_pLoop = 0;
 
-		WRITE_TRACE(DBG_WARNING, "Convert disks: disk tool was started !");
-		m_pProcess->waitForFinished(-1);
-		WRITE_TRACE(DBG_WARNING, "Convert disks: disk tool was stopped !");
+	if ( m_nConverted > 0 && (m_nFlags & PCVD_MERGE_ALL_SNAPSHOTS) != 0 )
+		deleteSnapshotsData();
 
-		/* Remove from cache */
-		CDspService::instance()->getVmConfigManager().getHardDiskConfigCache().remove(
-				pHdd->getSystemName() );
+	if ( PRL_FAILED(ret) )
+		return ret;
 
-		m_pProcess->disconnect();
+	if ( operationIsCancelled() && PRL_SUCCEEDED(getLastErrorCode()) )
+		return getCancelResult();
 
-		{
-			CDspLockedPointer<CVmDirectoryItem> pDirItem
-				= CDspService::instance()->getVmDirHelper()
-					.getVmDirectoryItemByUuid(m_vmIdent.second, m_vmIdent.first);
+	return getLastErrorCode();
+}
 
-			if ( pDirItem.isValid() )
-			{
-				PRL_RESULT ret = CDspVmSnapshotStoreHelper::SetDefaultAccessRights(
-									pHdd->getSystemName(),
-									getClient(),
-									pDirItem.getPtr());
-				if (PRL_FAILED(ret))
-					return ret;
-			}
-		}
+PRL_RESULT Task_ConvertDisks::launchConversion()
+{
+	CVmHardDisk* pHdd = m_lstQueue.takeFirst();
+	QString qsCmd = QString("\"%1\" %2 %3 \"%4\" %5")
+		.arg(m_qsDTName,
+			 m_qsConvMode, QString("--hdd "),
+			 pHdd->getSystemName(),
+			 m_qsConvFlags);
+
+	QProcess* pProcess = new QProcess;
+	connect( pProcess, SIGNAL(readyReadStandardError()), this, SLOT(onReadyReadStandardError()),
+		Qt::DirectConnection );
+	connect( pProcess, SIGNAL(readyReadStandardOutput()), this, SLOT(onReadyReadStandardOutput()),
+		Qt::DirectConnection);
+	connect( pProcess,
+		SIGNAL(finished(int , QProcess::ExitStatus)), this,
+		SLOT(onFinished(int, QProcess::ExitStatus)),
+		Qt::DirectConnection);
+	{
+		QMutexLocker lock(&m_lockRunning);
+		m_mapRunning.insert(pProcess, pHdd);
+	}
 
-		if ( operationIsCancelled() && PRL_SUCCEEDED(getLastErrorCode()) )
+	WRITE_TRACE(DBG_WARNING, "Convert disks: start process '%s' ...",
+				QSTR2UTF8(qsCmd));
+	{
+		CAuthHelperImpersonateWrapper impersonate(&getClient()->getAuthHelper());
+		pProcess->start(qsCmd);
+	}
+	if ( ! pProcess->waitForStarted() )
+	{
+		WRITE_TRACE(DBG_FATAL, "Convert disks: disk tool cannot be started !");
 		{
-			return getCancelResult();
+			QMutexLocker lock(&m_lockRunning);
+			m_mapRunning.remove(pProcess);
 		}
+		delete pProcess;
 
-		if ( PRL_FAILED( getLastErrorCode() ) )
-		{
-			return getLastErrorCode();
-		}
+		getLastError()->addEventParameter(
+			new CVmEventParameter(PVE::String, qsCmd, EVT_PARAM_MESSAGE_PARAM_0) );
+		return PRL_ERR_CONV_HD_DISK_TOOL_NOT_STARTED;
+	}
 
-		if ((m_nFlags & PCVD_TO_PLAIN_DISK) != 0)
-			pHdd->setDiskType(PHD_PLAIN_HARD_DISK);
-		if ((m_nFlags & PCVD_TO_EXPANDING_DISK) != 0)
-			pHdd->setDiskType(PHD_EXPANDING_HARD_DISK);
+	WRITE_TRACE(DBG_WARNING, "Convert disks: disk tool was started !");
+	return PRL_ERR_SUCCESS;
+}
 
-		m_bVmConfigWasChanged = true;
+void Task_ConvertDisks::completeConversion(CVmHardDisk* pHdd, bool bSucceeded)
+{
+	/* Remove from cache */
+	CDspService::instance()->getVmConfigManager().getHardDiskConfigCache().remove(
+			pHdd->getSystemName() );
 
-		if ((m_nFlags & PCVD_MERGE_ALL_SNAPSHOTS) != 0)
+	{
+		CDspLockedPointer<CVmDirectoryItem> pDirItem
+			= CDspService::instance()->getVmDirHelper()
+				.getVmDirectoryItemByUuid(m_vmIdent.second, m_vmIdent.first);
+
+		if ( pDirItem.isValid() )
 		{
-			deleteSnapshotsData();
+			PRL_RESULT ret = CDspVmSnapshotStoreHelper::SetDefaultAccessRights(
+								pHdd->getSystemName(),
+								getClient(),
+								pDirItem.getPtr());
+			if (PRL_FAILED(ret))
+			{
+				setLastErrorCode(ret);
+				return;
+			}
 		}
-
-		CVmEvent evt( PET_DSP_EVT_CONVERSION_DISKS_PROGRESS_FINISHED,
-						m_vmIdent.first, PIE_DISPATCHER );
-		evt.addEventParameter(
-			new CVmEventParameter(PVE::Integer,
-								  QString("%1").arg(m_nCurHddIndex),
-								  EVT_PARAM_VM_CONFIG_DEV_INDEX) );
-		evt.addEventParameter(
-			new CVmEventParameter(PVE::Integer,
-								  QString("%1").arg(m_nCurHddItemId),
-								  EVT_PARAM_VM_CONFIG_DEV_ITEM_ID) );
-		sendProgressEvent(evt);
 	}
 
-	return PRL_ERR_SUCCESS;
+	if ( ! bSucceeded )
+		return;
+
+	if ((m_nFlags & PCVD_TO_PLAIN_DISK) != 0)
+		pHdd->setDiskType(PHD_PLAIN_HARD_DISK);
+	if ((m_nFlags & PCVD_TO_EXPANDING_DISK) != 0)
+		pHdd->setDiskType(PHD_EXPANDING_HARD_DISK);
+
+	m_bVmConfigWasChanged = true;
+	++m_nConverted;
+
+	CVmEvent evt( PET_DSP_EVT_CONVERSION_DISKS_PROGRESS_FINISHED,
+					m_vmIdent.first, PIE_DISPATCHER );
+	evt.addEventParameter(
+		new CVmEventParameter(PVE::Integer,
+							  QString("%1").arg(pHdd->getIndex()),
+							  EVT_PARAM_VM_CONFIG_DEV_INDEX) );
+	evt.addEventParameter(
+		new CVmEventParameter(PVE::Integer,
+							  QString("%1").arg(pHdd->getItemId()),
+							  EVT_PARAM_VM_CONFIG_DEV_ITEM_ID) );
+	sendProgressEvent(evt);
 }
 
 void Task_ConvertDisks::deleteSnapshotsData()
@@ -565,8 +622,11 @@ void Task_ConvertDisks::deleteSnapshotsData()
 	}
 }
 
-void Task_ConvertDisks::sendCoversionProgressParams(const QString& qsOutput)
+void Task_ConvertDisks::sendCoversionProgressParams(const QString& qsOutput, const CVmHardDisk* pHdd)
 {
+	if ( ! pHdd )
+		return;
+
 	QRegExp re("\\b\\d+\\b\\s*%");
 	int idx = re.lastIndexIn(qsOutput);
 	if (idx == -1)
@@ -584,14 +644,40 @@ void Task_ConvertDisks::sendCoversionProgressParams(const QString& qsOutput)
 							  EVT_PARAM_PROGRESS_CHANGED) );
 	evt.addEventParameter(
 		new CVmEventParameter(PVE::Integer,
-							  QString("%1").arg(m_nCurHddIndex),
+							  QString("%1").arg(pHdd->getIndex()),
 							  EVT_PARAM_VM_CONFIG_DEV_INDEX) );
 	evt.addEventParameter(
 		new CVmEventParameter(PVE::Integer,
-							  QString("%1").arg(m_nCurHddItemId),
+							  QString("%1").arg(pHdd->getItemId()),
 							  EVT_PARAM_VM_CONFIG_DEV_ITEM_ID) );
 
 	sendProgressEvent(evt);
+	sendTotalProgress(pHdd, qBound(0, qsPercent.toInt(), 100));
+}
+
+void Task_ConvertDisks::sendTotalProgress(const CVmHardDisk* pHdd, int nPercent)
+{
+	if ( ! m_nTotalSize )
+		return;
+
+	m_mapPercent.insert(pHdd, nPercent);
+	quint64 nDone = 0;
+	QHash<const CVmHardDisk*, int >::const_iterator it = m_mapPercent.constBegin();
+	for (; it != m_mapPercent.constEnd(); ++it)
+		nDone += qMax<quint64>(it.key()->getSize(), 1) * it.value();
+
+	int nTotal = qMin<quint64>(100, nDone / m_nTotalSize);
+	if ( nTotal == m_nTotalPercent )
+		return;
+
+	m_nTotalPercent = nTotal;
+	CVmEvent evt( PET_DSP_EVT_JOB_PROGRESS_CHANGED, m_vmIdent.first, PIE_DISPATCHER );
+	evt.addEventParameter(
+		new CVmEventParameter(PVE::UnsignedInt,
+							  QString::number(nTotal),
+							  EVT_PARAM_PROGRESS_CHANGED) );
+
+	sendProgressEvent(evt);
 }
 
 void Task_ConvertDisks::sendProgressEvent(const CVmEvent& evt)
@@ -34,8 +34,12 @@
 #define __Task_ConvertDisks_H__
 
 #include "CDspTaskHelper.h"
+#include <QHash>
+#include <QSet>
 
 
+class QEventLoop;
+class CVmHardDisk;
 class CVmConfiguration;
 
 
@@ -67,8 +71,11 @@ private:
 	void cancelAndWait();
 	bool isTaskShutdown() { return (m_nFlags & PCVD_CANCEL); }
 	PRL_RESULT convertDisks();
+	PRL_RESULT launchConversion();
+	void completeConversion(CVmHardDisk* pHdd, bool bSucceeded);
 	void deleteSnapshotsData();
-	void sendCoversionProgressParams(const QString& qsOutput);
+	void sendCoversionProgressParams(const QString& qsOutput, const CVmHardDisk* pHdd);
+	void sendTotalProgress(const CVmHardDisk* pHdd, int nPercent);
 	void sendProgressEvent(const CVmEvent& evt);
 	void lockConvertDisks();
 	void unlockConvertDisks();
@@ -81,9 +88,20 @@ private:
 	bool		m_bVmConfigWasChanged;
 	bool		m_flgLockRegistered;
 	QString		m_qsDTName;
-	QProcess*	m_pProcess;
-	unsigned int m_nCurHddIndex;
-	int			m_nCurHddItemId;
+	QString		m_qsConvMode;
+	QString		m_qsConvFlags;
+	// disks are converted by several disk tools at once
+	enum { CONVERT_DISKS_PARALLEL_MAX = 4 };
+	QList<CVmHardDisk* >			m_lstQueue;
+	QHash<QProcess*, CVmHardDisk* >	m_mapRunning;
+	QSet<QProcess*>					m_setFailed;
+	QMutex			m_lockRunning;
+	QEventLoop*		m_pLoop;
+	int				m_nConverted;
+	// the job progress is the mean of the disks progress weighted by size
+	QHash<const CVmHardDisk*, int >	m_mapPercent;
+	quint64			m_nTotalSize;
+	int				m_nTotalPercent;
 
 	static QMutex						s_lockConvertDisks;
 	static QMap<CVmIdent , QString >	s_mapVmIdTaskId;
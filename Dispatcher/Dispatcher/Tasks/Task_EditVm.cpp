@@ -212,7 +212,7 @@ bool Task_EditVm::atomicEditVmConfigByVm(
 
 
 	//////////////////////////////////////////////////////////////////////////
-	// NOTE:	TO EXCLUDE DEADLOCK m_pVmConfigEdit mutex
+	// NOTE:	TO EXCLUDE DEADLOCK m_pVmConfigEdit commit lock
 	//			SHOULD be locked BEFORE CDspLockedPointer<..> from getVmDirManager().getXX().
 	//////////////////////////////////////////////////////////////////////////
 
@@ -226,7 +226,8 @@ bool Task_EditVm::atomicEditVmConfigByVm(
 			nRetCode, PRL_RESULT_TO_STRING(nRetCode));
 		return (false);
 	}
-	QMutexLocker lock(CDspService::instance()->getVmDirHelper().getMultiEditDispatcher());
+	CMultiEditDispatcher::CommitLocker lock(CDspService::instance()->getVmDirHelper()
+		.getMultiEditDispatcher(), vmUuid);
 
 	bool retValue = false;
 	QString vmName;
@@ -1382,10 +1383,10 @@ PRL_RESULT Task_EditVm::editVm()
 		CVmRemoteDisplay* newRemDisplay = pVmConfigNew->getVmSettings()->getVmRemoteDisplay();
 		{
 			//
-			// NOTE:	TO EXCLUDE DEADLOCK m_pVmConfigEdit mutex
+			// NOTE:	TO EXCLUDE DEADLOCK m_pVmConfigEdit commit lock
 			//			SHOULD be locked BEFORE CDspLockedPointer<..> from getVmDirManager().getXX().
 			//
-			QMutexLocker editLock(DspVm::vdh().getMultiEditDispatcher());
+			CMultiEditDispatcher::CommitLocker editLock(DspVm::vdh().getMultiEditDispatcher(), vm_uuid);
 
 			// check to change config from other user
 			PRL_RESULT nErrCode;
@@ -119,9 +119,56 @@ BackupItem* Branch::filterList(quint32 head_, QList<quint32> filter_) const
 	return output;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Index
+
+Index::stamp_type Index::stamp(const QString& key_, const Metadata::Sequence& sequence_)
+{
+	stamp_type x;
+	{
+		QMutexLocker g(&m_mutex);
+		QHash<QString, value_type>::const_iterator p = m_data.constFind(key_);
+		if (m_data.constEnd() != p)
+			x = p.value().first;
+	}
+	// the head item is rewritten in place on every increment
+	return Stamp(PRL_BACKUP_METADATA)(sequence_.showLair(), x);
+}
+
+BackupItem* Index::find(const QString& key_, const stamp_type& stamp_)
+{
+	if (stamp_.isEmpty())
+		return NULL;
+
+	QMutexLocker g(&m_mutex);
+	QHash<QString, value_type>::const_iterator p = m_data.constFind(key_);
+	if (m_data.constEnd() == p || p.value().first != stamp_)
+		return NULL;
+
+	return new BackupItem(*p.value().second);
+}
+
+void Index::add(const QString& key_, const stamp_type& stamp_, const BackupItem& item_)
+{
+	if (stamp_.isEmpty())
+		return;
+
+	QMutexLocker g(&m_mutex);
+	if (m_data.size() >= CAPACITY && !m_data.contains(key_))
+		m_data.clear();
+
+	m_data.insert(key_, qMakePair(stamp_, QSharedPointer<BackupItem>(new BackupItem(item_))));
+}
+
 } // namespace Tree
 } // namespace Backup
 
+namespace
+{
+Backup::Tree::Index g_index;
+
+} // namespace
+
 /*******************************************************************************
 
  Backup creation task for client
@@ -286,6 +333,10 @@ void Task_GetBackupTreeTarget::getBackupTree(QString &msg)
 			continue;
 
 		Backup::Metadata::Catalog c = getCatalog(sVmUuid);
+		// a backup lives in one VM folder only, the others are not loaded
+		if (backupFilterEnabled() && !c.getSequence(s).showLair().exists())
+			continue;
+
 		Prl::Expected<VmItem, PRL_RESULT> v = c.loadItem();
 		if (v.isFailed())
 			continue;
@@ -304,13 +355,19 @@ void Task_GetBackupTreeTarget::getBackupTree(QString &msg)
 				continue;
 
 			BackupItem* i;
-			Backup::Tree::Branch b(sBackupUuid, c.getSequence(sBackupUuid));
+			Backup::Metadata::Sequence q(c.getSequence(sBackupUuid));
+			Backup::Tree::Branch b(sBackupUuid, q);
 			if (filterSingleBackup())
 				i = b.filterOne(s, n);
 			else if (filterBackupChain() && v.value().m_lstBackupItem.isEmpty())
 				i = b.filterChain(s, n);
 			else
-				i = b.show();
+			{
+				QString k(q.showLair().absolutePath());
+				Backup::Tree::Index::stamp_type x(g_index.stamp(k, q));
+				if (NULL == (i = g_index.find(k, x)) && NULL != (i = b.show()))
+					g_index.add(k, x, *i);
+			}
 			getMetadataLock().releaseShared(sBackupUuid);
 			if (NULL == i)
 				continue;
@@ -33,6 +33,7 @@
 #ifndef __Task_GetBackupTree_H_
 #define __Task_GetBackupTree_H_
 
+#include <QMutex>
 #include <QString>
 
 #include "CDspTaskHelper.h"
@@ -45,6 +46,7 @@
 #include "Task_BackupHelper.h"
 #include "prlxmlmodel/BackupTree/VmItem.h"
 #include "prlxmlmodel/BackupTree/CBackupDisks.h"
+#include "Task_GetBackupTree_p.h"
 
 namespace Backup
 {
@@ -71,6 +73,34 @@ private:
 	Metadata::Sequence m_metadata;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Index
+// Keeps the full tree of every backup sequence shown before. An entry is good
+// while the stamps of the sequence folder and of its metadata files stay the
+// same, so it is never loaded from the disk twice. A folder with the same
+// stamp as before is not listed either.
+
+struct Index
+{
+	typedef Stamp::value_type stamp_type;
+
+	stamp_type stamp(const QString& key_, const Metadata::Sequence& sequence_);
+
+	BackupItem* find(const QString& key_, const stamp_type& stamp_);
+	void add(const QString& key_, const stamp_type& stamp_, const BackupItem& item_);
+
+private:
+	enum
+	{
+		CAPACITY = 65536
+	};
+
+	typedef QPair<stamp_type, QSharedPointer<BackupItem> > value_type;
+
+	QMutex m_mutex;
+	QHash<QString, value_type> m_data;
+};
+
 } // namespace Tree
 } // namespace Backup
 
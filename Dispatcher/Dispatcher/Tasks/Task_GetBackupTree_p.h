@@ -0,0 +1,92 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file Task_GetBackupTree_p.h
+///
+/// Stamps of the backup sequence folders shown by the backup tree request.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TASK_GETBACKUPTREE_P_H__
+#define __TASK_GETBACKUPTREE_P_H__
+
+#include <QDir>
+#include <QHash>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QStringList>
+
+namespace Backup
+{
+namespace Tree
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Stamp
+// The modification times of a sequence folder and of the metadata files of its
+// items. Adding or removing an item changes the folder, rewriting an item in
+// place changes its metadata file only.
+
+struct Stamp
+{
+	typedef QHash<QString, QDateTime> value_type;
+
+	explicit Stamp(const QString& metadata_): m_metadata(metadata_)
+	{
+	}
+
+	// the items of a folder which has not changed since the previous stamp
+	// are taken from it, the folder is not listed again
+	value_type operator()(const QDir& lair_, const value_type& previous_) const
+	{
+		value_type output;
+		QFileInfo x(lair_.absolutePath());
+		if (!x.exists())
+			return output;
+
+		QString k = x.absoluteFilePath();
+		QDateTime t = x.lastModified();
+		QStringList m;
+		if (previous_.value(k) == t)
+			m = previous_.keys();
+		else
+		{
+			foreach (const QFileInfo& e, lair_.entryInfoList(QDir::NoDotAndDotDot | QDir::Dirs))
+				m << QDir(e.absoluteFilePath()).filePath(m_metadata);
+		}
+		m.removeOne(k);
+		// an item without the metadata yet is kept with an invalid time
+		foreach (const QString& e, m)
+			output[e] = QFileInfo(e).lastModified();
+
+		output[k] = t;
+		return output;
+	}
+
+private:
+	QString m_metadata;
+};
+
+} // namespace Tree
+} // namespace Backup
+
+#endif // __TASK_GETBACKUPTREE_P_H__
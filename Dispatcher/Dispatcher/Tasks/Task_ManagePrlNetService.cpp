@@ -1205,60 +1205,83 @@ SmartPtr<CDispNetworkPreferences> Task_ManagePrlNetService::convertNetworkConfig
 
 void Task_ManagePrlNetService::updateAdapter(const CVmGenericNetworkAdapter& pAdapter, bool bEnable)
 {
-	QString vnic_name = pAdapter.getHostInterfaceName();
+	updateAdapters(QList<CVmGenericNetworkAdapter>() << pAdapter, bEnable);
+}
+
+void Task_ManagePrlNetService::updateAdapters(const QList<CVmGenericNetworkAdapter>& lstAdapters, bool bEnable)
+{
+	PrlNet::Netlink::Batch routes;
+	QStringList arps;
+	QList<QPair<QString, QString> > queued;
+
+	foreach (const CVmGenericNetworkAdapter& pAdapter, lstAdapters)
+	{
+		QString vnic_name = pAdapter.getHostInterfaceName();
 
 #if 0
-	if (CVzHelper::is_vz_running() && bEnable) {
-		// no sense to detach if !bEnable - nic already destroyed
-		getVzVNetHelper().DetachVmdev(vnic_name);
-	}
+		if (CVzHelper::is_vz_running() && bEnable) {
+			// no sense to detach if !bEnable - nic already destroyed
+			getVzVNetHelper().DetachVmdev(vnic_name);
+		}
 #endif
-	if (pAdapter.getEmulatedType() == PNA_ROUTED)
-	{
-		if (bEnable)
+		if (pAdapter.getEmulatedType() == PNA_ROUTED)
 		{
-			PrlNet::setAdapterIpAddress(vnic_name, DEFAULT_HOSTROUTED_GATEWAY);
-			PrlNet::setAdapterIpAddress(vnic_name, DEFAULT_HOSTROUTED_GATEWAY6);
-			QFile f(QString("/proc/sys/net/ipv4/conf/%1/proxy_arp").arg(vnic_name));
-			if (!f.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
-				WRITE_TRACE(DBG_FATAL, "Failed to enable proxy_arp on %s", qPrintable(vnic_name));
-			else
-				f.write("1", 1);
-		}
+			if (bEnable)
+			{
+				PrlNet::setAdapterIpAddress(vnic_name, DEFAULT_HOSTROUTED_GATEWAY);
+				PrlNet::setAdapterIpAddress(vnic_name, DEFAULT_HOSTROUTED_GATEWAY6);
+				QFile f(QString("/proc/sys/net/ipv4/conf/%1/proxy_arp").arg(vnic_name));
+				if (!f.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
+					WRITE_TRACE(DBG_FATAL, "Failed to enable proxy_arp on %s", qPrintable(vnic_name));
+				else
+					f.write("1", 1);
+			}
+
+			// set up routes
+			foreach (QString ip_mask, pAdapter.getNetAddresses())
+			{
+				QString ip;
+				if (!NetworkUtils::ParseIpMask(ip_mask, ip))
+					continue;
 
-		QStringList ips = pAdapter.getNetAddresses();
-		if (ips.size() == 0)
-			return;
+				if (routes.addRoute(ip, vnic_name, bEnable))
+					queued << qMakePair(ip, vnic_name);
+				else if (bEnable)
+				{
+					WRITE_TRACE(DBG_FATAL, "Failed to set route to %s on device %s",
+						QSTR2UTF8(ip), QSTR2UTF8(vnic_name));
+				}
 
-		// set up routes
-		foreach (QString ip_mask, ips)
+				arps << ip;
+			}
+		}
+		else if (pAdapter.getEmulatedType() != PNA_DIRECT_ASSIGN)
 		{
-			QString ip;
-			if (!NetworkUtils::ParseIpMask(ip_mask, ip))
+			if (!bEnable)
 				continue;
-
-			if (!PrlNet::SetRouteToDevice(ip, vnic_name, bEnable) && bEnable)
+#if 0
+			// connect adapter to bridge
+			QString virtualNetworkID = pAdapter->getVirtualNetworkID();
+			if (!virtualNetworkID.isEmpty())
 			{
-				WRITE_TRACE(DBG_FATAL, "Failed to set route to %s on device %s",
-					QSTR2UTF8(ip), QSTR2UTF8(vnic_name));
+				getVzVNetHelper().AddVmdevToVirtualNetwork(virtualNetworkID, vnic_name);
 			}
-
-			PrlNet::SetArpToNodeDevices(ip, QString(), bEnable, bEnable);
+#endif
 		}
 	}
-	else if (pAdapter.getEmulatedType() != PNA_DIRECT_ASSIGN)
+
+	if (bEnable)
 	{
-		if (!bEnable)
-			return;
-#if 0
-		// connect adapter to bridge
-		QString virtualNetworkID = pAdapter->getVirtualNetworkID();
-		if (!virtualNetworkID.isEmpty())
+		foreach (int i, routes.commit())
 		{
-			getVzVNetHelper().AddVmdevToVirtualNetwork(virtualNetworkID, vnic_name);
+			WRITE_TRACE(DBG_FATAL, "Failed to set route to %s on device %s",
+				QSTR2UTF8(queued.at(i).first), QSTR2UTF8(queued.at(i).second));
 		}
-#endif
 	}
+	else
+		routes.commit();
+
+	PrlNet::SetArpToNodeDevices(arps, QString(), bEnable, bEnable);
 }
 
 /*
@@ -1273,13 +1296,15 @@ void Task_ManagePrlNetService::updateVmNetworking(SmartPtr<CVmConfiguration> pVm
 	if (!pVmConfig)
 		return;
 
+	QList<CVmGenericNetworkAdapter> a;
 	foreach(CVmGenericNetworkAdapter *adapter, pVmConfig->getVmHardwareList()->m_lstNetworkAdapters)
 	{
 		if (!adapter)
 			continue;
 
-		updateAdapter(*adapter, bEnable);
+		a << *adapter;
 	}
+	updateAdapters(a, bEnable);
 #endif
 }
 
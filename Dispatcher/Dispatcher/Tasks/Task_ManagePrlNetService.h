@@ -105,6 +105,10 @@ public:
 	/// set nessary settings on host for particular vm network adapter
 	/// used in psbm only for now
 	static void updateAdapter(const CVmGenericNetworkAdapter& pAdapter, bool bEnable);
+
+	/// the same as above for several adapters at once. routes and proxy
+	/// arp entries for all the adapters are programmed in one netlink batch
+	static void updateAdapters(const QList<CVmGenericNetworkAdapter>& lstAdapters, bool bEnable);
 #endif
 
 	/// set nessary settings on host for vm networking
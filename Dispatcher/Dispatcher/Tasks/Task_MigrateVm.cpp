@@ -1718,6 +1718,7 @@ Migrate::Vm::Source::Content::Copier* Task_MigrateVmSource::createCopier()
 	copier->SetRequest(getRequestPackage());
 	copier->SetVmDirectoryUuid(m_sVmDirUuid);
 	copier->SetProgressNotifySender(NotifyClientsWithProgress);
+	copier->SetCompression(!(getFlags() & PVMT_UNCOMPRESSED));
 
 	return new Migrate::Vm::Source::Content::Copier(sender, copier, error);
 }
@@ -52,6 +52,9 @@
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
 #include <prlcommon/Std/PrlAssert.h>
 #include "Libraries/PrlCommonUtils/CVmMigrateHelper.h"
+#include "Libraries/Virtuozzo/CVzHelper.h"
+#include "CDspExecutor.h"
+#include <boost/bind.hpp>
 
 using namespace Virtuozzo;
 
@@ -311,13 +314,139 @@ Remove::result_type Remove::operator()()
 	return PRL_ERR_SUCCESS;
 }
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Flow
+
+void Flow::add(const QFileInfo& source_, const QFileInfo& target_)
+{
+	Item x;
+	x.source = source_;
+	x.target = target_;
+	x.index = m_queue.size();
+	m_queue << x;
+	m_total += source_.size();
+}
+
+PRL_RESULT Flow::operator()()
+{
+	if (m_queue.isEmpty())
+		return PRL_ERR_SUCCESS;
+
+	// start the biggest images first, the tail of small files
+	// fills the gaps
+	std::stable_sort(m_queue.begin(), m_queue.end(), &Flow::isLarger);
+	int n = qMin<int>(m_queue.size(), getStreams());
+	QList<QFuture<void> > f;
+	for (int i = 1; i < n; ++i)
+	{
+		f << Executor::get(Executor::COPY)
+			.run(boost::bind(&Flow::stream, this, i));
+	}
+	stream(0);
+	foreach (QFuture<void> x, f)
+		x.waitForFinished();
+
+	return m_result;
+}
+
+bool Flow::isLarger(const Item& one_, const Item& another_)
+{
+	return one_.source.size() > another_.source.size();
+}
+
+int Flow::getStreams()
+{
+	// a storage that takes parallel writes well (ssd, nvme, a distributed
+	// one) may be given more, a single spindle is better with 1
+	QString r;
+	CVzHelper::get_vz_config_param("VZ_TOOLS_COPY_STREAMS", r);
+	bool y = false;
+	int output = r.toInt(&y);
+	if (!y || output < 1)
+		return STREAMS_DEFAULT;
+
+	return qMin<int>(output, STREAMS_MAX);
+}
+
+void Flow::stream(int number_)
+{
+	forever
+	{
+		Item x;
+		{
+			QMutexLocker g(&m_mutex);
+			if (m_queue.isEmpty() || PRL_FAILED(m_result))
+				return;
+
+			x = m_queue.takeFirst();
+		}
+		if (m_task->operationIsCancelled())
+		{
+			QMutexLocker g(&m_mutex);
+			m_result = m_task->getCancelResult();
+			return;
+		}
+		QString s(x.source.absoluteFilePath());
+		QString t(x.target.absoluteFilePath());
+		WRITE_TRACE(DBG_DEBUG, "Copy file %s to %s in stream %d",
+			qPrintable(s), qPrintable(t), number_);
+		PRL_RESULT e = CFileHelperDepPart::CopyFileWithNotifications(
+				s, t, m_auth, m_task, m_type, x.index,
+				boost::bind(&Flow::account, this, _1));
+		if (PRL_FAILED(e))
+		{
+			WRITE_TRACE(DBG_FATAL, "Copy %s to %s failed",
+				qPrintable(s), qPrintable(t));
+			QMutexLocker g(&m_mutex);
+			if (PRL_SUCCEEDED(m_result))
+				m_result = e;
+
+			return;
+		}
+		if (m_attribute)
+			m_attribute.get()(x.source, x.target);
+	}
+}
+
+void Flow::account(qint64 bytes_)
+{
+	quint32 c;
+	{
+		QMutexLocker g(&m_mutex);
+		m_done += bytes_;
+		if (0 == m_total)
+			return;
+
+		c = qMin<quint64>(100, m_done * 100 / m_total);
+		if (c == m_percent)
+			return;
+
+		m_percent = c;
+	}
+	// the streams do not wait for the client here. the report lock keeps
+	// the percents from going back only, a stale value is dropped
+	QMutexLocker g(&m_report);
+	if (c <= m_reported)
+		return;
+
+	m_reported = c;
+	CVmEvent v(PET_DSP_EVT_JOB_PROGRESS_CHANGED, m_task->getJobUuid().toString(),
+		PIE_DISPATCHER);
+	v.addEventParameter(new CVmEventParameter(PVE::UnsignedInt,
+		QString::number(c), EVT_PARAM_PROGRESS_CHANGED));
+	m_task->getClient()->sendPackage(DispatcherPackage::createInstance
+		(PVE::DspVmEvent, v, m_task->getRequestPackage()));
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Copy
 
 Copy::result_type Copy::operator()(const QFileInfo& source_, const QFileInfo& target_)
 {
 	QList<QFileInfo>().swap(m_queue);
-	PRL_RESULT e = process(source_, target_);
+	Flow f(*m_task, m_task->getClient()->getAuthHelper(), PDE_GENERIC_DEVICE);
+	f.setAttribute(m_attribute);
+	PRL_RESULT e = process(source_, target_, f);
 	if (PRL_FAILED(e))
 		return e;
 
@@ -331,42 +460,31 @@ Copy::result_type Copy::operator()(const QFileInfo& source_, const QFileInfo& ta
 			QDir::System | QDir::NoDotAndDotDot))
 		{
 			PRL_RESULT e = process(i, t.filePath(s
-				.relativeFilePath(i.absoluteFilePath())));
+				.relativeFilePath(i.absoluteFilePath())), f);
 			if (PRL_FAILED(e))
 				return e;
 		}
 	}
 
-	return PRL_ERR_SUCCESS;
+	return f();
 }
 
-PRL_RESULT Copy::process(const QFileInfo& source_, const QFileInfo& target_)
+PRL_RESULT Copy::process(const QFileInfo& source_, const QFileInfo& target_, Flow& flow_)
 {
-	QString s(source_.absoluteFilePath());
-	QString t(target_.absoluteFilePath());
-	CAuthHelper* a = &m_task->getClient()->getAuthHelper();
-	if (source_.isDir())
+	if (!source_.isDir())
 	{
-		WRITE_TRACE(DBG_DEBUG, "Create directory %s", QSTR2UTF8(t));
-		if (!CFileHelper::WriteDirectory(t, a))
-		{
-			WRITE_TRACE(DBG_FATAL, "Can't create directory %s", QSTR2UTF8(t));
-			return PRL_ERR_OPERATION_FAILED;
-		}
-		m_queue << source_;
+		// the whole tree is created first, the files go in parallel then
+		flow_.add(source_, target_);
+		return PRL_ERR_SUCCESS;
 	}
-	else
+	QString t(target_.absoluteFilePath());
+	WRITE_TRACE(DBG_DEBUG, "Create directory %s", QSTR2UTF8(t));
+	if (!CFileHelper::WriteDirectory(t, &m_task->getClient()->getAuthHelper()))
 	{
-		WRITE_TRACE(DBG_DEBUG, "Copy file %s to %s", qPrintable(s), qPrintable(t));
-		PRL_RESULT e = CFileHelperDepPart::CopyFileWithNotifications(
-				s, t, a, m_task, PDE_GENERIC_DEVICE, 0);
-		if (PRL_FAILED(e))
-		{
-			WRITE_TRACE(DBG_FATAL, "Copy %s to %s failed",
-				qPrintable(s), qPrintable(t));
-			return e;
-		}
+		WRITE_TRACE(DBG_FATAL, "Can't create directory %s", QSTR2UTF8(t));
+		return PRL_ERR_OPERATION_FAILED;
 	}
+	m_queue << source_;
 	if (m_attribute)
 		m_attribute.get()(source_, target_);
 
@@ -693,18 +811,11 @@ Regular::result_type Regular::operator()(const QDir& target_)
 			(target_.absoluteFilePath(f.second), getAuth()))
 			return PRL_ERR_MAKE_DIRECTORY;
 	}
-	int i = 0;
+	Command::Move::Flow x(*m_thread, *getAuth(), PDE_CLUSTERED_DEVICE);
 	foreach (itemList_type::const_reference f, m_files)
-	{
-		PRL_RESULT e = CFileHelperDepPart::CopyFileWithNotifications(
-			f.first.absoluteFilePath(),
-			target_.absoluteFilePath(f.second),
-			getAuth(), m_thread, PDE_CLUSTERED_DEVICE, i++);
-		if (PRL_FAILED(e))
-			return e;
-	}
+		x.add(f.first, QFileInfo(target_.absoluteFilePath(f.second)));
 
-	return PRL_ERR_SUCCESS;
+	return x();
 }
 
 CAuthHelper* Regular::getAuth() const
@@ -36,6 +36,7 @@
 #include <QList>
 #include <QPair>
 #include <QString>
+#include <QMutex>
 #include <QFileInfo>
 #include "CDspInstrument.h"
 #include <prlsdk/PrlTypes.h>
@@ -46,6 +47,7 @@
 
 class CDspService;
 class Task_MoveVm;
+class CDspTaskHelper;
 class CDspTaskManager;
 class CDspVmDirManager;
 class CVmConfiguration;
@@ -95,6 +97,63 @@ private:
 	const QString m_path;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Flow
+// Copies a set of files in several streams at once. Every file reports its
+// progress as a separate device of the same type, the job progress is the sum
+// of the bytes copied by all the streams.
+
+struct Flow
+{
+	enum
+	{
+		// an I/O budget: more streams only make disk heads jump. two
+		// moves at once fill the copy pool then
+		STREAMS_DEFAULT = 4,
+		// the size of the copy pool plus the calling thread
+		STREAMS_MAX = 9
+	};
+
+	Flow(CDspTaskHelper& task_, CAuthHelper& auth_, PRL_DEVICE_TYPE type_):
+		m_task(&task_), m_auth(&auth_), m_type(type_), m_result(PRL_ERR_SUCCESS),
+		m_total(0), m_done(0), m_percent(0), m_reported(0)
+	{
+	}
+
+	void setAttribute(const boost::optional<Attribute>& value_)
+	{
+		m_attribute = value_;
+	}
+	void add(const QFileInfo& source_, const QFileInfo& target_);
+	PRL_RESULT operator()();
+
+private:
+	struct Item
+	{
+		QFileInfo source;
+		QFileInfo target;
+		int index;
+	};
+
+	static bool isLarger(const Item& one_, const Item& another_);
+	static int getStreams();
+	void stream(int number_);
+	void account(qint64 bytes_);
+
+	CDspTaskHelper* m_task;
+	CAuthHelper* m_auth;
+	PRL_DEVICE_TYPE m_type;
+	QMutex m_mutex;
+	PRL_RESULT m_result;
+	quint64 m_total;
+	quint64 m_done;
+	quint32 m_percent;
+	QMutex m_report;
+	quint32 m_reported;
+	QList<Item> m_queue;
+	boost::optional<Attribute> m_attribute;
+};
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Copy
 
@@ -111,7 +170,7 @@ struct Copy: Instrument::Command::Base
 	result_type operator()(const QFileInfo& source_, const QFileInfo& target_);
 
 private:
-	PRL_RESULT process(const QFileInfo& source_, const QFileInfo& target_);
+	PRL_RESULT process(const QFileInfo& source_, const QFileInfo& target_, Flow& flow_);
 
 	Task_MoveVm* m_task;
 	QList<QFileInfo> m_queue;
@@ -1922,7 +1922,7 @@ void Task_RegisterVm::validateNewConfiguration(  )
 void Task_RegisterVm::patchNewConfiguration()
 {
 	{
-		CDspBugPatcherLogic logic( *CDspService::instance()->getHostInfo()->data() );
+		CDspBugPatcherLogic logic( *CDspService::instance()->getHostInfoSnapshot() );
 
 		if( doRegisterOnly() )
 			logic.patchOldConfig( m_dirUuid,
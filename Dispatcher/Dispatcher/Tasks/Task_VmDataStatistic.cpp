@@ -35,10 +35,17 @@
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
 #include <prlcommon/HostUtils/HostUtils.h>
 #include "Task_VmDataStatistic.h"
+#include "Task_VmDataStatistic_p.h"
 #include "CDspService.h"
 
 using namespace Virtuozzo;
 
+namespace
+{
+Statistic::Cache g_cache;
+
+} // namespace
+
 
 Task_VmDataStatistic::Task_VmDataStatistic( const SmartPtr<CDspClient>& pClient,
 											const SmartPtr<IOPackage>& p,
@@ -227,15 +234,7 @@ PRL_RESULT Task_VmDataStatistic::hostDiskSpaceUsage()
 	//       the previous results are taken acount
 	//       of the next calculations.
 
-	PRL_RESULT ret = fullDiskSpaceUsage();
-	if (PRL_FAILED(ret))
-		return ret;
-
-	ret = vmDataDiskSpaceUsage();
-	if (PRL_FAILED(ret))
-		return ret;
-
-	ret = snapshotsDiskSpaceUsage();
+	PRL_RESULT ret = bundleDiskSpaceUsage();
 	if (PRL_FAILED(ret))
 		return ret;
 
@@ -250,18 +249,17 @@ PRL_RESULT Task_VmDataStatistic::hostDiskSpaceUsage()
 	return PRL_ERR_SUCCESS;
 }
 
-PRL_RESULT Task_VmDataStatistic::fullDiskSpaceUsage()
+PRL_RESULT Task_VmDataStatistic::bundleDiskSpaceUsage()
 {
-	quint64 nFullSize = 0;
-
-// VM bundle size
-
-	PRL_RESULT ret = CSimpleFileHelper::GetDirSize(m_fiVmHomePath.canonicalFilePath(), &nFullSize);
-	if (PRL_FAILED(ret))
-		return ret;
-
-// + out VM bundle data size
-
+	QString h = m_fiVmHomePath.canonicalFilePath();
+	Statistic::Walker w;
+	// the tree of snapshots and the disk list are kept out of directories
+	w.watch(CDspService::instance()->getVmDirManager().getVmHomeByUuid(getVmIdent()));
+	w.watch(h + "/" + VM_GENERATED_SNAPSHOTS_CONFIG_FILE);
+	w.track(h + "/" VM_GENERATED_WINDOWS_SNAPSHOTS_DIR, Statistic::Usage::SNAPSHOTS);
+
+	QStringList x;
+	QSet<QString> y;
 	foreach(CVmHardDisk* pHdd, m_pVmConfig->getVmHardwareList()->m_lstHardDisks)
 	{
 		if ( ! (pHdd->getEmulatedType() == (PVE::HardDiskEmulatedType)PDT_USE_IMAGE_FILE
@@ -273,60 +271,40 @@ PRL_RESULT Task_VmDataStatistic::fullDiskSpaceUsage()
 			// Skip not an existing file
 			// (deleted or placed on removable device)
 			continue;
-		if ( fiDevData.canonicalFilePath().startsWith(m_fiVmHomePath.canonicalFilePath()) )
-			// Inside bundle VM
-			continue;
 
-		quint64 nDataSize = 0;
-		if (fiDevData.isDir())
-			CSimpleFileHelper::GetDirSize(fiDevData.canonicalFilePath(), &nDataSize);
-		else
-			nDataSize = fiDevData.size();
+		QString d = fiDevData.canonicalFilePath();
+		// several entries may refer to one image
+		if (y.contains(d))
+			continue;
 
-		nFullSize += nDataSize;
+		y << d;
+		if (pHdd->getEmulatedType() == (PVE::HardDiskEmulatedType)PDT_USE_IMAGE_FILE)
+			w.track(d, Statistic::Usage::DATA);
+		if ( ! d.startsWith(h) )
+			// out VM bundle data
+			x << d;
 	}
 
-	addSegment(PDSS_VM_FULL_SPACE)->setCapacity(nFullSize);
-
-	return PRL_ERR_SUCCESS;
-}
-
-PRL_RESULT Task_VmDataStatistic::vmDataDiskSpaceUsage()
-{
-	quint64 nVmDataSize = 0;
-
-	foreach(CVmHardDisk* pHardDisk, m_pVmConfig->getVmHardwareList()->m_lstHardDisks)
+	Statistic::Usage u;
+	if (!g_cache.find(getVmIdent(), u))
 	{
-		if (pHardDisk->getEmulatedType() != (PVE::HardDiskEmulatedType)PDT_USE_IMAGE_FILE)
-			continue;
-
-		QFileInfo fiHardDisk(pHardDisk->getSystemName());
-		if ( ! fiHardDisk.exists() )
-			continue;
+		PRL_RESULT ret = w(h, u);
+		if (PRL_FAILED(ret))
+			return ret;
 
-// Whole hard disk bundle size
+		foreach (const QString& d, x)
+		{
+			if (operationIsCancelled())
+				return PRL_ERR_OPERATION_WAS_CANCELED;
 
-		quint64 nDataSize = 0;
-		CSimpleFileHelper::GetDirSize(fiHardDisk.canonicalFilePath(), &nDataSize);
-		nVmDataSize += nDataSize;
+			w(d, u);
+		}
+		g_cache.add(getVmIdent(), w.getSignature(), u);
 	}
 
-// Hard disk bundle size
-
-	addSegment(PDSS_VM_DISK_DATA_SPACE)->setCapacity(nVmDataSize);
-
-	return PRL_ERR_SUCCESS;
-}
-
-PRL_RESULT Task_VmDataStatistic::snapshotsDiskSpaceUsage()
-{
-	quint64 nSnapshotsSize = 0;
-
-	QFileInfo fiSnapshots( m_fiVmHomePath.canonicalFilePath() + "/" VM_GENERATED_WINDOWS_SNAPSHOTS_DIR );
-	if (fiSnapshots.exists())
-		CSimpleFileHelper::GetDirSize(fiSnapshots.canonicalFilePath(), &nSnapshotsSize);
-
-	addSegment(PDSS_VM_SNAPSHOTS_SPACE)->setCapacity(nSnapshotsSize);
+	addSegment(PDSS_VM_FULL_SPACE)->setCapacity(u.m_full);
+	addSegment(PDSS_VM_DISK_DATA_SPACE)->setCapacity(u.m_data);
+	addSegment(PDSS_VM_SNAPSHOTS_SPACE)->setCapacity(u.m_snapshots);
 
 	return PRL_ERR_SUCCESS;
 }
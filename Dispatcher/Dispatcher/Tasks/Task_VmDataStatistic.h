@@ -62,9 +62,8 @@ private:
 	CVmDataSegment* getSegment(PRL_DATA_STATISTIC_SEGMENTS nSegment) const;
 
 	PRL_RESULT hostDiskSpaceUsage();
-	PRL_RESULT fullDiskSpaceUsage();
-	PRL_RESULT vmDataDiskSpaceUsage();
-	PRL_RESULT snapshotsDiskSpaceUsage();
+	// full, disk data and snapshots segments in one pass over the VM files
+	PRL_RESULT bundleDiskSpaceUsage();
 	PRL_RESULT miscellaneousDiskSpaceUsage();
 	PRL_RESULT reclaimDiskSpaceUsage();
 	QStringList getLostSnapshotFiles();
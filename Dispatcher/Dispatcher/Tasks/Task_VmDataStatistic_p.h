@@ -0,0 +1,262 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file Task_VmDataStatistic_p.h
+///
+/// Disk space usage of the VM files and its cache.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+///
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+///
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+/////////////////////////////////////////////////////////////////////////////////
+
+#ifndef __TASK_VMDATASTATISTIC_P_H__
+#define __TASK_VMDATASTATISTIC_P_H__
+
+#include <QDir>
+#include <QSet>
+#include <QHash>
+#include <QPair>
+#include <QMutex>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDirIterator>
+#include <prlsdk/PrlErrors.h>
+#include "CVmIdent.h"
+#ifdef _LIN_
+#include <sys/stat.h>
+#endif
+
+namespace Statistic
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Usage
+
+struct Usage
+{
+	enum Segment
+	{
+		FULL,
+		DATA,
+		SNAPSHOTS
+	};
+
+	Usage(): m_full(0), m_data(0), m_snapshots(0)
+	{
+	}
+
+	void add(Segment segment_, quint64 value_)
+	{
+		switch (segment_)
+		{
+		case FULL:
+			m_full += value_;
+			break;
+		case DATA:
+			m_data += value_;
+			break;
+		case SNAPSHOTS:
+			m_snapshots += value_;
+			break;
+		}
+	}
+
+	quint64 m_full;
+	quint64 m_data;
+	quint64 m_snapshots;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Node
+
+struct Node
+{
+	Node(): m_dir(false), m_link(false), m_allocated(0)
+	{
+	}
+
+	bool load(const QString& path_)
+	{
+#ifdef _LIN_
+		struct stat s;
+		if (0 != ::lstat(QFile::encodeName(path_).constData(), &s))
+			return false;
+
+		m_dir = S_ISDIR(s.st_mode);
+		m_link = S_ISLNK(s.st_mode);
+		// sparse images are counted by the space they really take
+		m_allocated = (quint64)s.st_blocks * 512;
+		m_stamp = qMakePair((qint64)s.st_mtim.tv_sec, (qint64)s.st_mtim.tv_nsec);
+#else
+		QFileInfo f(path_);
+		if (!f.exists())
+			return false;
+
+		m_dir = f.isDir();
+		m_link = f.isSymLink();
+		m_allocated = f.size();
+		m_stamp = qMakePair((qint64)f.lastModified().toTime_t(), (qint64)0);
+#endif
+		return true;
+	}
+	// a file may grow or shrink keeping the mtime (preallocation)
+	bool isSame(const Node& other_) const
+	{
+		return m_stamp == other_.m_stamp && m_allocated == other_.m_allocated;
+	}
+
+	bool m_dir;
+	bool m_link;
+	quint64 m_allocated;
+	QPair<qint64, qint64> m_stamp;
+};
+
+typedef QHash<QString, Node> signature_type;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Walker
+// Walks the VM files once and splits the allocated space by segments. A file
+// is counted in one segment at most. Keeps the stamps of every directory and
+// file counted, they tell whether the result is still valid.
+
+struct Walker
+{
+	void track(const QString& path_, Usage::Segment segment_)
+	{
+		m_tracked << qMakePair(path_, segment_);
+	}
+	void watch(const QString& path_)
+	{
+		Node n;
+		if (n.load(path_))
+			m_signature[path_] = n;
+	}
+	const signature_type& getSignature() const
+	{
+		return m_signature;
+	}
+	PRL_RESULT operator()(const QString& root_, Usage& dst_)
+	{
+		// an external disk may be shared by several entries
+		if (m_visited.contains(root_))
+			return PRL_ERR_SUCCESS;
+
+		m_visited << root_;
+		Node n;
+		if (!n.load(root_))
+			return PRL_ERR_FILE_NOT_FOUND;
+
+		if (!n.m_dir)
+		{
+			account(root_, n, dst_);
+			return PRL_ERR_SUCCESS;
+		}
+		m_signature[root_] = n;
+		QDirIterator i(root_, QDir::AllEntries | QDir::Hidden | QDir::System | QDir::NoDotAndDotDot,
+			QDirIterator::Subdirectories);
+		while (i.hasNext())
+		{
+			QString p = i.next();
+			if (!n.load(p) || n.m_link)
+				continue;
+
+			if (n.m_dir)
+				m_signature[p] = n;
+			else
+				account(p, n, dst_);
+		}
+		return PRL_ERR_SUCCESS;
+	}
+
+private:
+	void account(const QString& path_, const Node& node_, Usage& dst_)
+	{
+		dst_.add(Usage::FULL, node_.m_allocated);
+		// logs, saved states and nvram change without directory updates
+		// as well as images
+		m_signature[path_] = node_;
+		typedef QPair<QString, Usage::Segment> tracked_type;
+		foreach (const tracked_type& t, m_tracked)
+		{
+			if (path_ != t.first && !path_.startsWith(t.first + "/"))
+				continue;
+
+			// nested or repeated entries must not exceed the full size
+			dst_.add(t.second, node_.m_allocated);
+			break;
+		}
+	}
+
+	QList<QPair<QString, Usage::Segment> > m_tracked;
+	QSet<QString> m_visited;
+	signature_type m_signature;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Cache
+
+struct Cache
+{
+	bool find(const CVmIdent& ident_, Usage& dst_)
+	{
+		value_type v;
+		{
+			QMutexLocker g(&m_mutex);
+			if (!m_data.contains(ident_))
+				return false;
+
+			v = m_data.value(ident_);
+		}
+		// checking the stamps is cheaper than the walk: no directory
+		// is read
+		signature_type::const_iterator p = v.first.constBegin(), e = v.first.constEnd();
+		for (; p != e; ++p)
+		{
+			Node n;
+			if (!n.load(p.key()) || !n.isSame(p.value()))
+				return false;
+		}
+		dst_ = v.second;
+		return true;
+	}
+	void add(const CVmIdent& ident_, const signature_type& signature_, const Usage& usage_)
+	{
+		QMutexLocker g(&m_mutex);
+		if (m_data.size() >= CAPACITY && !m_data.contains(ident_))
+			m_data.clear();
+
+		m_data.insert(ident_, qMakePair(signature_, usage_));
+	}
+
+private:
+	enum
+	{
+		CAPACITY = 1024
+	};
+
+	typedef QPair<signature_type, Usage> value_type;
+
+	QMutex m_mutex;
+	QHash<CVmIdent, value_type> m_data;
+};
+
+} // namespace Statistic
+
+#endif // __TASK_VMDATASTATISTIC_P_H__
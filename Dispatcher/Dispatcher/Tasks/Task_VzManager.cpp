@@ -1310,6 +1310,16 @@ PRL_RESULT Task_VzManager::prepareTask()
 	return PRL_ERR_SUCCESS;
 }
 
+PRL_RESULT Task_VzManager::apply_state()
+{
+	PRL_RESULT res = prepareTask();
+	if (PRL_SUCCEEDED(res))
+		res = process_state();
+
+	setLastErrorCode(res);
+	return res;
+}
+
 PRL_RESULT Task_VzManager::process_state()
 {
 	PRL_RESULT res = PRL_ERR_SUCCESS;
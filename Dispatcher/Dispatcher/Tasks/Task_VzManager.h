@@ -54,6 +54,8 @@ public:
 			const QString &sUuid, VIRTUAL_MACHINE_STATE nState);
 
 	SmartPtr<CVzOperationHelper> get_op_helper() { return m_pVzOpHelper; }
+	// apply the state passed to the constructor in the caller thread
+	PRL_RESULT apply_state();
 private:
 	CProtoCommandDspWsResponse *getResponseCmd();
 	void sendEvent(PRL_EVENT_TYPE type, const QString &sUuid);
@@ -37,9 +37,28 @@
 #include <vzctl/libvzctl.h>
 #include "CDspClientManager.h"
 
+namespace
+{
+void applyState(const QString& uuid_, VIRTUAL_MACHINE_STATE state_)
+{
+	SmartPtr<CDspClient> c = CDspClient::makeServiceUser(
+				CDspVmDirManager::getVzDirectoryUuid());
+	SmartPtr<IOPackage> p = DispatcherPackage::createInstance(
+				PVE::DspCmdCtlDispatherFakeCommand);
+	PRL_RESULT e = Task_VzManager(c, p, uuid_, state_).apply_state();
+	if (PRL_FAILED(e))
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to apply state %s of the Container %s: %s",
+			PRL_VM_STATE_TO_STRING(state_), QSTR2UTF8(uuid_),
+			PRL_RESULT_TO_STRING(e));
+	}
+}
+
+} // namespace
+
 Task_VzStateMonitor::Task_VzStateMonitor(const SmartPtr<CDspClient> &user,
 		const SmartPtr<IOPackage> &p) :
-	CDspTaskHelper(user, p)
+	CDspTaskHelper(user, p), m_reactor(&applyState)
 {}
 
 Task_VzStateMonitor::~Task_VzStateMonitor()
@@ -93,6 +112,7 @@ void Task_VzStateMonitor::processUnregisterEvt(const QString &sUuid)
 {
 	PRL_RESULT res;
 
+	m_reactor.forget(sUuid);
 	res = CDspService::instance()->getVmDirHelper().deleteVmDirectoryItem(m_sVzDirUuid, sUuid);
 	if (PRL_FAILED(res))
 		WRITE_TRACE(DBG_FATAL, ">>> Can't delete Ct %s from VmDirectory by error %#x, %s",
@@ -111,12 +131,12 @@ void Task_VzStateMonitor::processConfigChangedEvt(const QString &sUuid)
 	// Invalidate cache
 	CDspService::instance()->getVzHelper()->getConfigCache().
 		remove(pVmDirItem->getVmHome());
-	SmartPtr<CVmConfiguration> pConfig = CDspService::instance()->getVzHelper()->
-		getCtConfig(CDspClient::makeServiceUser(), sUuid);
-	if (!pConfig)
+	// the name is the only thing kept in the catalogue, do not build the
+	// whole config for it
+	QString sNewName;
+	if (PRL_FAILED(CVzHelper::get_env_name(sUuid, sNewName)))
 		return;
 
-	QString sNewName = pConfig->getVmIdentification()->getVmName();
 	if (pVmDirItem->getVmName() != sNewName && !sNewName.isEmpty()) {
 		pVmDirItem->setVmName(sNewName);
 		PRL_RESULT ret = CDspService::instance()->getVmDirManager().
@@ -135,10 +155,7 @@ void Task_VzStateMonitor::processNetConfigChangedEvt(const QString &sUuid)
 
 void Task_VzStateMonitor::processChangeCtState(QString uuid, VIRTUAL_MACHINE_STATE vm_state)
 {
-	SmartPtr<CDspClient> pFakeSession = CDspClient::makeServiceUser(
-				CDspVmDirManager::getVzDirectoryUuid());
-	SmartPtr<IOPackage> p = DispatcherPackage::createInstance( PVE::DspCmdCtlDispatherFakeCommand );
-	CDspService::instance()->getTaskManager().schedule(new Task_VzManager(pFakeSession, p, uuid, vm_state));
+	m_reactor.react(uuid, vm_state);
 }
 
 void Task_VzStateMonitor::sendState(const QString &ctid, int state)
@@ -254,11 +271,14 @@ PRL_RESULT Task_VzStateMonitor::run_body()
 		std::transform(d->m_lstVmDirectoryItems.begin(), d->m_lstVmDirectoryItems.end(),
 			std::back_inserter(uuids), boost::bind(&CVmDirectoryItem::getVmUuid, _1));
 	}
-	CVzHelper& h = CDspService::instance()->getVzHelper()->getVzlibHelper();
+	QHash<QString, VIRTUAL_MACHINE_STATE> m;
+	if (PRL_FAILED(CVzHelper::get_env_status_list(m)))
+		WRITE_TRACE(DBG_FATAL, "Unable to get initial states of Containers");
+
 	foreach(const QString& u, uuids)
 	{
-		VIRTUAL_MACHINE_STATE s = VMS_UNKNOWN;
-		if (PRL_SUCCEEDED(h.get_env_status(u, s)) && s != VMS_UNKNOWN)
+		VIRTUAL_MACHINE_STATE s = m.value(CVzHelper::get_ctid_by_uuid(u), VMS_UNKNOWN);
+		if (s != VMS_UNKNOWN)
 			processChangeCtState(u, s);
 	}
 	return startMonitor();
@@ -33,6 +33,7 @@
 #include <prlcommon/Std/SmartPtr.h>
 #include "CDspTaskHelper.h"
 #include "Libraries/Virtuozzo/CVzHelper.h"
+#include "CDspCtStateReactor.h"
 
 class Task_VzStateMonitor : public CDspTaskHelper
 {
@@ -57,6 +58,7 @@ protected:
 private:
 	CVzStateMonitor m_monitor;
 	QString m_sVzDirUuid;
+	Ct::State::Reactor m_reactor;
 
 };
 
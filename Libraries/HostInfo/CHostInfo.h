@@ -45,6 +45,7 @@
 #define __CDSPHOSTINFO_H__
 #include <QStringList>
 #include <QList>
+#include <QAtomicInt>
 #include <map>
 #include <boost/function.hpp>
 #include <prlcommon/Std/LockedPtr.h>
@@ -249,6 +250,12 @@ public:
 	// Refresh data, which may dynamically change
 	void refresh(quint64 nFlags = HI_UPDATE_ALL_WITHOUT_USB);
 
+	// Mark data as changed outside of refresh() (e.g. usb device ownership)
+	void touch() { m_nGeneration.ref(); }
+
+	// Counter bumped on every data change, readable without the owner lock
+	int getGeneration() const { return const_cast<QAtomicInt& >(m_nGeneration).fetchAndAddOrdered(0); }
+
 	/* returns CPU virtualization technology features (SVM or VTx, see enum HvtFeaturesMask)*/
 	static ULONG64 GetHvtFeatures();
 
@@ -308,6 +315,8 @@ private:
 
 	pciStrategy_type m_pciStrategy;
 
+	QAtomicInt m_nGeneration;
+
 private:
     // Common constructor
     void CommonConstructor();
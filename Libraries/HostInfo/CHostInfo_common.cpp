@@ -396,6 +396,7 @@ void CDspHostInfo::updateMemSettings()
 	p_HostHwInfo->getMemorySettings()->setRecommendedMaxVmMemory( rec_mem );
 
 	getAdvancedMemoryInfo();
+	touch();
 } // CDspHostInfo::updateMemSettings()
 
 
@@ -585,6 +586,7 @@ void CDspHostInfo::refresh(quint64 nFlags)
 		WRITE_TRACE(DBG_DEBUG, "--- NET info refreshed ---");
 	}
 
+	touch();
 } // CDspHostInfo::refresh()
 
 QString CDspHostInfo::getKernelBitness()
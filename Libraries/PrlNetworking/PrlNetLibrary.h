@@ -44,6 +44,8 @@
 
 #include <QString>
 #include <QList>
+#include <QByteArray>
+#include <QStringList>
 #include <QHostAddress>
 
 #include <prlcommon/Interfaces/VirtuozzoTypes.h>
@@ -340,6 +342,52 @@ bool SetArpToDevice(const QString &ip, const QString &devName, bool add = true);
 ///         false - some error
 bool SetArpToNodeDevices(const QString &ipAddress, const QString &srcMac, bool add, bool annonce);
 
+/// The same as above but for a list of addresses. All the proxy ARP entries
+/// are programmed via a single netlink session.
+bool SetArpToNodeDevices(const QStringList &ipAddresses, const QString &srcMac, bool add, bool annonce);
+
+namespace Netlink
+{
+struct Handle;
+
+///////////////////////////////////////////////////////////////////////////////
+// class Batch
+/// Persistent rtnetlink session. Route and proxy ARP requests are queued
+/// and sent to the kernel with one sendmsg() per window, acks are collected
+/// after the whole window has been sent.
+
+class Batch
+{
+public:
+	Batch();
+	~Batch();
+
+	/// Queue 'ip route add|del <ip> dev <devName>'
+	bool addRoute(const QString &ip, const QString &devName, bool add = true, int metric = -1);
+	/// Queue 'ip neigh add|del proxy <ip> dev <devName>'
+	bool addArp(const QString &ip, const QString &devName, bool add = true);
+	/// Send all the queued requests.
+	/// @return indexes of failed requests in the order of queueing
+	QList<int> commit();
+	int size() const
+	{
+		return m_queue.size();
+	}
+
+private:
+	Q_DISABLE_COPY(Batch)
+
+	bool open();
+	bool push(const QByteArray& request_, const QString& description_);
+	QList<int> flush(int begin_, int end_);
+
+	Handle* m_handle;
+	QList<QByteArray> m_queue;
+	QStringList m_descriptions;
+};
+
+} // namespace Netlink
+
 #endif
 
 #if defined(_MAC_)
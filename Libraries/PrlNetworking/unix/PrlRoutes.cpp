@@ -33,9 +33,15 @@
 
 #include <prlcommon/Logging/Logging.h>
 
+#include <QSet>
+#include <QPair>
+#include <QVector>
+#include <QScopedPointer>
+
 #include <errno.h>
 #include <unistd.h>
 #include <sys/types.h>
+#include <sys/socket.h>
 #include <linux/sysctl.h>
 #include <net/if.h>
 #include <arpa/inet.h>
@@ -118,110 +124,88 @@ static unsigned ll_name_to_index(const char *name)
         return if_nametoindex(name);
 }
 
-bool PrlNet::SetRouteToDevice(const QString &ip, const QString &devName, bool add, int metric)
+
+namespace
+{
+enum
+{
+	// number of requests sent with one sendmsg(). acks for the whole
+	// window must fit into the socket receive buffer.
+	BATCH_WINDOW = 64
+};
+
+template<class T>
+struct Request
+{
+	struct nlmsghdr n;
+	T body;
+	char buf[1024];
+};
+
+QByteArray pack(const struct nlmsghdr& header_)
 {
-	struct {
-		struct nlmsghdr n;
-		struct rtmsg r;
-		char buf[1024];
-	} req;
-
-	struct rtnl_handle rth;
-	int idx;
+	return QByteArray(reinterpret_cast<const char* >(&header_),
+			NLMSG_ALIGN(header_.nlmsg_len));
+}
+
+QByteArray makeRoute(const QString &ip, unsigned idx, bool add, int metric)
+{
+	Request<struct rtmsg> req;
 	inet_prefix dst;
 
 	memset(&req, 0, sizeof(req));
 
 	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
 	req.n.nlmsg_flags = NLM_F_REQUEST;
-	req.r.rtm_table = RT_TABLE_MAIN;
+	req.body.rtm_table = RT_TABLE_MAIN;
 
 	if (add){
 		req.n.nlmsg_flags |= NLM_F_CREATE|NLM_F_REPLACE;
 		req.n.nlmsg_type = RTM_NEWROUTE;
-		req.r.rtm_protocol = RTPROT_BOOT;
-		req.r.rtm_type = RTN_UNICAST;
-		req.r.rtm_scope = RT_SCOPE_LINK;
+		req.body.rtm_protocol = RTPROT_BOOT;
+		req.body.rtm_type = RTN_UNICAST;
+		req.body.rtm_scope = RT_SCOPE_LINK;
 	}else{
 		req.n.nlmsg_type = RTM_DELROUTE;
-		req.r.rtm_scope = RT_SCOPE_NOWHERE;
+		req.body.rtm_scope = RT_SCOPE_NOWHERE;
 	}
 
 	if (get_prefix(&dst, ip.toUtf8().constData(), AF_INET) < 0)
-		return false;
+		return QByteArray();
 
 	if (metric != -1)
 		addattr32(&req.n, sizeof(req), RTA_PRIORITY, metric);
 	else if (dst.family == AF_INET6)
 		addattr32(&req.n, sizeof(req), RTA_PRIORITY, 1);
 
-	req.r.rtm_family = dst.family;
-	req.r.rtm_dst_len = dst.bitlen;
+	req.body.rtm_family = dst.family;
+	req.body.rtm_dst_len = dst.bitlen;
 
 	if (dst.bytelen){
 		if (addattr_l(&req.n, sizeof(req), RTA_DST, &dst.data, dst.bytelen) < 0)
-			return false;
+			return QByteArray();
 	}else{
 		WRITE_TRACE(DBG_FATAL, "IP is empty '%s'", ip.toUtf8().constData());
-		return false;
-	}
-
-	if ((idx = ll_name_to_index(devName.toUtf8().constData())) == 0) {
-		WRITE_TRACE(DBG_FATAL, "Cannot find device '%s'", devName.toUtf8().constData());
-		return false;
+		return QByteArray();
 	}
 
 	if (addattr32(&req.n, sizeof(req), RTA_OIF, idx) < 0)
-		return false;
-
-	if (rtnl_open(&rth, 0) < 0)
-		return false;
-
-	WRITE_TRACE(DBG_INFO, "route %s ip=%s device='%s' index=%d ",
-			add ? "add" : "del", qPrintable(ip), qPrintable(devName), idx);
-
-#ifdef RTNL_HANDLE_F_SUPPRESS_NLERR
-        int rc = rtnl_talk(&rth, &req.n, NULL);
-#else // RTNL_HANDLE_F_SUPPRESS_NLERR
-        int rc = rtnl_talk(&rth, &req.n, NULL, 0);
-#endif // RTNL_HANDLE_F_SUPPRESS_NLERR
-
-	rtnl_close(&rth);
-
-	if (rc < 0) {
-		WRITE_TRACE(DBG_FATAL, "Failed route %s ip=%s device='%s' index=%d rc=%d",
-			add ? "add" : "del", qPrintable(ip), qPrintable(devName), idx, rc);
+		return QByteArray();
 
-		return false;
-	}
-	return true ;
+	return pack(req.n);
 }
 
-bool PrlNet::SetArpToDevice(const QString &ip, const QString &devName, bool add)
+QByteArray makeArp(const QString &ip, unsigned idx, bool add)
 {
-	//WRITE_TRACE(DBG_FATAL, "Set arp %s proxy ip=%s device='%s' ",
-	//		add ? "add" : "del", ip.toUtf8().constData(), devName.toUtf8().constData());
-        struct {
-                struct nlmsghdr         n;
-                struct ndmsg            ndm;
-                char                    buf[256];
-        } req;
-
-	struct rtnl_handle rth;
+	Request<struct ndmsg> req;
 	inet_prefix dst;
-	unsigned int devIndex = 0;
-
-	if ((devIndex = ll_name_to_index(devName.toUtf8().constData())) == 0) {
-		WRITE_TRACE(DBG_FATAL, "Cannot find device '%s'", devName.toUtf8().constData());
-		return false;
-        }
 
 	memset(&req, 0, sizeof(req));
 
 	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct ndmsg));
 	req.n.nlmsg_flags = NLM_F_REQUEST;
-	req.ndm.ndm_state = NUD_PERMANENT;
-	req.ndm.ndm_flags |= NTF_PROXY;
+	req.body.ndm_state = NUD_PERMANENT;
+	req.body.ndm_flags |= NTF_PROXY;
 
 	if (add){
 		req.n.nlmsg_flags |= NLM_F_CREATE|NLM_F_REPLACE;
@@ -231,68 +215,281 @@ bool PrlNet::SetArpToDevice(const QString &ip, const QString &devName, bool add)
 	}
 
 	if (get_addr(&dst, ip.toUtf8().constData()) < 0)
-		return false;
+		return QByteArray();
 
-        req.ndm.ndm_family = dst.family;
+	req.body.ndm_family = dst.family;
 	if (addattr_l(&req.n, sizeof(req), NDA_DST, &dst.data, dst.bytelen) < 0)
-		return false;
+		return QByteArray();
+
+	req.body.ndm_ifindex = idx;
+
+	return pack(req.n);
+}
+
+} // namespace
+
+namespace PrlNet
+{
+namespace Netlink
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Handle
+
+struct Handle: rtnl_handle
+{
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// class Batch
 
-	req.ndm.ndm_ifindex = devIndex;
+Batch::Batch(): m_handle(NULL)
+{
+}
 
-	if (rtnl_open(&rth, 0) < 0)
+Batch::~Batch()
+{
+	if (NULL == m_handle)
+		return;
+
+	rtnl_close(m_handle);
+	delete m_handle;
+}
+
+bool Batch::open()
+{
+	if (NULL != m_handle)
+		return true;
+
+	QScopedPointer<Handle> h(new Handle());
+	if (rtnl_open(h.data(), 0) < 0)
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to open rtnetlink socket");
 		return false;
+	}
+#if defined(SOL_NETLINK) && defined(NETLINK_CAP_ACK)
+	// do not echo the whole request back in acks
+	int one = 1;
+	setsockopt(h->fd, SOL_NETLINK, NETLINK_CAP_ACK, &one, sizeof(one));
+#endif
+	m_handle = h.take();
+	return true;
+}
 
-	WRITE_TRACE(DBG_DEBUG, "arp %s proxy ip=%s device='%s' index=%d ",
-			add ? "add" : "del", qPrintable(ip), qPrintable(devName), devIndex);
+bool Batch::push(const QByteArray& request_, const QString& description_)
+{
+	if (request_.isEmpty())
+		return false;
 
-#ifdef RTNL_HANDLE_F_SUPPRESS_NLERR
-        int rc = rtnl_talk(&rth, &req.n, NULL);
-#else // RTNL_HANDLE_F_SUPPRESS_NLERR
-        int rc = rtnl_talk(&rth, &req.n, NULL, 0);
-#endif // RTNL_HANDLE_F_SUPPRESS_NLERR
+	m_queue << request_;
+	m_descriptions << description_;
+	return true;
+}
 
-	rtnl_close(&rth);
+bool Batch::addRoute(const QString &ip, const QString &devName, bool add, int metric)
+{
+	unsigned idx = ll_name_to_index(devName.toUtf8().constData());
+	if (idx == 0) {
+		WRITE_TRACE(DBG_FATAL, "Cannot find device '%s'", devName.toUtf8().constData());
+		return false;
+	}
+
+	return push(makeRoute(ip, idx, add, metric), QString("route %1 ip=%2 device='%3' index=%4")
+			.arg(add ? "add" : "del").arg(ip).arg(devName).arg(idx));
+}
 
-	if (rc < 0) {
-		WRITE_TRACE(DBG_FATAL, "Failed arp %s proxy ip=%s device='%s' index=%d rc=%d",
-				add ? "add" : "del", qPrintable(ip), qPrintable(devName), devIndex, rc);
+bool Batch::addArp(const QString &ip, const QString &devName, bool add)
+{
+	unsigned idx = ll_name_to_index(devName.toUtf8().constData());
+	if (idx == 0) {
+		WRITE_TRACE(DBG_FATAL, "Cannot find device '%s'", devName.toUtf8().constData());
 		return false;
 	}
-	return true ;
+
+	return push(makeArp(ip, idx, add), QString("arp %1 proxy ip=%2 device='%3' index=%4")
+			.arg(add ? "add" : "del").arg(ip).arg(devName).arg(idx));
+}
+
+QList<int> Batch::flush(int begin_, int end_)
+{
+	QList<int> output;
+	int n = end_ - begin_;
+	__u32 s = m_handle->seq + 1;
+	QVector<struct iovec> v(n);
+	for (int i = 0; i < n; ++i)
+	{
+		QByteArray& r = m_queue[begin_ + i];
+		struct nlmsghdr* h = reinterpret_cast<struct nlmsghdr* >(r.data());
+		h->nlmsg_flags |= NLM_F_ACK;
+		h->nlmsg_seq = ++m_handle->seq;
+		v[i].iov_base = r.data();
+		v[i].iov_len = r.size();
+		WRITE_TRACE(DBG_DEBUG, "%s", qPrintable(m_descriptions.at(begin_ + i)));
+	}
+
+	struct sockaddr_nl a;
+	memset(&a, 0, sizeof(a));
+	a.nl_family = AF_NETLINK;
+	struct msghdr m;
+	memset(&m, 0, sizeof(m));
+	m.msg_name = &a;
+	m.msg_namelen = sizeof(a);
+	m.msg_iov = v.data();
+	m.msg_iovlen = n;
+
+	ssize_t rc;
+	do
+	{
+		rc = sendmsg(m_handle->fd, &m, 0);
+	} while (rc < 0 && errno == EINTR);
+	if (rc < 0)
+	{
+		WRITE_TRACE(DBG_FATAL, "Unable to send %d netlink requests: %s", n, strerror(errno));
+		for (int i = begin_; i < end_; ++i)
+			output << i;
+
+		return output;
+	}
+
+	QVector<bool> p(n, true);
+	int pending = n;
+	char b[16384];
+	while (pending > 0)
+	{
+		rc = recv(m_handle->fd, b, sizeof(b), 0);
+		if (rc < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			WRITE_TRACE(DBG_FATAL, "Unable to receive netlink acks: %s", strerror(errno));
+			break;
+		}
+		int l = rc;
+		for (struct nlmsghdr* h = reinterpret_cast<struct nlmsghdr* >(b);
+			NLMSG_OK(h, l); h = NLMSG_NEXT(h, l))
+		{
+			if (h->nlmsg_type != NLMSG_ERROR)
+				continue;
+
+			int i = h->nlmsg_seq - s;
+			if (i < 0 || i >= n || !p[i])
+				continue;
+
+			p[i] = false;
+			--pending;
+			struct nlmsgerr* e = reinterpret_cast<struct nlmsgerr* >(NLMSG_DATA(h));
+			if (e->error == 0)
+				continue;
+
+			WRITE_TRACE(DBG_FATAL, "Failed %s rc=%d (%s)",
+				qPrintable(m_descriptions.at(begin_ + i)), e->error, strerror(-e->error));
+			output << begin_ + i;
+		}
+	}
+	for (int i = 0; i < n && pending > 0; ++i)
+	{
+		if (p[i])
+			output << begin_ + i;
+	}
+
+	return output;
+}
+
+QList<int> Batch::commit()
+{
+	QList<int> output;
+	if (m_queue.isEmpty())
+		return output;
+
+	if (!open())
+	{
+		for (int i = 0; i < m_queue.size(); ++i)
+			output << i;
+	}
+	else
+	{
+		for (int i = 0; i < m_queue.size(); i += BATCH_WINDOW)
+			output << flush(i, qMin(i + (int)BATCH_WINDOW, m_queue.size()));
+	}
+
+	m_queue.clear();
+	m_descriptions.clear();
+	return output;
+}
+
+} // namespace Netlink
+} // namespace PrlNet
+
+bool PrlNet::SetRouteToDevice(const QString &ip, const QString &devName, bool add, int metric)
+{
+	Netlink::Batch b;
+	if (!b.addRoute(ip, devName, add, metric))
+		return false;
+
+	return b.commit().isEmpty();
+}
+
+bool PrlNet::SetArpToDevice(const QString &ip, const QString &devName, bool add)
+{
+	Netlink::Batch b;
+	if (!b.addArp(ip, devName, add))
+		return false;
+
+	return b.commit().isEmpty();
 }
 
 bool PrlNet::SetArpToNodeDevices(const QString &ip, const QString &srcMac, bool add, bool annonce)
 {
+	return SetArpToNodeDevices(QStringList(ip), srcMac, add, annonce);
+}
+
+bool PrlNet::SetArpToNodeDevices(const QStringList &ips, const QString &srcMac, bool add, bool annonce)
+{
+	if (ips.isEmpty())
+		return true;
+
 	QString old;
 
 	QFile f("/proc/sys/net/ipv4/ip_nonlocal_bind");
 	if (!f.open(QIODevice::ReadWrite | QIODevice::Unbuffered))
 	{
 		WRITE_TRACE(DBG_FATAL, "Failed to enable nonlocal bind. Cannot configure arp for ip %s",
-			qPrintable(ip));
+			qPrintable(ips.join(",")));
 		return false;
 	}
 	QTextStream(&f) >> old << 1;
 
 	QStringList names = makeAdapterList(PrlNet::Filter::Routed());
 
+	bool output = true;
+	Netlink::Batch b;
+	QList<QPair<QString, QString> > q;
 	foreach(const QString& adapter, names)
 	{
-		bool rc = SetArpToDevice(ip, adapter, add);
+		foreach(const QString& ip, ips)
+		{
+			if (b.addArp(ip, adapter, add))
+				q << qMakePair(ip, adapter);
+			else
+				output = false;
+		}
+	}
 
-		if (!rc) {
+	QSet<int> x = b.commit().toSet();
+	for (int i = 0; i < q.size(); ++i)
+	{
+		const QString& ip = q.at(i).first;
+		const QString& adapter = q.at(i).second;
+		if (x.contains(i)) {
 			WRITE_TRACE(DBG_FATAL, "Failed to %s arp for device %s",
 				add ? "set" : "remove", qPrintable(adapter));
-			QTextStream(&f) << old;
-			return false;
-		}
-		else
-		{
-			WRITE_TRACE(DBG_INFO, "Arp on device '%s' for ip %s is %s",
-				qPrintable(adapter), qPrintable(ip),
-				add ? "configured" : "disabled");
+			output = false;
+			continue;
 		}
 
+		WRITE_TRACE(DBG_INFO, "Arp on device '%s' for ip %s is %s",
+			qPrintable(adapter), qPrintable(ip),
+			add ? "configured" : "disabled");
 
 		if (annonce && add) {
 			WRITE_TRACE(DBG_INFO, "Arp on device '%s' for ip %s is annonced",
@@ -303,5 +500,5 @@ bool PrlNet::SetArpToNodeDevices(const QString &ip, const QString &srcMac, bool
 
 	// Return old value
 	QTextStream(&f) << old;
-	return true;
+	return output;
 }
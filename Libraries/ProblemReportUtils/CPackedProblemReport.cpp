@@ -60,8 +60,11 @@
 #include <QFile>
 #include <QString>
 #include <QSysInfo>
+#include <QThread>
+#include <QtConcurrentRun>
 
 #include "CPackedProblemReport.h"
+#include "CPackedProblemReportCompressor.h"
 
 #include "CProblemReportUtils.h"
 #include <prlcommon/PrlCommonUtilsBase/VirtuozzoDirs.h>
@@ -193,6 +196,182 @@ tartype_t s_interface = {
 	gzwrite_frontend
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// struct Parallel
+
+Parallel::Parallel() : m_count(0)
+{
+}
+
+QThreadPool* Parallel::getPool()
+{
+	QMutexLocker lock(&m_lock);
+	if (m_pool.isNull())
+	{
+		m_pool.reset(new QThreadPool());
+		m_pool->setObjectName("report-compressor");
+		m_pool->setMaxThreadCount(qMax(1, QThread::idealThreadCount()));
+	}
+	return m_pool.data();
+}
+
+QByteArray Parallel::pack(QByteArray block_)
+{
+	z_stream z;
+	memset(&z, 0, sizeof(z));
+	// 16 + MAX_WBITS produces a complete gzip member with header and trailer
+	if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 16 + MAX_WBITS,
+			8, Z_DEFAULT_STRATEGY) != Z_OK)
+		return QByteArray();
+
+	QByteArray output;
+	output.resize(deflateBound(&z, block_.size()) + 32);
+	z.next_in = reinterpret_cast<Bytef* >(block_.data());
+	z.avail_in = block_.size();
+	z.next_out = reinterpret_cast<Bytef* >(output.data());
+	z.avail_out = output.size();
+	int e = deflate(&z, Z_FINISH);
+	output.resize(z.total_out);
+	deflateEnd(&z);
+
+	return e == Z_STREAM_END ? output : QByteArray();
+}
+
+int Parallel::getWindow()
+{
+	return 2 * getPool()->maxThreadCount();
+}
+
+void Parallel::submit(Stream& stream_, int size_)
+{
+	stream_.inflight.enqueue(QtConcurrent::run(getPool(), &Parallel::pack,
+		stream_.pending.left(size_)));
+	stream_.pending.remove(0, size_);
+}
+
+void Parallel::drain(Stream& stream_, int limit_)
+{
+	while (stream_.inflight.size() > limit_)
+	{
+		QByteArray b = stream_.inflight.dequeue().result();
+		if (stream_.failed)
+			continue;
+
+		if (b.isEmpty())
+		{
+			stream_.failed = true;
+			errno = EIO;
+			continue;
+		}
+		for (int n = 0; n < b.size();)
+		{
+			ssize_t w = ::write(stream_.fd, b.constData() + n, b.size() - n);
+			if (w < 0)
+			{
+				if (errno == EINTR)
+					continue;
+
+				stream_.failed = true;
+				break;
+			}
+			n += w;
+		}
+	}
+}
+
+int Parallel::open(const char *pathname, int oflags, int mode)
+{
+	if ((oflags & O_ACCMODE) != O_WRONLY)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+
+	int fd = ::open(pathname, oflags, mode);
+	if (fd == -1)
+		return -1;
+
+	if ((oflags & O_CREAT) && fchmod(fd, mode))
+	{
+		::close(fd);
+		return -1;
+	}
+
+	QMutexLocker lock(&m_lock);
+	m_streams.insert(m_count, new Stream(fd));
+	return m_count++;
+}
+
+int Parallel::close(int index)
+{
+	QMutexLocker lock(&m_lock);
+	Stream* s = m_streams.take(index);
+	lock.unlock();
+	if (NULL == s) {
+		errno = EINVAL;
+		return -1;
+	}
+	if (!s->pending.isEmpty())
+		submit(*s, s->pending.size());
+
+	drain(*s, 0);
+	int output = s->failed ? -1 : 0;
+	if (::close(s->fd) != 0)
+		output = -1;
+
+	delete s;
+	return output;
+}
+
+ssize_t Parallel::write(int index, const void *buf, size_t len)
+{
+	QMutexLocker lock(&m_lock);
+	Stream* s = m_streams.value(index);
+	lock.unlock();
+	if (NULL == s) {
+		errno = EINVAL;
+		return -1;
+	}
+	s->pending.append(static_cast<const char* >(buf), len);
+	while (s->pending.size() >= PRL_REPORT_COMPRESS_BLOCK_SIZE)
+	{
+		submit(*s, PRL_REPORT_COMPRESS_BLOCK_SIZE);
+		drain(*s, getWindow());
+	}
+
+	return s->failed ? -1 : (ssize_t)len;
+}
+
+Parallel s_parallel;
+
+int popen_frontend(const char *pathname, int oflags, int mode)
+{
+	return s_parallel.open(pathname, oflags, mode);
+}
+
+int pclose_frontend(int index)
+{
+	return s_parallel.close(index);
+}
+
+ssize_t pread_frontend(int, void *, size_t)
+{
+	errno = EINVAL;
+	return -1;
+}
+
+ssize_t pwrite_frontend(int index, const void *buf, size_t len)
+{
+	return s_parallel.write(index, buf, len);
+}
+
+tartype_t s_parallelInterface = {
+	(openfunc_t)popen_frontend,
+	pclose_frontend,
+	pread_frontend,
+	pwrite_frontend
+};
+
 } // namespace Compressor
 
 PRL_RESULT CPackedProblemReport::createInstance( CPackedProblemReport::packedReportSide side ,
@@ -880,7 +1059,7 @@ PRL_RESULT CPackedProblemReport::packReport()
 
 	if ( tar_open( &t,
 					m_strArchPath.toUtf8().data(),
-					&Compressor::s_interface,
+					&Compressor::s_parallelInterface,
 					O_WRONLY | O_CREAT,
 					0644,
 					0) == -1 )
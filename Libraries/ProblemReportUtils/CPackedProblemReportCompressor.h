@@ -0,0 +1,91 @@
+/*
+ * CPackedProblemReportCompressor.h: parallel gzip compressor of problem
+ * report archives
+ *
+ * Copyright (c) 2026 Virtuozzo International GmbH. All rights reserved.
+ *
+ * This file is part of Virtuozzo SDK. Virtuozzo SDK is free
+ * software; you can redistribute it and/or modify it under the
+ * terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License,
+ * or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library.  If not, see
+ * <http://www.gnu.org/licenses/> or write to Free Software Foundation,
+ * 51 Franklin Street, Fifth Floor Boston, MA 02110, USA.
+ *
+ * Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+ * Schaffhausen, Switzerland.
+ */
+
+
+#ifndef CPACKED_PROBLEMREPORT_COMPRESSOR_H
+#define CPACKED_PROBLEMREPORT_COMPRESSOR_H
+
+#include <sys/types.h>
+#include <QByteArray>
+#include <QFuture>
+#include <QMap>
+#include <QMutex>
+#include <QQueue>
+#include <QScopedPointer>
+#include <QThreadPool>
+
+#ifndef PRL_REPORT_COMPRESS_BLOCK_SIZE
+#define PRL_REPORT_COMPRESS_BLOCK_SIZE 1024*1024
+#endif
+
+namespace Compressor
+{
+///////////////////////////////////////////////////////////////////////////////
+// struct Parallel
+// Write only compressor. The stream is cut into blocks which are deflated
+// concurrently into independent gzip members and written in order. The
+// result is a multi-member gzip file which gzread() reads transparently,
+// the same way as the output of pigz. Blocks are deflated on the own pool
+// of the compressor, thus a big report does not occupy the global one. The
+// pool is created by the first open() for the compressor is a static object
+// that exists before QCoreApplication does.
+
+struct Parallel
+{
+	Parallel();
+
+	int open(const char *path, int oflags, int mode);
+	int close(int index);
+	ssize_t write(int index, const void *buf, size_t len);
+
+private:
+	struct Stream
+	{
+		explicit Stream(int fd_) : fd(fd_), failed(false)
+		{
+		}
+
+		int fd;
+		bool failed;
+		QByteArray pending;
+		QQueue<QFuture<QByteArray> > inflight;
+	};
+
+	static QByteArray pack(QByteArray block_);
+	QThreadPool* getPool();
+	int getWindow();
+	void submit(Stream& stream_, int size_);
+	void drain(Stream& stream_, int limit_);
+
+	int m_count;
+	QMutex m_lock;
+	QMap<int, Stream*> m_streams;
+	QScopedPointer<QThreadPool> m_pool;
+};
+
+} // namespace Compressor
+
+#endif // CPACKED_PROBLEMREPORT_COMPRESSOR_H
@@ -34,6 +34,7 @@ INCLUDEPATH += $$ROOT_LEVEL
 HEADERS += \
            CProblemReportUtils_common.h \
 		   CPackedProblemReport.h \
+		   CPackedProblemReportCompressor.h \
 		   CProblemReportPostWrap.h \
 		   ProblemReportLocalCertificates.h
 
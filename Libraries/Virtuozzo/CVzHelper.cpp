@@ -525,28 +525,83 @@ PRL_RESULT CVzOperationHelper::run_prg(const char *name, const QStringList &lstA
 	return PRL_ERR_SUCCESS;
 }
 
-int CVzHelper::get_envid_list(QStringList &lst)
+static int get_env_ids_by_state(int mask, QStringList &lst)
 {
 	struct vzctl_ids *ctids = vzctl2_alloc_env_ids();
 	if (ctids == NULL)
 		return PRL_ERR_OUT_OF_MEMORY;
 
-	int n = vzctl2_get_env_ids_by_state(ctids, ENV_STATUS_EXISTS);
+	int n = vzctl2_get_env_ids_by_state(ctids, mask);
 	if (n < 0) {
 		vzctl2_free_env_ids(ctids);
 		return PRL_ERR_FAILURE;
 	}
 
-	for (int i = 0 ; i < n; i++) {	
+	for (int i = 0 ; i < n; i++)
 		lst += ctids->ids[i];
-		WRITE_TRACE(DBG_FATAL, "register CT: %s", ctids->ids[i]);
-	}
 
 	vzctl2_free_env_ids(ctids);
 
 	return PRL_ERR_SUCCESS;
 }
 
+int CVzHelper::get_envid_list(QStringList &lst)
+{
+	int ret = get_env_ids_by_state(ENV_STATUS_EXISTS, lst);
+	if (PRL_FAILED(ret))
+		return ret;
+
+	foreach (const QString& i, lst)
+		WRITE_TRACE(DBG_FATAL, "register CT: %s", QSTR2UTF8(i));
+
+	return PRL_ERR_SUCCESS;
+}
+
+int CVzHelper::get_env_status_list(QHash<QString, VIRTUAL_MACHINE_STATE> &states)
+{
+	QStringList lst;
+	int ret = get_env_ids_by_state(ENV_STATUS_EXISTS, lst);
+	if (PRL_FAILED(ret)) {
+		WRITE_TRACE(DBG_FATAL, "Failed to get Ct list: %s",
+				vzctl2_get_last_error());
+		return ret;
+	}
+
+	// NB. the listing by state has no transitions (migrating,
+	// restoring) and no checkpoint suspend, so query every container.
+	// the mount state is checked the fast way
+	foreach (const QString& c, lst) {
+		VIRTUAL_MACHINE_STATE s = VMS_UNKNOWN;
+		if (0 == get_env_status_by_ctid(c, s))
+			states[c] = s;
+	}
+
+	return PRL_ERR_SUCCESS;
+}
+
+int CVzHelper::get_env_name(const QString &uuid, QString &name)
+{
+	QString ctid = CVzHelper::get_ctid_by_uuid(uuid);
+	if (ctid.isEmpty())
+		return PRL_ERR_CT_NOT_FOUND;
+
+	int ret;
+	VzctlHandleWrap h(vzctl2_env_open(QSTR2UTF8(ctid), 0, &ret));
+	if (h == NULL) {
+		WRITE_TRACE(DBG_FATAL, "failed vzctl2_env_open ctid=%s %s [%d]",
+			QSTR2UTF8(ctid), vzctl2_get_last_error(), ret);
+		return PRL_ERR_OPERATION_FAILED;
+	}
+
+	const char *data;
+	if (vzctl2_get_name(h, &data) != 0 || data == NULL)
+		name = ctid;
+	else
+		name = UTF8_2QSTR(data);
+
+	return PRL_ERR_SUCCESS;
+}
+
 int CVzHelper::get_env_status_by_ctid(const QString &ctid, VIRTUAL_MACHINE_STATE &nState)
 {
 	vzctl_env_status_t status;
@@ -301,6 +301,14 @@ public:
 	int get_envid_list(QStringList &lst);
 	static int get_env_status_by_ctid(const QString &ctid, VIRTUAL_MACHINE_STATE &nState);
 	static int get_env_status(const QString &uuid, VIRTUAL_MACHINE_STATE &nState);
+	/**
+	 * Get states of all registered containers, transitional states
+	 * included. The ids are listed at once, the status is queried per
+	 * container. Map is keyed by ctid.
+	 */
+	static int get_env_status_list(QHash<QString, VIRTUAL_MACHINE_STATE> &states);
+	/* Get the container name without building the whole configuration */
+	static int get_env_name(const QString &uuid, QString &name);
 	static tribool_type is_env_running(const QString &uuid);
 	static Ct::Statistics::Aggregate* get_env_stat(const QString& uuid);
 	static int get_env_disk_stat(const SmartPtr<CVmConfiguration>& config,
@@ -33,6 +33,8 @@
 
 // #define FORCE_LOGGING_LEVEL DBG_DEBUG
 
+#include <algorithm>
+#include <QtEndian>
 #include "CVmFileListCopy.h"
 #include <prlcommon/PrlCommonUtilsBase/SysError.h>
 #include <prlcommon/Interfaces/VirtuozzoNamespace.h>
@@ -41,8 +43,24 @@
 #include <prlcommon/HostUtils/HostUtils.h>
 #include <prlcommon/Std/AtomicOps.h>
 #include <prlcommon/PrlCommonUtilsBase/PrlStringifyConsts.h>
+#ifdef _LIN_
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+#define MIGRATION_PROTO_VER 0x3
+
+/* pipelined file chunks, batched directories and binary chunk flags */
+#define FILECOPY_PROTO_WINDOW 0x2
+/* hole chunks and zlib compressed chunks */
+#define FILECOPY_PROTO_SPARSE 0x3
 
-#define MIGRATION_PROTO_VER 0x1
+/* directories per FileCopyDirCmd package */
+#define DIR_BATCH_SIZE 16
+
+/* optional features agreed on in the first request */
+#define FILECOPY_CAP_ZLIB	0x1
+#define FILECOPY_CAPS		FILECOPY_CAP_ZLIB
 
 #define UNDEF_PLATFORM	0
 #define MAC_PLATFORM	1
@@ -69,14 +87,17 @@ static int getPlatform()
 #define REQ_FIRST_VER	0
 #define REQ_FIRST_PLATF	1
 #define REQ_FIRST_SIZE	2
+#define REQ_FIRST_CAPS	3
 
 #define REP_FIRST_VER	0
 #define REP_FIRST_PLATF	1
+#define REP_FIRST_CAPS	2
 
 #define REQ_DIR_PATH	0
 #define REQ_DIR_OWNER	1
 #define REQ_DIR_GROUP	2
 #define REQ_DIR_PERMS	3
+#define REQ_DIR_COUNT	4
 
 #define REQ_FILE_PATH	0
 #define REQ_FILE_SIZE	1
@@ -95,6 +116,8 @@ static int getPlatform()
 enum FCHUNK_FLAGS {
 	REQ_FCHUNK_FL_DATA = 0x0, /* data block contains valid data */
 	REQ_FCHUNK_FL_LAST = 0x1, /* last file chunk (end of file)*/
+	REQ_FCHUNK_FL_HOLE = 0x2, /* data block contains the hole length */
+	REQ_FCHUNK_FL_ZLIB = 0x4, /* data block is qCompress()'ed */
 };
 
 namespace
@@ -117,7 +140,10 @@ void Throttle::set(long msec_)
 	if (!m_time)
 		return;
 
-	m_time = boost::chrono::steady_clock::now() + boost::chrono::milliseconds(msec_);
+	// NB. accumulate the delay so that several packages sent without
+	// waiting are accounted in full.
+	m_time = std::max(m_time.get(), boost::chrono::steady_clock::now()) +
+		boost::chrono::milliseconds(msec_);
 }
 
 void Throttle::wait()
@@ -420,6 +446,11 @@ m_bIsOperationWasCanceled(false)
 	m_pEvent = pEvent;
 }
 
+int CVmFileListCopyBase::getVersion() const
+{
+	return qMin(m_nRemoteVersion, MIGRATION_PROTO_VER);
+}
+
 void CVmFileListCopyBase::SetRequest(const SmartPtr<IOPackage> &pRequest)
 {
 	m_pRequest = pRequest;
@@ -489,6 +520,33 @@ void CVmFileListCopyBase::NotifyFileCopyWasFinished()
 
 //**************************************Implementation of file list copying on source side****************************
 
+qint64 CVmFileListCopyFile::skipHole()
+{
+#if defined(_LIN_) && defined(SEEK_DATA)
+	int fd = m_cFile.handle();
+	qint64 pos = m_cFile.pos();
+	if (fd < 0 || pos < m_nDataEnd)
+		return 0;
+
+	off_t d = ::lseek(fd, pos, SEEK_DATA);
+	if (d == (off_t)-1) {
+		/* ENXIO: the rest of the file is a hole */
+		if (errno != ENXIO)
+			return 0;
+		d = m_cFile.size();
+	}
+	off_t h = ::lseek(fd, d, SEEK_HOLE);
+	m_nDataEnd = (h == (off_t)-1 ? m_cFile.size() : h);
+	/* NB. the file is unbuffered: seek() puts the descriptor back in sync */
+	if (!m_cFile.seek(qMax<qint64>(d, pos)) || d <= pos)
+		return 0;
+
+	return d - pos;
+#else
+	return 0;
+#endif
+}
+
 CVmFileListCopySource::CVmFileListCopySource(
 	CVmFileListCopySender *hSender,
 	const QString &sVmUuid,
@@ -497,7 +555,8 @@ CVmFileListCopySource::CVmFileListCopySource(
 	CVmEvent *pEvent,
 	quint32 nTimeout)
 :
-CVmFileListCopyBase(hSender, sVmUuid, sWorkPath, pEvent, nTimeout)
+CVmFileListCopyBase(hSender, sVmUuid, sWorkPath, pEvent, nTimeout),
+m_bCompress(false)
 {
 	m_sWorkPath = sWorkPath;
 	m_nTotalSize = nTotalSize;
@@ -569,7 +628,12 @@ PRL_RESULT CVmFileListCopySource::Copy(
 	if (m_bIsOperationWasCanceled)
 		return PRL_ERR_OPERATION_WAS_CANCELED;
 
-	for (i = 0; i < dirList.size(); ++i)
+	if (getVersion() >= FILECOPY_PROTO_WINDOW)
+	{
+		if (PRL_FAILED(ret = SendDirBatch(dirList)))
+			return ret;
+	}
+	else for (i = 0; i < dirList.size(); ++i)
 	{
 		if (PRL_FAILED(ret = SendDirRequest(dirList.at(i))))
 			return ret;
@@ -585,6 +649,9 @@ PRL_RESULT CVmFileListCopySource::Copy(
 			return PRL_ERR_OPERATION_WAS_CANCELED;
 	}
 
+	if (PRL_FAILED(ret = Flush()))
+		return ret;
+
 	if (PRL_FAILED(ret = SendFinishRequest()))
 		return ret;
 
@@ -601,27 +668,36 @@ void CVmFileListCopySource::cancelOperation()
 PRL_RESULT CVmFileListCopySource::SendFirstRequest()
 {
 	PRL_RESULT ret;
+	SmartPtr<IOPackage> request;
 	SmartPtr<IOPackage> p;
-	SmartPtr<IOPackage> reply;
 	char buf[BUFSIZ];
 
-	p = IOPackage::createInstance(FileCopyFirstRequest, 3);
-	/* send migration protocol version, total migration size and
-	   source platform in first request for target vm app */
+	request = IOPackage::createInstance(FileCopyFirstRequest, 4);
+	/* send migration protocol version, total migration size, source
+	   platform and wanted features in first request for target vm app.
+	   older targets ignore the features buffer */
 	snprintf(buf, sizeof(buf), "%d", MIGRATION_PROTO_VER);
-	p->fillBuffer(REQ_FIRST_VER, IOPackage::RawEncoding, buf, strlen(buf)+1);
+	request->fillBuffer(REQ_FIRST_VER, IOPackage::RawEncoding, buf, strlen(buf)+1);
 	snprintf(buf, sizeof(buf), "%d", getPlatform());
-	p->fillBuffer(REQ_FIRST_PLATF, IOPackage::RawEncoding, buf, strlen(buf)+1);
+	request->fillBuffer(REQ_FIRST_PLATF, IOPackage::RawEncoding, buf, strlen(buf)+1);
 	snprintf(buf, sizeof(buf), "%lld", m_nTotalSize);
-	p->fillBuffer(REQ_FIRST_SIZE, IOPackage::RawEncoding, buf, strlen(buf)+1);
+	request->fillBuffer(REQ_FIRST_SIZE, IOPackage::RawEncoding, buf, strlen(buf)+1);
+	snprintf(buf, sizeof(buf), "%u", m_bCompress ? FILECOPY_CAP_ZLIB : 0);
+	request->fillBuffer(REQ_FIRST_CAPS, IOPackage::RawEncoding, buf, strlen(buf)+1);
 
-	WRITE_TRACE(DBG_DEBUG, "< FileCopy first request: version: %d, platform: %d, size: %lld",
-		MIGRATION_PROTO_VER, getPlatform(), m_nTotalSize);
+	WRITE_TRACE(DBG_DEBUG, "< FileCopy first request: version: %d, platform: %d, size: %lld, compression: %d",
+		MIGRATION_PROTO_VER, getPlatform(), m_nTotalSize, m_bCompress);
 
-	if ((ret = SendReqAndWaitReply(p, reply)) != PRL_ERR_SUCCESS)
+	/* p is the received reply, the peer version is parsed from it */
+	if ((ret = SendReqAndWaitReply(request, p)) != PRL_ERR_SUCCESS)
 		return ret;
 
-	if (reply->header.type == FileCopyFirstReply) {
+	if (p->header.type == FileCopyFirstReply) {
+		if (p->header.buffersNumber <= REP_FIRST_PLATF) {
+			WRITE_TRACE(DBG_FATAL, "Bad first reply: %u buffers", p->header.buffersNumber);
+			return PRL_ERR_INVALID_PARAM;
+		}
+
 		if (sscanf(p->buffers[REP_FIRST_VER].getImpl(), "%d", &m_nRemoteVersion) != 1) {
 			WRITE_TRACE(DBG_FATAL, "Bad remote version: [%s]", p->buffers[REP_FIRST_VER].getImpl());
 			return PRL_ERR_INVALID_PARAM;
@@ -632,10 +708,17 @@ PRL_RESULT CVmFileListCopySource::SendFirstRequest()
 			return PRL_ERR_INVALID_PARAM;
 		}
 
-		WRITE_TRACE(DBG_FATAL, "> FileCopy first reply: version: %d, platform %d",
-			m_nRemoteVersion, m_nRemotePlatform);
+		/* compress only if the target agreed on it */
+		unsigned caps = 0;
+		if (p->header.buffersNumber <= REP_FIRST_CAPS ||
+			sscanf(p->buffers[REP_FIRST_CAPS].getImpl(), "%u", &caps) != 1)
+			caps = 0;
+		m_bCompress = m_bCompress && (caps & FILECOPY_CAP_ZLIB);
+
+		WRITE_TRACE(DBG_FATAL, "> FileCopy first reply: version: %d, platform %d, compression: %d",
+			m_nRemoteVersion, m_nRemotePlatform, m_bCompress);
 
-	} else if (reply->header.type == FileCopyError) {
+	} else if (p->header.type == FileCopyError) {
 		QString sError = UTF8_2QSTR(p->buffers[ERR_EVENT].getImpl());
 		return processTargetError(sError);
 	} else {
@@ -644,34 +727,56 @@ PRL_RESULT CVmFileListCopySource::SendFirstRequest()
 	return PRL_ERR_SUCCESS;
 }
 
-PRL_RESULT CVmFileListCopySource::SendDirRequest(const QPair<QFileInfo, QString> &dPair)
+void CVmFileListCopySource::FillDirRequest(const SmartPtr<IOPackage> &p, int base,
+	const QPair<QFileInfo, QString> &dPair)
 {
-	SmartPtr<IOPackage> p;
 	QByteArray data;
 	char buf[BUFSIZ];
 	QFileInfo di = dPair.first;
 	QString rpath = dPair.second;
 
-	p = IOPackage::createInstance(FileCopyDirCmd, 4);
-
 	data = rpath.toUtf8();
-	p->fillBuffer(REQ_DIR_PATH, IOPackage::RawEncoding, data, data.size()+1);
+	p->fillBuffer(base + REQ_DIR_PATH, IOPackage::RawEncoding, data, data.size()+1);
 	data = di.owner().toUtf8();
-	p->fillBuffer(REQ_DIR_OWNER, IOPackage::RawEncoding, data, data.size()+1);
+	p->fillBuffer(base + REQ_DIR_OWNER, IOPackage::RawEncoding, data, data.size()+1);
 	data = di.group().toUtf8();
-	p->fillBuffer(REQ_DIR_GROUP, IOPackage::RawEncoding, data, data.size()+1);
+	p->fillBuffer(base + REQ_DIR_GROUP, IOPackage::RawEncoding, data, data.size()+1);
 	snprintf(buf, sizeof(buf), "%x", int(di.permissions()));
-	p->fillBuffer(REQ_DIR_PERMS, IOPackage::RawEncoding, buf, strlen(buf)+1);
+	p->fillBuffer(base + REQ_DIR_PERMS, IOPackage::RawEncoding, buf, strlen(buf)+1);
 
 	WRITE_TRACE(DBG_DEBUG, "< FileCopy DirRequest: %x\t%s.%s\t%s",
 			int(di.permissions()),
 			QSTR2UTF8(di.owner()),
 			QSTR2UTF8(di.group()),
 			QSTR2UTF8(rpath));
+}
+
+PRL_RESULT CVmFileListCopySource::SendDirRequest(const QPair<QFileInfo, QString> &dPair)
+{
+	SmartPtr<IOPackage> p = IOPackage::createInstance(FileCopyDirCmd, REQ_DIR_COUNT);
+	FillDirRequest(p, 0, dPair);
 
 	return (SendReqWithAck(p));
 }
 
+/* send directories by DIR_BATCH_SIZE in a package without ack waiting */
+PRL_RESULT CVmFileListCopySource::SendDirBatch(const objectList_type &dirList)
+{
+	PRL_RESULT ret;
+
+	for (int i = 0; i < dirList.size(); i += DIR_BATCH_SIZE)
+	{
+		int n = qMin(DIR_BATCH_SIZE, dirList.size() - i);
+		SmartPtr<IOPackage> p = IOPackage::createInstance(FileCopyDirCmd, n * REQ_DIR_COUNT);
+		for (int j = 0; j < n; ++j)
+			FillDirRequest(p, j * REQ_DIR_COUNT, dirList.at(i + j));
+
+		if (PRL_FAILED(ret = SendPackage(p)))
+			return ret;
+	}
+	return PRL_ERR_SUCCESS;
+}
+
 PRL_RESULT CVmFileListCopySource::SendFileRequest(const QPair<QFileInfo, QString> &fPair)
 {
 	PRL_RESULT ret;
@@ -699,7 +804,11 @@ PRL_RESULT CVmFileListCopySource::SendFileRequest(const QPair<QFileInfo, QString
 			fi.size(),
 			rpath.toUtf8().constData());
 
-	ret = SendReqWithAck(p);
+	/* the target acks the file header in the legacy protocol only */
+	if (getVersion() >= FILECOPY_PROTO_WINDOW)
+		ret = SendPackage(p);
+	else
+		ret = SendReqWithAck(p);
 	if (PRL_FAILED(ret))
 		return (ret);
 
@@ -713,12 +822,13 @@ PRL_RESULT CVmFileListCopySource::SendFileRequest(const QPair<QFileInfo, QString
 PRL_RESULT CVmFileListCopySource::SendFileBody(const QString & path)
 {
 	PRL_RESULT ret = PRL_ERR_SUCCESS;
-	SmartPtr<IOPackage> p = IOPackage::createInstance(FileCopyFileChunkCmd, 2);
-	quint64 flags = REQ_FCHUNK_FL_DATA;
+	SmartPtr<IOPackage> p;
+	quint64 flags;
 	qint64 size;
 	int done = 0;
 	char buf[BUFSIZ];
-	IOSendJob::Handle job;
+	bool binary = (getVersion() >= FILECOPY_PROTO_WINDOW);
+	bool sparse = (getVersion() >= FILECOPY_PROTO_SPARSE);
 
 	m_pCopyObject->setName(path);
 	if (!m_pCopyObject->open(QIODevice::ReadOnly)) {
@@ -735,28 +845,46 @@ PRL_RESULT CVmFileListCopySource::SendFileBody(const QString & path)
 		}
 
 		if (m_hSender->m_sErrorString.size()) {
+			m_lstJobs.clear();
 			ret = processTargetError(m_hSender->m_sErrorString);
 			break;
 		}
-		if ((size = m_pCopyObject->getBuffer()) == -1) {
+		flags = REQ_FCHUNK_FL_DATA;
+		/* a package per chunk: up to FILE_COPY_WINDOW of them are in flight */
+		p = IOPackage::createInstance(FileCopyFileChunkCmd, 2);
+		if (sparse && 0 < (size = m_pCopyObject->skipHole())) {
+			/* the target seeks over the hole instead of writing zeros */
+			flags |= REQ_FCHUNK_FL_HOLE;
+			quint64 x = qToLittleEndian<quint64>(size);
+			p->fillBuffer(REQ_FCHUNK_DATA, IOPackage::RawEncoding, (const char* )&x, sizeof(x));
+		} else if ((size = m_pCopyObject->getBuffer()) == -1) {
 			WRITE_TRACE(DBG_FATAL, "file \"%s\" read error", QSTR2UTF8(path));
 			ret = PRL_ERR_FILE_READ_ERROR;
 			break;
+		} else {
+			QByteArray z;
+			if (sparse && m_bCompress && 0 < size)
+				z = qCompress((const uchar* )m_pCopyObject->m_pBuffer.getImpl(), size, 1);
+			if (!z.isEmpty() && z.size() < size) {
+				flags |= REQ_FCHUNK_FL_ZLIB;
+				p->fillBuffer(REQ_FCHUNK_DATA, IOPackage::RawEncoding, z.constData(), z.size());
+			} else
+				p->setBuffer(REQ_FCHUNK_DATA, IOPackage::RawEncoding, m_pCopyObject->m_pBuffer, size);
 		}
 		if (m_pCopyObject->atEnd()) {
 			flags |= REQ_FCHUNK_FL_LAST;
 			done = 1;
 		}
-		snprintf(buf, sizeof(buf), "%llu", flags);
-		p->fillBuffer(REQ_FCHUNK_FLAGS, IOPackage::RawEncoding, buf, strlen(buf)+1);
-		p->setBuffer(REQ_FCHUNK_DATA, IOPackage::RawEncoding, m_pCopyObject->m_pBuffer, size);
+		if (binary) {
+			quint64 x = qToLittleEndian(flags);
+			p->fillBuffer(REQ_FCHUNK_FLAGS, IOPackage::RawEncoding, (const char* )&x, sizeof(x));
+		} else {
+			snprintf(buf, sizeof(buf), "%llu", flags);
+			p->fillBuffer(REQ_FCHUNK_FLAGS, IOPackage::RawEncoding, buf, strlen(buf)+1);
+		}
 
-		job = m_hSender->sendPackage(p);
-		if (m_hSender->waitForSend(job, m_nTimeout) != IOSendJob::Success) {
-			WRITE_TRACE(DBG_FATAL, "Package sending failure");
-			ret = PRL_ERR_OPERATION_FAILED;
+		if (PRL_FAILED(ret = SendPackage(p)))
 			break;
-		}
 		m_pCopyObject->freeBuffer();
 		m_nCurrentSize += size;
 		NotifyClientsWithProgress();
@@ -766,6 +894,61 @@ PRL_RESULT CVmFileListCopySource::SendFileBody(const QString & path)
 	return ret;
 }
 
+/* send a package without ack waiting. in the legacy protocol wait until it
+   is sent, otherwise keep up to FILE_COPY_WINDOW packages in flight */
+PRL_RESULT CVmFileListCopySource::SendPackage(const SmartPtr<IOPackage> &p)
+{
+	if (m_bIsOperationWasCanceled)
+		return PRL_ERR_OPERATION_WAS_CANCELED;
+
+	if (m_hSender->m_sErrorString.size()) {
+		m_lstJobs.clear();
+		return processTargetError(m_hSender->m_sErrorString);
+	}
+
+	m_lstJobs.enqueue(m_hSender->sendPackage(p));
+	int w = getVersion() >= FILECOPY_PROTO_WINDOW ? FILE_COPY_WINDOW : 1;
+	if (m_lstJobs.size() < w)
+		return PRL_ERR_SUCCESS;
+
+	if (m_hSender->waitForSend(m_lstJobs.dequeue(), m_nTimeout) != IOSendJob::Success) {
+		WRITE_TRACE(DBG_FATAL, "Package sending failure");
+		m_lstJobs.clear();
+		return PRL_ERR_OPERATION_FAILED;
+	}
+	/* the target could fail a chunk while we were waiting for the window */
+	if (m_hSender->m_sErrorString.size()) {
+		m_lstJobs.clear();
+		return processTargetError(m_hSender->m_sErrorString);
+	}
+	return PRL_ERR_SUCCESS;
+}
+
+/* wait until all the packages in flight are sent */
+PRL_RESULT CVmFileListCopySource::Flush()
+{
+	while (!m_lstJobs.isEmpty()) {
+		if (m_bIsOperationWasCanceled) {
+			m_lstJobs.clear();
+			return PRL_ERR_OPERATION_WAS_CANCELED;
+		}
+		/* do not wait for the rest of the window when the target has failed */
+		if (m_hSender->m_sErrorString.size()) {
+			m_lstJobs.clear();
+			return processTargetError(m_hSender->m_sErrorString);
+		}
+		if (m_hSender->waitForSend(m_lstJobs.dequeue(), m_nTimeout) != IOSendJob::Success) {
+			WRITE_TRACE(DBG_FATAL, "Package sending failure");
+			m_lstJobs.clear();
+			return PRL_ERR_OPERATION_FAILED;
+		}
+	}
+	if (m_hSender->m_sErrorString.size())
+		return processTargetError(m_hSender->m_sErrorString);
+
+	return PRL_ERR_SUCCESS;
+}
+
 PRL_RESULT CVmFileListCopySource::SendFinishRequest()
 {
 	SmartPtr<IOPackage> p = IOPackage::createInstance(FileCopyFinishCmd, 0);
@@ -966,17 +1149,28 @@ PRL_RESULT CVmFileListCopyTarget::RecvFirstRequest(const SmartPtr<IOPackage> &p)
 	WRITE_TRACE(DBG_DEBUG, "> FileCopy first request: version: %d, platform: %d, size: %lld",
 		m_nRemoteVersion, m_nRemotePlatform, m_nTotalSize);
 
-	reply = IOPackage::createInstance(FileCopyFirstReply, 2, p);
+	/* older sources do not send the features buffer */
+	unsigned caps = 0;
+	if (p->header.buffersNumber <= REQ_FIRST_CAPS ||
+		sscanf(p->buffers[REQ_FIRST_CAPS].getImpl(), "%u", &caps) != 1)
+		caps = 0;
+	caps &= FILECOPY_CAPS;
+
+	reply = IOPackage::createInstance(FileCopyFirstReply, 3, p);
 
-	/* send reply with migration protocol version and source platform */
+	/* send reply with migration protocol version, source platform and
+	   the features agreed on */
 	snprintf(buf, sizeof(buf), "%d", MIGRATION_PROTO_VER);
 	reply->fillBuffer(REP_FIRST_VER, IOPackage::RawEncoding, buf, strlen(buf)+1);
 
 	snprintf(buf, sizeof(buf), "%d", getPlatform());
 	reply->fillBuffer(REP_FIRST_PLATF, IOPackage::RawEncoding, buf, strlen(buf)+1);
 
-	WRITE_TRACE(DBG_FATAL, "< FileCopy first reply: version: %d, platform: %d",
-		MIGRATION_PROTO_VER, getPlatform());
+	snprintf(buf, sizeof(buf), "%u", caps);
+	reply->fillBuffer(REP_FIRST_CAPS, IOPackage::RawEncoding, buf, strlen(buf)+1);
+
+	WRITE_TRACE(DBG_FATAL, "< FileCopy first reply: version: %d, platform: %d, features: %u",
+		MIGRATION_PROTO_VER, getPlatform(), caps);
 
 	m_hSender->sendPackage(reply);
 
@@ -984,6 +1178,25 @@ PRL_RESULT CVmFileListCopyTarget::RecvFirstRequest(const SmartPtr<IOPackage> &p)
 }
 
 PRL_RESULT CVmFileListCopyTarget::RecvDirRequest(const SmartPtr<IOPackage> &p)
+{
+	PRL_RESULT ret;
+
+	if (m_bIsOperationWasCanceled)
+		return PRL_ERR_OPERATION_WAS_CANCELED;
+
+	/* the package contains several directories since FILECOPY_PROTO_WINDOW */
+	int n = getVersion() >= FILECOPY_PROTO_WINDOW ? p->header.buffersNumber : REQ_DIR_COUNT;
+	for (int base = 0; base + REQ_DIR_COUNT <= n; base += REQ_DIR_COUNT) {
+		if (PRL_FAILED(ret = RecvDir(p, base)))
+			return ret;
+	}
+	if (getVersion() >= FILECOPY_PROTO_WINDOW)
+		return PRL_ERR_SUCCESS;
+
+	return SendAck(p);
+}
+
+PRL_RESULT CVmFileListCopyTarget::RecvDir(const SmartPtr<IOPackage> &p, int base)
 {
 	QString owner;
 	QString group;
@@ -991,22 +1204,19 @@ PRL_RESULT CVmFileListCopyTarget::RecvDirRequest(const SmartPtr<IOPackage> &p)
 	int perms;
 	SmartPtr<QDir> dir = SmartPtr<QDir>(new QDir());
 
-	if (m_bIsOperationWasCanceled)
-		return PRL_ERR_OPERATION_WAS_CANCELED;
-
-	path = UTF8_2QSTR(p->buffers[REQ_DIR_PATH].getImpl());
+	path = UTF8_2QSTR(p->buffers[base + REQ_DIR_PATH].getImpl());
 	if (QFileInfo(path).isRelative())
 		path.insert(0, m_sWorkPath);
-	owner = UTF8_2QSTR(p->buffers[REQ_DIR_OWNER].getImpl());
-	group = UTF8_2QSTR(p->buffers[REQ_DIR_GROUP].getImpl());
-	if (sscanf(p->buffers[REQ_DIR_PERMS].getImpl(), "%x", &perms) != 1) {
+	owner = UTF8_2QSTR(p->buffers[base + REQ_DIR_OWNER].getImpl());
+	group = UTF8_2QSTR(p->buffers[base + REQ_DIR_GROUP].getImpl());
+	if (sscanf(p->buffers[base + REQ_DIR_PERMS].getImpl(), "%x", &perms) != 1) {
 		WRITE_TRACE(DBG_FATAL, "Bad directory permissions: [%s]",\
-			p->buffers[REQ_DIR_PERMS].getImpl());
+			p->buffers[base + REQ_DIR_PERMS].getImpl());
 
 		EVENT_ERR_FILECOPY_PROTOCOL(
 			"FileCopyDirRequest",
-			QString("%1").arg(REQ_DIR_PERMS),
-			p->buffers[REQ_DIR_PERMS].getImpl());
+			QString("%1").arg(base + REQ_DIR_PERMS),
+			p->buffers[base + REQ_DIR_PERMS].getImpl());
 		SendError(p);
 
 		NotifyFileCopyWasCanceled();
@@ -1046,7 +1256,7 @@ PRL_RESULT CVmFileListCopyTarget::RecvDirRequest(const SmartPtr<IOPackage> &p)
 		WRITE_TRACE(DBG_FATAL, "Can't set permissions [%x] for directory: [%s]", perms, QSTR2UTF8(path));
 	}
 
-	return SendAck(p);
+	return PRL_ERR_SUCCESS;
 }
 
 PRL_RESULT CVmFileListCopyTarget::RecvFileRequest(const SmartPtr<IOPackage> &p)
@@ -1155,6 +1365,9 @@ PRL_RESULT CVmFileListCopyTarget::RecvFileRequest(const SmartPtr<IOPackage> &p)
 	if (!file->setPermissions((QFile::Permissions)perms)) {
 		WRITE_TRACE(DBG_FATAL, "Can't set permissions [%x] for file: [%s]", perms, QSTR2UTF8(path));
 	}
+	/* the source does not wait for it since FILECOPY_PROTO_WINDOW */
+	if (getVersion() >= FILECOPY_PROTO_WINDOW)
+		return PRL_ERR_SUCCESS;
 
 	return SendAck(p);
 }
@@ -1185,7 +1398,23 @@ PRL_RESULT CVmFileListCopyTarget::RecvFileChunk(const SmartPtr<IOPackage> &p)
 	quint32 size;
 	quint64 flags;
 
-	if (sscanf(p->buffers[REQ_FCHUNK_FLAGS].getImpl(), "%llu", &flags) != 1) {
+	if (getVersion() >= FILECOPY_PROTO_WINDOW) {
+		/* binary little-endian flags */
+		p->getBuffer(REQ_FCHUNK_FLAGS, enc, buff, size);
+		if (!buff.isValid() || size != sizeof(flags)) {
+			WRITE_TRACE(DBG_FATAL, "Bad flags size: %u", size);
+
+			EVENT_ERR_FILECOPY_PROTOCOL(
+				"FileCopyFileChunk",
+				QString("%1").arg(REQ_FCHUNK_FLAGS),
+				QString::number(size));
+			SendError(p);
+
+			NotifyFileCopyWasCanceled();
+			return PRL_ERR_FILECOPY_PROTOCOL;
+		}
+		flags = qFromLittleEndian<quint64>((const uchar* )buff.getImpl());
+	} else if (sscanf(p->buffers[REQ_FCHUNK_FLAGS].getImpl(), "%llu", &flags) != 1) {
 		WRITE_TRACE(DBG_FATAL, "Bad flags: [%s]", p->buffers[REQ_FCHUNK_FLAGS].getImpl());
 
 		EVENT_ERR_FILECOPY_PROTOCOL(
@@ -1199,7 +1428,54 @@ PRL_RESULT CVmFileListCopyTarget::RecvFileChunk(const SmartPtr<IOPackage> &p)
 	}
 	p->getBuffer(REQ_FCHUNK_DATA, enc, buff, size);
 
-	if (file->write(buff.getImpl(), size) == -1) {
+	if (flags & REQ_FCHUNK_FL_HOLE) {
+		quint64 x = 0;
+		if (buff.isValid() && size == sizeof(x))
+			x = qFromLittleEndian<quint64>((const uchar* )buff.getImpl());
+		/* the file is new or truncated, so seeking leaves a hole */
+		if (0 == x || !file->seek(file->pos() + x)) {
+			file->close();
+			WRITE_TRACE(DBG_FATAL, "Can't skip a hole of %llu bytes", x);
+
+			m_Event.setEventCode(PRL_ERR_FILECOPY_CANT_WRITE);
+			SendError(p);
+
+			NotifyFileCopyWasCanceled();
+			return PRL_ERR_FILECOPY_CANT_WRITE;
+		}
+		m_nCurrentSize += x;
+		/* a trailing hole sets the file size */
+		if (flags & REQ_FCHUNK_FL_LAST) {
+			if (!file->resize(file->pos()))
+				WRITE_TRACE(DBG_FATAL, "Can't extend file: [%s]", QSTR2UTF8(file->fileName()));
+			file->close();
+		}
+
+		NotifyClientsWithProgress();
+
+		return PRL_ERR_SUCCESS;
+	}
+
+	QByteArray z;
+	if (flags & REQ_FCHUNK_FL_ZLIB) {
+		z = qUncompress((const uchar* )buff.getImpl(), size);
+		if (z.isEmpty()) {
+			file->close();
+			WRITE_TRACE(DBG_FATAL, "Can't uncompress a chunk of %u bytes", size);
+
+			EVENT_ERR_FILECOPY_PROTOCOL(
+				"FileCopyFileChunk",
+				QString("%1").arg(REQ_FCHUNK_DATA),
+				QString::number(size));
+			SendError(p);
+
+			NotifyFileCopyWasCanceled();
+			return PRL_ERR_FILECOPY_PROTOCOL;
+		}
+		size = z.size();
+	}
+
+	if (file->write(z.isEmpty() ? buff.getImpl() : z.constData(), size) == -1) {
 		file->close();
 		WRITE_TRACE(DBG_FATAL, "Write error");
 
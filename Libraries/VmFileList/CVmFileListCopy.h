@@ -36,6 +36,7 @@
 
 #include <QPair>
 #include <QList>
+#include <QQueue>
 #include <QWaitCondition>
 #include <boost/chrono/system_clocks.hpp>
 #include <boost/optional.hpp>
@@ -49,6 +50,9 @@
 using namespace IOService;
 using namespace Virtuozzo;
 
+/* file chunks in flight when the peer supports the windowed protocol */
+enum { FILE_COPY_WINDOW = 8 };
+
 ///////////////////////////////////////////////////////////////////////////////
 // struct Throttle
 
@@ -197,6 +201,9 @@ public:
 	int getProgress() { return  m_nProgress; }
 	void setProgress(int nProgress) { m_nProgress = nProgress; }
 protected:
+	/* protocol version agreed with the peer */
+	int getVersion() const;
+
 	QString m_sParam;
 	quint64 m_nTotalSize;
 	quint64 m_nCurrentSize;
@@ -236,27 +243,52 @@ public:
 	virtual void setName(const QString &sName) { Q_UNUSED(sName); }
 	virtual qint64 getBuffer() { return 0; }
 	virtual void freeBuffer() { return; }
+	/* skip the hole at the current position, return its length */
+	virtual qint64 skipHole() { return 0; }
 };
 
 /*
-   Class for plain file to plain file copy
+   Class for plain file to plain file copy.
+   Reads go round FILE_COPY_WINDOW buffers: the chunks in flight still refer to
+   the previous ones.
 */
 class CVmFileListCopyFile : public CVmFileListCopyObject
 {
 private:
 	QFile m_cFile;
 	quint64 m_nBufSize;
+	QList<SmartPtr<char> > m_lstBuffers;
+	int m_nNext;
+	/* end of the data extent found by skipHole() */
+	qint64 m_nDataEnd;
 public:
-	CVmFileListCopyFile()
+	CVmFileListCopyFile(): m_nNext(0), m_nDataEnd(-1)
 	{
 		m_nBufSize = 1024*1024;
-		m_pBuffer = SmartPtr<char>(new char[m_nBufSize], SmartPtrPolicy::ArrayStorage);
+		for (int i = 0; i < FILE_COPY_WINDOW; ++i)
+			m_lstBuffers << SmartPtr<char>(new char[m_nBufSize], SmartPtrPolicy::ArrayStorage);
+		m_pBuffer = m_lstBuffers.first();
+	}
+	virtual bool open(QFile::OpenMode mode)
+	{
+		m_nDataEnd = -1;
+		return m_cFile.open(mode | QIODevice::Unbuffered);
 	}
-	virtual bool open(QFile::OpenMode mode) { return m_cFile.open(mode); }
 	virtual void close() { m_cFile.close(); }
 	virtual bool atEnd() { return m_cFile.atEnd(); }
 	virtual void setName(const QString &sName) { m_cFile.setFileName(sName); }
-	virtual qint64 getBuffer() { return m_cFile.read(m_pBuffer.getImpl(), m_nBufSize); }
+	virtual qint64 getBuffer()
+	{
+		qint64 n = m_nBufSize;
+		qint64 p = m_cFile.pos();
+		/* do not read zeros of the next hole */
+		if (p < m_nDataEnd)
+			n = qMin(n, m_nDataEnd - p);
+		m_pBuffer = m_lstBuffers.at(m_nNext);
+		m_nNext = (m_nNext + 1) % m_lstBuffers.size();
+		return m_cFile.read(m_pBuffer.getImpl(), n);
+	}
+	virtual qint64 skipHole();
 };
 
 /**
@@ -285,16 +317,28 @@ public:
 	PRL_RESULT SendFileRequest(objectList_type::const_reference fPair);
 	PRL_RESULT SendFinishRequest();
 	PRL_RESULT SetCopyObject(const SmartPtr<CVmFileListCopyObject> &pCopyObject);
+	/* ask the target for compressed chunks in the first request, the
+	   chunks are compressed only if it agrees */
+	void SetCompression(bool bCompress) { m_bCompress = bCompress; }
+	bool IsCompressed() const { return m_bCompress; }
 
 	void cancelOperation();
 
 private:
 	PRL_RESULT SendReqWithAck(SmartPtr<IOPackage> pPkg);
+	PRL_RESULT SendPackage(const SmartPtr<IOPackage> &pPkg);
+	PRL_RESULT Flush();
+	PRL_RESULT SendDirBatch(const objectList_type &dirList);
+	void FillDirRequest(const SmartPtr<IOPackage> &pPkg, int base,
+		objectList_type::const_reference dPair);
 	PRL_RESULT SendFileBody(const QString & path);
 	PRL_RESULT processTargetError(QString sErrorString);
 
 private:
 	SmartPtr<CVmFileListCopyObject> m_pCopyObject;
+	/* packages sent without waiting */
+	QQueue<IOSendJob::Handle> m_lstJobs;
+	bool m_bCompress;
 };
 
 /**
@@ -325,6 +369,7 @@ public:
 private:
 	PRL_RESULT RecvFirstRequest(const SmartPtr<IOPackage> &p);
 	PRL_RESULT RecvDirRequest(const SmartPtr<IOPackage> &p);
+	PRL_RESULT RecvDir(const SmartPtr<IOPackage> &p, int base);
 	PRL_RESULT RecvFileRequest(const SmartPtr<IOPackage> &p);
 	PRL_RESULT RecvFileChunk(const SmartPtr<IOPackage> &p);
 	PRL_RESULT RecvFinishRequest(const SmartPtr<IOPackage> &p);
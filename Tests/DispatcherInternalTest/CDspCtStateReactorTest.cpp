@@ -0,0 +1,221 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspCtStateReactorTest.cpp
+///
+/// Tests suite for the reactor of the container state transitions.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QSemaphore>
+#include <boost/ref.hpp>
+#include "CDspCtStateReactorTest.h"
+#include "Dispatcher/Dispatcher/CDspCtStateReactor.h"
+
+namespace
+{
+const QString g_ct1 = "ct1";
+const QString g_ct2 = "ct2";
+
+typedef QList<QPair<QString, VIRTUAL_MACHINE_STATE> > log_type;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Journal
+// Records the applied transitions. Every apply is announced and then waits
+// for a permit, so that the test may queue the transitions behind it.
+// Applies running at once are noted.
+
+struct Journal
+{
+	Journal(): m_gate(0), m_depth(), m_overlapped()
+	{
+	}
+
+	void operator()(const QString& uuid_, VIRTUAL_MACHINE_STATE state_)
+	{
+		{
+			QMutexLocker g(&m_mutex);
+			m_overlapped |= (0 < m_depth++);
+		}
+		m_entered.release();
+		m_gate.acquire();
+		QMutexLocker g(&m_mutex);
+		--m_depth;
+		m_log << qMakePair(uuid_, state_);
+	}
+
+	bool waitEntered()
+	{
+		return m_entered.tryAcquire(1, 5000);
+	}
+	void open()
+	{
+		m_gate.release(1000);
+	}
+	log_type getLog()
+	{
+		QMutexLocker g(&m_mutex);
+		return m_log;
+	}
+	bool isOverlapped()
+	{
+		QMutexLocker g(&m_mutex);
+		return m_overlapped;
+	}
+	QList<VIRTUAL_MACHINE_STATE> getStates(const QString& uuid_)
+	{
+		QList<VIRTUAL_MACHINE_STATE> output;
+		foreach (const log_type::value_type& x, getLog())
+		{
+			if (x.first == uuid_)
+				output << x.second;
+		}
+		return output;
+	}
+
+private:
+	QMutex m_mutex;
+	QSemaphore m_gate;
+	QSemaphore m_entered;
+	int m_depth;
+	bool m_overlapped;
+	log_type m_log;
+};
+
+Ct::State::apply_type makeApply(Journal& journal_)
+{
+	return boost::ref(journal_);
+}
+
+} // namespace
+
+void CDspCtStateReactorTest::testOrder()
+{
+	Journal j;
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		r.react(g_ct1, VMS_STOPPED);
+		r.react(g_ct1, VMS_MOUNTED);
+		r.react(g_ct1, VMS_RUNNING);
+		j.open();
+	}
+	QList<VIRTUAL_MACHINE_STATE> x;
+	x << VMS_RUNNING << VMS_STOPPED << VMS_MOUNTED << VMS_RUNNING;
+	QCOMPARE(j.getStates(g_ct1), x);
+}
+
+void CDspCtStateReactorTest::testDuplicateIsDropped()
+{
+	Journal j;
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		// equal to the one being applied
+		r.react(g_ct1, VMS_RUNNING);
+		r.react(g_ct1, VMS_STOPPED);
+		// equal to the queued one
+		r.react(g_ct1, VMS_STOPPED);
+		j.open();
+	}
+	QList<VIRTUAL_MACHINE_STATE> x;
+	x << VMS_RUNNING << VMS_STOPPED;
+	QCOMPARE(j.getStates(g_ct1), x);
+}
+
+void CDspCtStateReactorTest::testNetworkIsCoalesced()
+{
+	Journal j;
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_UNKNOWN);
+		QVERIFY(j.waitEntered());
+		// the one being applied does not absorb the next one
+		r.react(g_ct1, VMS_UNKNOWN);
+		r.react(g_ct1, VMS_UNKNOWN);
+		r.react(g_ct1, VMS_UNKNOWN);
+		j.open();
+	}
+	QList<VIRTUAL_MACHINE_STATE> x;
+	x << VMS_UNKNOWN << VMS_UNKNOWN;
+	QCOMPARE(j.getStates(g_ct1), x);
+}
+
+void CDspCtStateReactorTest::testContainersAreApart()
+{
+	Journal j;
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		// the blocked container does not hold the other one
+		r.react(g_ct2, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		r.react(g_ct2, VMS_STOPPED);
+		j.open();
+	}
+	QCOMPARE(j.getLog().size(), 3);
+	QCOMPARE(j.getStates(g_ct1), QList<VIRTUAL_MACHINE_STATE>() << VMS_RUNNING);
+	QCOMPARE(j.getStates(g_ct2),
+		QList<VIRTUAL_MACHINE_STATE>() << VMS_RUNNING << VMS_STOPPED);
+}
+
+void CDspCtStateReactorTest::testForget()
+{
+	Journal j;
+	j.open();
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		r.forget(g_ct1);
+		// a new life of the container starts from scratch
+		r.react(g_ct1, VMS_RUNNING);
+	}
+	QList<VIRTUAL_MACHINE_STATE> x;
+	x << VMS_RUNNING << VMS_RUNNING;
+	QCOMPARE(j.getStates(g_ct1), x);
+}
+
+void CDspCtStateReactorTest::testForgetWhileApplied()
+{
+	Journal j;
+	{
+		Ct::State::Reactor r(makeApply(j));
+		r.react(g_ct1, VMS_RUNNING);
+		QVERIFY(j.waitEntered());
+		r.react(g_ct1, VMS_STOPPED);
+		r.forget(g_ct1);
+		// the new life waits for the transition being applied
+		r.react(g_ct1, VMS_RUNNING);
+		r.react(g_ct1, VMS_STOPPED);
+		j.open();
+	}
+	QVERIFY(!j.isOverlapped());
+	// the queued transition of the previous life is dropped
+	QList<VIRTUAL_MACHINE_STATE> x;
+	x << VMS_RUNNING << VMS_RUNNING << VMS_STOPPED;
+	QCOMPARE(j.getStates(g_ct1), x);
+}
@@ -0,0 +1,108 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspExecutorTest.cpp
+///
+/// Tests suite for the dispatcher executor pools.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QSemaphore>
+#include <QElapsedTimer>
+#include <boost/bind.hpp>
+#include "CDspExecutorTest.h"
+#include "Dispatcher/Dispatcher/CDspExecutor.h"
+
+namespace
+{
+enum
+{
+	VM_COUNT = 100
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Shutdown
+// A graceful shutdown: waits for the guest until the test lets it go.
+
+struct Shutdown
+{
+	Shutdown(): m_gate(0)
+	{
+	}
+
+	void operator()()
+	{
+		m_started.release();
+		m_gate.acquire();
+	}
+
+	bool waitStarted(int count_)
+	{
+		return m_started.tryAcquire(count_, 10000);
+	}
+	void open()
+	{
+		m_gate.release(VM_COUNT);
+	}
+
+private:
+	QSemaphore m_gate;
+	QSemaphore m_started;
+};
+
+int collect(int value_)
+{
+	return value_ + 1;
+}
+
+} // namespace
+
+void CDspExecutorTest::testStatisticsDuringMassShutdown()
+{
+	Shutdown s;
+	Executor::Pool& l = Executor::get(Executor::LIFECYCLE);
+	QList<QFuture<void> > f;
+	for (int i = 0; i < VM_COUNT; ++i)
+		f << l.run(boost::bind(&Shutdown::operator(), &s));
+
+	QVERIFY(s.waitStarted(VM_COUNT));
+	QVERIFY(l.getGauge().getActive() >= VM_COUNT);
+	QVERIFY(l.getGauge().getPeak() >= VM_COUNT);
+
+	// all the shutdowns are waiting, the statistics do not
+	QElapsedTimer t;
+	t.start();
+	for (int i = 0; i < 10; ++i)
+	{
+		QFuture<int> x = Executor::get(Executor::STATISTICS)
+			.run(boost::bind(&collect, i));
+		QCOMPARE(x.result(), i + 1);
+	}
+	QVERIFY2(t.elapsed() < 5000, qPrintable(QString::number(t.elapsed())));
+
+	s.open();
+	foreach (QFuture<void> x, f)
+		x.waitForFinished();
+
+	QCOMPARE(l.getGauge().getQueued(), 0);
+}
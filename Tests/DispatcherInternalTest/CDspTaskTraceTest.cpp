@@ -0,0 +1,176 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspTaskTraceTest.cpp
+///
+/// Tests suite for the task trace records and their syslog sink.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <syslog.h>
+#include <QSemaphore>
+#include <boost/ref.hpp>
+#include "CDspTaskTraceTest.h"
+#include "Dispatcher/Dispatcher/CDspTaskTrace_p.h"
+
+using Task::Syslog::Sink;
+using Task::Syslog::quote;
+
+namespace
+{
+typedef QList<QPair<int, QByteArray> > log_type;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Journal
+// Records the written records. Every write is announced and then waits for
+// a permit, so that the test may fill the queue behind it.
+
+struct Journal
+{
+	explicit Journal(int permits_ = 0): m_gate(permits_)
+	{
+	}
+
+	void operator()(int priority_, const QByteArray& record_)
+	{
+		m_entered.release();
+		m_gate.acquire();
+		QMutexLocker g(&m_mutex);
+		m_log << qMakePair(priority_, record_);
+	}
+
+	bool waitEntered()
+	{
+		return m_entered.tryAcquire(1, 5000);
+	}
+	void open()
+	{
+		m_gate.release(2 * Sink::CAPACITY);
+	}
+	log_type getLog()
+	{
+		QMutexLocker g(&m_mutex);
+		return m_log;
+	}
+
+private:
+	QMutex m_mutex;
+	QSemaphore m_gate;
+	QSemaphore m_entered;
+	log_type m_log;
+};
+
+Sink::write_type makeWrite(Journal& journal_)
+{
+	return boost::ref(journal_);
+}
+
+QByteArray record(int index_)
+{
+	return QByteArray("record ").append(QByteArray::number(index_));
+}
+
+} // namespace
+
+void CDspTaskTraceTest::testQuotePlain()
+{
+	QCOMPARE(quote("abc"), QByteArray("\"abc\""));
+	QCOMPARE(quote(""), QByteArray("\"\""));
+	QCOMPARE(quote("{a1b2-c3}"), QByteArray("\"{a1b2-c3}\""));
+}
+
+void CDspTaskTraceTest::testQuoteEscapes()
+{
+	QCOMPARE(quote("a\"b"), QByteArray("\"a\\\"b\""));
+	QCOMPARE(quote("a\\b"), QByteArray("\"a\\\\b\""));
+	QCOMPARE(quote("\\\""), QByteArray("\"\\\\\\\"\""));
+}
+
+void CDspTaskTraceTest::testQuoteControl()
+{
+	QCOMPARE(quote("a\nb"), QByteArray("\"a\\u000ab\""));
+	QCOMPARE(quote("\t"), QByteArray("\"\\u0009\""));
+	QCOMPARE(quote(QString(QChar(0x1f))), QByteArray("\"\\u001f\""));
+	QCOMPARE(quote(" "), QByteArray("\" \""));
+}
+
+void CDspTaskTraceTest::testQuoteUtf8()
+{
+	// multibyte sequences pass as they are
+	QString v = QString::fromUtf8("\xd0\xb2\xd0\xbc");
+	QCOMPARE(quote(v), QByteArray("\"\xd0\xb2\xd0\xbc\""));
+}
+
+void CDspTaskTraceTest::testSinkDirect()
+{
+	Journal j(Sink::CAPACITY);
+	Sink s(makeWrite(j));
+	// not started, the record is written by the caller
+	s.push(record(0));
+	QCOMPARE(j.getLog().size(), 1);
+
+	s.start();
+	s.stop();
+	// stopped, written by the caller again
+	s.push(record(1));
+	log_type x = j.getLog();
+	QCOMPARE(x.size(), 2);
+	QCOMPARE(x.at(0), qMakePair(int(LOG_INFO), record(0)));
+	QCOMPARE(x.at(1), qMakePair(int(LOG_INFO), record(1)));
+}
+
+void CDspTaskTraceTest::testSinkOrder()
+{
+	Journal j;
+	Sink s(makeWrite(j));
+	s.start();
+	for (int i = 0; i < 100; ++i)
+		s.push(record(i));
+
+	j.open();
+	s.stop();
+	log_type x = j.getLog();
+	QCOMPARE(x.size(), 100);
+	for (int i = 0; i < x.size(); ++i)
+		QCOMPARE(x.at(i).second, record(i));
+}
+
+void CDspTaskTraceTest::testSinkDropped()
+{
+	Journal j;
+	Sink s(makeWrite(j));
+	s.start();
+	// the writer holds the first record, the queue fills behind it
+	s.push(record(0));
+	QVERIFY(j.waitEntered());
+	for (int i = 1; i <= Sink::CAPACITY + 3; ++i)
+		s.push(record(i));
+
+	j.open();
+	s.stop();
+	log_type x = j.getLog();
+	QCOMPARE(x.size(), Sink::CAPACITY + 2);
+	QCOMPARE(x.at(Sink::CAPACITY).second, record(Sink::CAPACITY));
+	QCOMPARE(x.last(), qMakePair(int(LOG_WARNING),
+		QByteArray("3 task trace records dropped")));
+}
@@ -0,0 +1,145 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspUserHelperTest.cpp
+///
+/// Tests suite for the memory of the logon lookups.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QTemporaryDir>
+#include <prlcommon/PrlCommonUtilsBase/CRsaHelper.hpp>
+#include "CDspUserHelperTest.h"
+#include "Dispatcher/Dispatcher/CDspUserHelper_p.h"
+
+namespace
+{
+enum
+{
+	TTL = 50,
+	// the keys of a shared automation account
+	KEYS = 200
+};
+
+QString makeKey(int number_)
+{
+	return QString("ssh-rsa %1 robot%2@example.com")
+		.arg(QString(QByteArray(372, 'A' + number_ % 26).toBase64())).arg(number_);
+}
+
+bool makeHome(const QString& home_, int keys_)
+{
+	if (!QDir(home_).mkpath(".ssh"))
+		return false;
+
+	QFile f(QDir(home_).filePath(".ssh/authorized_keys"));
+	if (!f.open(QIODevice::WriteOnly))
+		return false;
+
+	for (int i = 0; i < keys_; ++i)
+	{
+		QByteArray x = makeKey(i).append('\n').toUtf8();
+		if (f.write(x) != x.size())
+			return false;
+	}
+	return f.flush();
+}
+
+} // namespace
+
+void CDspUserHelperTest::testMemoExpires()
+{
+	Login::Memo<int> m(TTL);
+	m.add("root", 1);
+	QVERIFY(m.find("root"));
+	QCOMPARE(m.find("root").get(), 1);
+	QVERIFY(!m.find("nobody"));
+	QTest::qSleep(2 * TTL);
+	QVERIFY(!m.find("root"));
+	m.add("root", 2);
+	m.drop("root");
+	QVERIFY(!m.find("root"));
+}
+
+void CDspUserHelperTest::testMemoCapacity()
+{
+	Login::Memo<int> m;
+	for (int i = 0; i <= Login::Memo<int>::CAPACITY; ++i)
+		m.add(QString::number(i), i);
+
+	QVERIFY(!m.find("0"));
+	QVERIFY(m.find(QString::number(Login::Memo<int>::CAPACITY)));
+}
+
+void CDspUserHelperTest::testKeyDroppedOnChange()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QString h = d.path();
+	QVERIFY(makeHome(h, 1));
+
+	Login::Keys k;
+	QString x = makeKey(0);
+	QVERIFY(!k.isAuthorized(h, x));
+	k.authorize(h, x);
+	QVERIFY(k.isAuthorized(h, x));
+	QVERIFY(!k.isAuthorized(h, makeKey(1)));
+	// the keys are rewritten, the verdict is to be taken again
+	QVERIFY(makeHome(h, 2));
+	QVERIFY(!k.isAuthorized(h, x));
+	k.authorize(h, x);
+	QVERIFY(k.isAuthorized(h, x));
+}
+
+void CDspUserHelperTest::benchKeyFromFile()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QString h = d.path();
+	QVERIFY(makeHome(h, KEYS));
+
+	// a logon without the memory reads the keys every time
+	QString x = makeKey(KEYS - 1);
+	QBENCHMARK
+	{
+		CRsaHelper(h).isAuthorized(x);
+	}
+}
+
+void CDspUserHelperTest::benchKeyFromMemory()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QString h = d.path();
+	QVERIFY(makeHome(h, KEYS));
+
+	Login::Keys k;
+	QString x = makeKey(KEYS - 1);
+	k.authorize(h, x);
+	bool y = false;
+	QBENCHMARK
+	{
+		y = k.isAuthorized(h, x);
+	}
+	QVERIFY(y);
+}
@@ -0,0 +1,126 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmStateCoalescerTest.cpp
+///
+/// Tests suite for the collector of the VM events in the batch mode.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CDspVmStateCoalescerTest.h"
+#include "Dispatcher/Dispatcher/CDspVmStateCoalescer.h"
+
+namespace
+{
+const CVmIdent g_vm1 = MakeVmIdent("vm1", "dir");
+const CVmIdent g_vm2 = MakeVmIdent("vm2", "dir");
+const Vm::State::Event::recipients_type g_session1 =
+	Vm::State::Event::recipients_type() << "session1";
+const Vm::State::Event::recipients_type g_session2 =
+	Vm::State::Event::recipients_type() << "session2";
+
+} // namespace
+
+void CDspVmStateCoalescerTest::testEmpty()
+{
+	Vm::State::Coalescer c;
+	QVERIFY(c.take().isEmpty());
+	QCOMPARE(c.getMetrics().queued, quint64(0));
+	QCOMPARE(c.getMetrics().depth, 0);
+}
+
+void CDspVmStateCoalescerTest::testLastEventWins()
+{
+	Vm::State::Coalescer c;
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "starting", g_session1);
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "running", g_session1);
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "stopping", g_session1);
+
+	Vm::State::Metrics m = c.getMetrics();
+	QCOMPARE(m.queued, quint64(3));
+	QCOMPARE(m.coalesced, quint64(2));
+	QCOMPARE(m.depth, 1);
+
+	QList<Vm::State::Coalescer::event_type> x = c.take();
+	QCOMPARE(x.size(), 1);
+	QCOMPARE(x.first().vm, g_vm1);
+	QCOMPARE(x.first().body, QByteArray("stopping"));
+}
+
+void CDspVmStateCoalescerTest::testOrderOfFirstAppearance()
+{
+	Vm::State::Coalescer c;
+	c.add(g_vm2, PET_DSP_EVT_VM_STATE_CHANGED, "a", g_session1);
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "b", g_session1);
+	c.add(g_vm2, PET_DSP_EVT_VM_STATE_CHANGED, "c", g_session1);
+
+	QList<Vm::State::Coalescer::event_type> x = c.take();
+	QCOMPARE(x.size(), 2);
+	QCOMPARE(x.at(0).vm, g_vm2);
+	QCOMPARE(x.at(0).body, QByteArray("c"));
+	QCOMPARE(x.at(1).vm, g_vm1);
+	QCOMPARE(x.at(1).body, QByteArray("b"));
+}
+
+void CDspVmStateCoalescerTest::testTypesAndVmsAreKeptApart()
+{
+	Vm::State::Coalescer c;
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "state", g_session1);
+	c.add(g_vm1, PET_DSP_EVT_VM_ADDITION_STATE_CHANGED, "addition", g_session1);
+	c.add(g_vm2, PET_DSP_EVT_VM_STATE_CHANGED, "other", g_session1);
+
+	QCOMPARE(c.getMetrics().coalesced, quint64(0));
+	QCOMPARE(c.getMetrics().peak, 3);
+	QCOMPARE(c.take().size(), 3);
+}
+
+void CDspVmStateCoalescerTest::testTakeResets()
+{
+	Vm::State::Coalescer c;
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "a", g_session1);
+	c.add(g_vm2, PET_DSP_EVT_VM_STATE_CHANGED, "b", g_session1);
+	QCOMPARE(c.take().size(), 2);
+	QVERIFY(c.take().isEmpty());
+
+	Vm::State::Metrics m = c.getMetrics();
+	QCOMPARE(m.depth, 0);
+	QCOMPARE(m.peak, 2);
+	QCOMPARE(m.queued, quint64(2));
+
+	c.count(5);
+	QCOMPARE(c.getMetrics().packages, quint64(5));
+}
+
+void CDspVmStateCoalescerTest::testRecipientsAreKept()
+{
+	Vm::State::Coalescer c;
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "starting", g_session1);
+	c.add(g_vm1, PET_DSP_EVT_VM_STATE_CHANGED, "running", g_session2);
+	c.add(g_vm2, PET_DSP_EVT_VM_STATE_CHANGED, "stopped", g_session2);
+
+	QList<Vm::State::Coalescer::event_type> x = c.take();
+	QCOMPARE(x.size(), 2);
+	QCOMPARE(x.at(0).body, QByteArray("running"));
+	QCOMPARE(x.at(0).recipients, g_session1 + g_session2);
+	QCOMPARE(x.at(1).recipients, g_session2);
+}
@@ -0,0 +1,143 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CDspVmUptimeTest.cpp
+///
+/// Tests suite for the host store of the VM uptime.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QDir>
+#include <QFile>
+#include <boost/phoenix/core/reference.hpp>
+#include "CDspVmUptimeTest.h"
+#include "Dispatcher/Dispatcher/CDspVmUptime.h"
+
+namespace
+{
+const QString g_vm1 = "vm1";
+const QString g_vm2 = "vm2";
+
+} // namespace
+
+void CDspVmUptimeTest::testRunningIsAccounted()
+{
+	quint64 n = 100;
+	DspVm::Uptime u(boost::phoenix::cref(n));
+	u.start(g_vm1);
+	QVERIFY(u.isRunning(g_vm1));
+	QVERIFY(!u.isRunning(g_vm2));
+
+	n += 10;
+	QCOMPARE(u.get(g_vm1), quint64(10));
+	u.account();
+	QCOMPARE(u.get(g_vm1), quint64(10));
+	n += 5;
+	u.account();
+	QCOMPARE(u.get(g_vm1), quint64(15));
+	QCOMPARE(u.get(g_vm2), quint64(0));
+}
+
+void CDspVmUptimeTest::testStartIsIdempotent()
+{
+	quint64 n = 100;
+	DspVm::Uptime u(boost::phoenix::cref(n));
+	u.start(g_vm1);
+	n += 10;
+	u.start(g_vm1);
+	n += 10;
+	QCOMPARE(u.get(g_vm1), quint64(20));
+}
+
+void CDspVmUptimeTest::testFoldUnregisters()
+{
+	quint64 n = 100;
+	DspVm::Uptime u(boost::phoenix::cref(n));
+	u.add(g_vm1, 7);
+	u.start(g_vm1);
+	n += 10;
+	u.account();
+	n += 3;
+	QCOMPARE(u.fold(g_vm1), quint64(20));
+	QVERIFY(!u.isRunning(g_vm1));
+	QCOMPARE(u.get(g_vm1), quint64(0));
+	n += 10;
+	QCOMPARE(u.get(g_vm1), quint64(0));
+	QCOMPARE(u.fold(g_vm1), quint64(0));
+}
+
+void CDspVmUptimeTest::testResetRestartsCounting()
+{
+	quint64 n = 100;
+	DspVm::Uptime u(boost::phoenix::cref(n));
+	u.add(g_vm1, 50);
+	u.start(g_vm1);
+	n += 10;
+	u.reset(g_vm1);
+	QVERIFY(u.isRunning(g_vm1));
+	QCOMPARE(u.get(g_vm1), quint64(0));
+	n += 4;
+	QCOMPARE(u.get(g_vm1), quint64(4));
+}
+
+void CDspVmUptimeTest::testForget()
+{
+	quint64 n = 100;
+	DspVm::Uptime u(boost::phoenix::cref(n));
+	u.add(g_vm1, 50);
+	u.start(g_vm1);
+	u.start(g_vm2);
+	n += 10;
+	u.forget(g_vm1);
+	QVERIFY(!u.isRunning(g_vm1));
+	QCOMPARE(u.get(g_vm1), quint64(0));
+	QCOMPARE(u.get(g_vm2), quint64(10));
+}
+
+void CDspVmUptimeTest::testFlushAndLoad()
+{
+	QString p = QDir::temp().absoluteFilePath("CDspVmUptimeTest.dat");
+	QFile::remove(p);
+
+	quint64 n = 100;
+	{
+		DspVm::Uptime u(boost::phoenix::cref(n));
+		u.load(p);
+		u.start(g_vm1);
+		u.start(g_vm2);
+		n += 10;
+		u.account();
+		u.flush();
+		QVERIFY(QFile::exists(p));
+		// the fold is on disk before it is handed out
+		QCOMPARE(u.fold(g_vm2), quint64(10));
+	}
+	{
+		DspVm::Uptime u(boost::phoenix::cref(n));
+		u.load(p);
+		QVERIFY(!u.isRunning(g_vm1));
+		QCOMPARE(u.get(g_vm1), quint64(10));
+		QCOMPARE(u.get(g_vm2), quint64(0));
+	}
+	QFile::remove(p);
+}
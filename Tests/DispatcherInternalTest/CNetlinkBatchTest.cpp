@@ -0,0 +1,139 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CNetlinkBatchTest.cpp
+///
+/// Tests suite for the batched rtnetlink session of the PrlNetworking
+/// library.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include "CNetlinkBatchTest.h"
+#include <Libraries/PrlNetworking/PrlNetLibrary.h>
+
+#include <fcntl.h>
+#include <sched.h>
+#include <unistd.h>
+#include <net/if.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+namespace
+{
+enum
+{
+	ADDRESS_COUNT = 200
+};
+
+bool setLoopbackUp()
+{
+	int s = socket(AF_INET, SOCK_DGRAM, 0);
+	if (s < 0)
+		return false;
+
+	struct ifreq r;
+	memset(&r, 0, sizeof(r));
+	strncpy(r.ifr_name, "lo", IFNAMSIZ - 1);
+	bool output = ioctl(s, SIOCGIFFLAGS, &r) == 0;
+	if (output)
+	{
+		r.ifr_flags |= IFF_UP;
+		output = ioctl(s, SIOCSIFFLAGS, &r) == 0;
+	}
+	close(s);
+	return output;
+}
+
+QString address(int index_)
+{
+	return QString("10.%1.%2.1").arg(index_ / 250).arg(index_ % 250);
+}
+
+bool fill(PrlNet::Netlink::Batch& batch_, bool add_)
+{
+	for (int i = 0; i < ADDRESS_COUNT; ++i)
+	{
+		if (!batch_.addRoute(address(i), "lo", add_) ||
+			!batch_.addArp(address(i), "lo", add_))
+			return false;
+	}
+	return true;
+}
+
+} // namespace
+
+void CNetlinkBatchTest::init()
+{
+	m_host = open("/proc/self/ns/net", O_RDONLY | O_CLOEXEC);
+	if (m_host < 0 || unshare(CLONE_NEWNET) != 0)
+		QSKIP("Unable to create a network namespace. Root privileges are required", SkipAll);
+
+	QVERIFY(setLoopbackUp());
+}
+
+void CNetlinkBatchTest::cleanup()
+{
+	if (m_host < 0)
+		return;
+
+	setns(m_host, CLONE_NEWNET);
+	close(m_host);
+	m_host = -1;
+}
+
+void CNetlinkBatchTest::testUnknownDevice()
+{
+	PrlNet::Netlink::Batch b;
+	QVERIFY(!b.addRoute("10.0.0.1", "nonexistent0"));
+	QVERIFY(!b.addArp("10.0.0.1", "nonexistent0"));
+	QVERIFY(!b.addRoute("not an address", "lo"));
+	QCOMPARE(b.size(), 0);
+	QVERIFY(b.commit().isEmpty());
+}
+
+void CNetlinkBatchTest::testRoutesAndArpsInOneBatch()
+{
+	PrlNet::Netlink::Batch b;
+	QVERIFY(fill(b, true));
+	QCOMPARE(b.size(), 2 * ADDRESS_COUNT);
+	QVERIFY(b.commit().isEmpty());
+	QCOMPARE(b.size(), 0);
+
+	// the same session is reused for removal
+	QVERIFY(fill(b, false));
+	QVERIFY(b.commit().isEmpty());
+}
+
+void CNetlinkBatchTest::testFailuresAreReportedPerRequest()
+{
+	PrlNet::Netlink::Batch b;
+	QVERIFY(b.addRoute(address(0), "lo", true));
+	QVERIFY(b.commit().isEmpty());
+
+	// only the first removal is valid, the rest have nothing to remove
+	QVERIFY(b.addRoute(address(0), "lo", false));
+	QVERIFY(b.addRoute(address(0), "lo", false));
+	QVERIFY(b.addArp(address(1), "lo", false));
+	QList<int> f = b.commit();
+	QCOMPARE(f, QList<int>() << 1 << 2);
+}
@@ -0,0 +1,58 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CNetlinkBatchTest.h
+///
+/// Tests suite for the batched rtnetlink session of the PrlNetworking
+/// library. Routes and proxy ARP entries are programmed inside a private
+/// network namespace so the host configuration is left intact.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef CNetlinkBatchTest_H
+#define CNetlinkBatchTest_H
+
+#include <QtTest/QtTest>
+
+class CNetlinkBatchTest : public QObject
+{
+
+Q_OBJECT
+
+public:
+	CNetlinkBatchTest(): m_host(-1)
+	{
+	}
+
+private slots:
+	void init();
+	void cleanup();
+	void testUnknownDevice();
+	void testRoutesAndArpsInOneBatch();
+	void testFailuresAreReportedPerRequest();
+
+private:
+	int m_host;
+};
+
+#endif
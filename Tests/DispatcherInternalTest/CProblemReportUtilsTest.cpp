@@ -33,11 +33,14 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <fcntl.h>
+#include <zlib.h>
 
 #include "CProblemReportUtilsTest.h"
 #include <prlcommon/PrlUuid/Uuid.h>
 #include <prlcommon/PrlCommonUtilsBase/CFileHelper.h>
 #include "Libraries/ProblemReportUtils/CProblemReportUtils.h"
+#include "Libraries/ProblemReportUtils/CPackedProblemReportCompressor.h"
 
 void CProblemReportUtilsTest::init()
 {
@@ -263,3 +266,112 @@ void CProblemReportUtilsTest::testExtractPCSIsoVersion()
 	QCOMPARE(sResult, QString("6.0.6-1992"));
 }
 
+
+namespace
+{
+
+QByteArray gunzip(const QString& path_)
+{
+	QByteArray output;
+	gzFile f = gzopen(QFile::encodeName(path_).constData(), "rb");
+	if (NULL == f)
+		return output;
+
+	char b[64 * 1024];
+	int n;
+	while ((n = gzread(f, b, sizeof(b))) > 0)
+		output.append(b, n);
+
+	gzclose(f);
+	return output;
+}
+
+QByteArray makeReport(int size_)
+{
+	// log-like text which deflates about as well as a real report
+	QByteArray output;
+	qsrand(7);
+	while (output.size() < size_)
+	{
+		output.append(QByteArray::number(qrand())).append(" vm state changed to ")
+			.append(QByteArray::number(qrand() % 16)).append('\n');
+	}
+	return output;
+}
+
+} // namespace
+
+void CProblemReportUtilsTest::testParallelGzipRoundTrip()
+{
+	// several blocks plus a tail, written in odd pieces to cross the
+	// block boundaries
+	QByteArray x;
+	qsrand(42);
+	while (x.size() < 5 * PRL_REPORT_COMPRESS_BLOCK_SIZE + 12345)
+	{
+		if (qrand() % 4)
+			x.append(QByteArray::number(qrand()));
+		else
+			x.append(QByteArray(qrand() % 4096, 'z'));
+	}
+
+	QString p = m_sTargetDirPath + "report.tar.gz";
+	Compressor::Parallel c;
+	int i = c.open(QFile::encodeName(p).constData(), O_WRONLY | O_CREAT, 0644);
+	QVERIFY(i >= 0);
+	for (int n = 0; n < x.size();)
+	{
+		int s = qMin(x.size() - n, 1 + qrand() % 300000);
+		QCOMPARE(c.write(i, x.constData() + n, s), (ssize_t)s);
+		n += s;
+	}
+	QCOMPARE(c.close(i), 0);
+	QVERIFY(QFileInfo(p).size() < x.size());
+	QVERIFY(gunzip(p) == x);
+}
+
+void CProblemReportUtilsTest::testParallelGzipEmpty()
+{
+	QString p = m_sTargetDirPath + "empty.tar.gz";
+	Compressor::Parallel c;
+	QCOMPARE(c.open(QFile::encodeName(p).constData(), O_RDONLY, 0), -1);
+	int i = c.open(QFile::encodeName(p).constData(), O_WRONLY | O_CREAT, 0644);
+	QVERIFY(i >= 0);
+	QCOMPARE(c.close(i), 0);
+	QCOMPARE(c.close(i), -1);
+	QVERIFY(QFileInfo(p).exists());
+	QVERIFY(gunzip(p).isEmpty());
+}
+
+void CProblemReportUtilsTest::benchSerialGzip()
+{
+	QByteArray x = makeReport(32 * PRL_REPORT_COMPRESS_BLOCK_SIZE);
+	QString p = m_sTargetDirPath + "serial.tar.gz";
+	QBENCHMARK_ONCE
+	{
+		gzFile f = gzopen(QFile::encodeName(p).constData(), "wb");
+		QVERIFY(NULL != f);
+		QCOMPARE(gzwrite(f, x.constData(), x.size()), x.size());
+		QCOMPARE(gzclose(f), Z_OK);
+	}
+}
+
+void CProblemReportUtilsTest::benchParallelGzip()
+{
+	QByteArray x = makeReport(32 * PRL_REPORT_COMPRESS_BLOCK_SIZE);
+	QString p = m_sTargetDirPath + "parallel.tar.gz";
+	Compressor::Parallel c;
+	QBENCHMARK_ONCE
+	{
+		int i = c.open(QFile::encodeName(p).constData(), O_WRONLY | O_CREAT, 0644);
+		QVERIFY(i >= 0);
+		// the block size tar writes with
+		for (int n = 0; n < x.size(); n += 10240)
+		{
+			int s = qMin(x.size() - n, 10240);
+			QCOMPARE(c.write(i, x.constData() + n, s), (ssize_t)s);
+		}
+		QCOMPARE(c.close(i), 0);
+	}
+	QVERIFY(gunzip(p) == x);
+}
@@ -60,6 +60,10 @@ private slots:
 	void testParseDrvVersion_fromMacPanicReport();
 	void testParseLowMemoryDumpOfMobileApp_isJettisoned();
 	void testExtractPCSIsoVersion();
+	void testParallelGzipRoundTrip();
+	void testParallelGzipEmpty();
+	void benchSerialGzip();
+	void benchParallelGzip();
 
 private:
 	QString m_sTargetDirPath;
@@ -0,0 +1,374 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file CVmFileListCopyTest.cpp
+///
+/// Tests suite for the file list copy protocol over a loopback.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <sys/stat.h>
+#include <QQueue>
+#include <QThread>
+#include <QElapsedTimer>
+#include <QTemporaryDir>
+#include "CVmFileListCopyTest.h"
+#include "Libraries/VmFileList/CVmFileListCopy.h"
+
+namespace
+{
+const quint64 g_1M = 1024 * 1024;
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Reply
+// Sender of the target: keeps the last reply for the source.
+
+struct Reply: CVmFileListCopySender
+{
+	explicit Reply(CVmFileListCopySender& source_): m_source(&source_)
+	{
+	}
+
+	IOSendJob::Handle sendPackage(const SmartPtr<IOPackage> p)
+	{
+		m_last = p;
+		// an error of the target is what the source checks before every send
+		m_source->handlePackage(p);
+		return IOSendJob::Handle();
+	}
+
+	SmartPtr<IOPackage> take()
+	{
+		SmartPtr<IOPackage> output = m_last;
+		m_last = SmartPtr<IOPackage>();
+		return output;
+	}
+
+private:
+	CVmFileListCopySender* m_source;
+	SmartPtr<IOPackage> m_last;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Loopback
+// Sender of the source: hands every package to the target in the same thread
+// and counts the bytes that would go to the wire. A package is sent a latency
+// after it was queued; the target may fail the stream after a number of
+// chunks.
+
+struct Loopback: CVmFileListCopySender
+{
+	Loopback(): m_reply(*this), m_target(), m_bytes(), m_latency(),
+		m_chunks(), m_failure(-1)
+	{
+		m_clock.start();
+	}
+
+	void setTarget(CVmFileListCopyTarget& target_)
+	{
+		m_target = &target_;
+	}
+	CVmFileListCopySender& getReply()
+	{
+		return m_reply;
+	}
+	quint64 getBytes() const
+	{
+		return m_bytes;
+	}
+	int getChunks() const
+	{
+		return m_chunks;
+	}
+	void setLatency(int msecs_)
+	{
+		m_latency = msecs_;
+	}
+	void setFailure(int chunks_)
+	{
+		m_failure = chunks_;
+	}
+
+	IOSendJob::Handle sendPackage(const SmartPtr<IOPackage> p)
+	{
+		m_bytes += p->fullPackageSize();
+		m_target->handlePackage(p);
+		m_sent.enqueue(m_clock.elapsed() + m_latency);
+		if (p->header.type == FileCopyFileChunkCmd && ++m_chunks == m_failure)
+			fail();
+
+		return IOSendJob::Handle();
+	}
+
+	IOSendJob::Result waitForSend(const IOSendJob::Handle& h, quint32 tmo)
+	{
+		Q_UNUSED(h);
+		Q_UNUSED(tmo);
+		if (m_sent.isEmpty())
+			return IOSendJob::Success;
+
+		qint64 t = m_sent.dequeue() - m_clock.elapsed();
+		if (0 < t)
+			QThread::msleep(t);
+
+		return IOSendJob::Success;
+	}
+
+	IOSendJob::Response takeResponse(IOSendJob::Handle& h)
+	{
+		Q_UNUSED(h);
+		IOSendJob::Response output;
+		SmartPtr<IOPackage> r = m_reply.take();
+		output.responseResult = r.isValid() ? IOSendJob::Success : IOSendJob::Error;
+		if (r.isValid())
+			output.responsePackages << r;
+
+		return output;
+	}
+
+private:
+	void fail()
+	{
+		CVmEvent e;
+		e.setEventCode(PRL_ERR_FILECOPY_CANT_WRITE);
+		QByteArray b = e.toString().toUtf8();
+		SmartPtr<IOPackage> p = IOPackage::createInstance(FileCopyError, 1);
+		p->fillBuffer(0, IOPackage::RawEncoding, b.constData(), b.size() + 1);
+		handlePackage(p);
+	}
+
+	Reply m_reply;
+	CVmFileListCopyTarget* m_target;
+	quint64 m_bytes;
+	int m_latency;
+	int m_chunks;
+	int m_failure;
+	QElapsedTimer m_clock;
+	QQueue<qint64> m_sent;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// struct Transfer
+
+struct Transfer
+{
+	explicit Transfer(const QString& root_): m_root(root_), m_compressed()
+	{
+		QDir(m_root).mkpath("source");
+		QDir(m_root).mkpath("target");
+	}
+
+	QString getSource() const
+	{
+		return m_root + "/source/disk.hdd";
+	}
+	QString getTarget() const
+	{
+		return m_root + "/target/disk.hdd";
+	}
+	bool isCompressed() const
+	{
+		return m_compressed;
+	}
+
+	PRL_RESULT operator()(bool compress_, quint64& bytes_)
+	{
+		Loopback s;
+		return (*this)(s, compress_, bytes_);
+	}
+	PRL_RESULT operator()(Loopback& s, bool compress_, quint64& bytes_)
+	{
+		CVmEvent e;
+		CVmFileListCopyTarget t(&s.getReply(), "vm", m_root + "/target", &e, 0);
+		s.setTarget(t);
+		QFileInfo f(getSource());
+		CVmFileListCopySource c(&s, "vm", m_root + "/source", f.size(), &e, 0);
+		c.SetCompression(compress_);
+
+		CVmFileListCopySource::objectList_type l;
+		l << qMakePair(f, QString("disk.hdd"));
+		PRL_RESULT output = c.Copy(CVmFileListCopySource::objectList_type(), l);
+		bytes_ = s.getBytes();
+		m_compressed = c.IsCompressed();
+		return output;
+	}
+
+private:
+	QString m_root;
+	bool m_compressed;
+};
+
+QByteArray makePattern(quint64 size_, int seed_)
+{
+	QByteArray output(int(size_), '\0');
+	for (quint64 i = 0; i < size_; ++i)
+		output[(int)i] = char((i * 31 + seed_) % 251);
+
+	return output;
+}
+
+bool write(QFile& file_, qint64 offset_, const QByteArray& data_)
+{
+	return file_.seek(offset_) && file_.write(data_) == data_.size();
+}
+
+QByteArray read(const QString& path_, qint64 offset_, qint64 size_)
+{
+	QFile f(path_);
+	if (!f.open(QIODevice::ReadOnly) || !f.seek(offset_))
+		return QByteArray();
+
+	return f.read(size_);
+}
+
+quint64 getAllocated(const QString& path_)
+{
+	struct stat s;
+	if (0 != ::stat(QFile::encodeName(path_).constData(), &s))
+		return 0;
+
+	return quint64(s.st_blocks) * 512;
+}
+
+} // namespace
+
+void CVmFileListCopyTest::testSparseImage()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	Transfer x(d.path());
+
+	const qint64 z = 10240 * g_1M;
+	QByteArray a = makePattern(g_1M, 1), b = makePattern(64 * 1024, 2),
+		c = makePattern(4096, 3);
+	{
+		QFile f(x.getSource());
+		QVERIFY(f.open(QIODevice::WriteOnly));
+		QVERIFY(f.resize(z));
+		QVERIFY(write(f, 0, a));
+		QVERIFY(write(f, z / 2, b));
+		QVERIFY(write(f, z - c.size(), c));
+	}
+	if (getAllocated(x.getSource()) > 64 * g_1M)
+		QSKIP("The temporary file system has no sparse files");
+
+	quint64 n = 0;
+	QVERIFY(PRL_SUCCEEDED(x(false, n)));
+	// the holes are not on the wire
+	QVERIFY2(n < 4 * g_1M, qPrintable(QString::number(n)));
+
+	QFileInfo t(x.getTarget());
+	QVERIFY(t.exists());
+	QCOMPARE(t.size(), z);
+	// and stay holes on the target
+	QVERIFY2(getAllocated(x.getTarget()) < 16 * g_1M,
+		qPrintable(QString::number(getAllocated(x.getTarget()))));
+	QCOMPARE(read(x.getTarget(), 0, a.size()), a);
+	QCOMPARE(read(x.getTarget(), z / 2, b.size()), b);
+	QCOMPARE(read(x.getTarget(), z - c.size(), c.size()), c);
+	QCOMPARE(read(x.getTarget(), g_1M, 4096), QByteArray(4096, '\0'));
+}
+
+void CVmFileListCopyTest::testCompressionAgreed()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	Transfer x(d.path());
+
+	QByteArray a = makePattern(4 * g_1M, 5);
+	{
+		QFile f(x.getSource());
+		QVERIFY(f.open(QIODevice::WriteOnly));
+		QVERIFY(write(f, 0, a));
+	}
+	quint64 n = 0;
+	QVERIFY(PRL_SUCCEEDED(x(true, n)));
+	QVERIFY(x.isCompressed());
+	QVERIFY2(n < quint64(a.size()) / 4, qPrintable(QString::number(n)));
+	QCOMPARE(read(x.getTarget(), 0, a.size() + 1), a);
+}
+
+void CVmFileListCopyTest::testCompressionNotAsked()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	Transfer x(d.path());
+
+	QByteArray a = makePattern(4 * g_1M, 7);
+	{
+		QFile f(x.getSource());
+		QVERIFY(f.open(QIODevice::WriteOnly));
+		QVERIFY(write(f, 0, a));
+	}
+	quint64 n = 0;
+	QVERIFY(PRL_SUCCEEDED(x(false, n)));
+	QVERIFY(!x.isCompressed());
+	QVERIFY(n >= quint64(a.size()));
+	QCOMPARE(read(x.getTarget(), 0, a.size() + 1), a);
+}
+
+void CVmFileListCopyTest::testTargetErrorStopsWindow()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	Transfer x(d.path());
+
+	QByteArray a = makePattern(32 * g_1M, 9);
+	{
+		QFile f(x.getSource());
+		QVERIFY(f.open(QIODevice::WriteOnly));
+		QVERIFY(write(f, 0, a));
+	}
+	Loopback s;
+	s.setFailure(3);
+	quint64 n = 0;
+	QCOMPARE(x(s, false, n), PRL_RESULT(PRL_ERR_FILECOPY_CANT_WRITE));
+	// no chunk follows the failed one although the window is not full
+	QCOMPARE(s.getChunks(), 3);
+}
+
+void CVmFileListCopyTest::benchWindowOverLatency()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	Transfer x(d.path());
+
+	QByteArray a = makePattern(64 * g_1M, 11);
+	{
+		QFile f(x.getSource());
+		QVERIFY(f.open(QIODevice::WriteOnly));
+		QVERIFY(write(f, 0, a));
+	}
+	// 64 chunks over a 10 ms link: 640 ms and more one chunk at a time
+	Loopback s;
+	s.setLatency(10);
+	quint64 n = 0;
+	PRL_RESULT r = PRL_ERR_SUCCESS;
+	QBENCHMARK_ONCE
+	{
+		r = x(s, false, n);
+	}
+	QVERIFY(PRL_SUCCEEDED(r));
+	QCOMPARE(s.getChunks(), 64);
+	QCOMPARE(read(x.getTarget(), 0, a.size() + 1), a);
+}
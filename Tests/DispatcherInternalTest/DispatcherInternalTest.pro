@@ -1,6 +1,6 @@
 QT = xml network core testlib
 
-INCLUDEPATH += /usr/share /usr/include/prlsdk
+INCLUDEPATH += /usr/share /usr/include/prlsdk $$SRC_LEVEL/Dispatcher/Dispatcher
 DEFINES += BOOST_MPL_CFG_NO_PREPROCESSED_HEADERS BOOST_MPL_LIMIT_VECTOR_SIZE=40 BOOST_SPIRIT_THREADSAFE
 DEFINES += BOOST_THREAD_PROVIDES_FUTURE BOOST_THREAD_PROVIDES_FUTURE_CONTINUATION
 include(DispatcherInternalTest.deps)
@@ -14,6 +14,13 @@ QMAKE_EXTRA_TARGETS += first copydata
 HEADERS += \
 	$$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspStatisticsGuard.h\
 	$$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspSystemInfo.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspVmStateCoalescer.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspVmUptime.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspCtStateReactor.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspExecutor.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspUserHelper_p.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/Tasks/Task_VmDataStatistic_p.h\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/Tasks/Task_GetBackupTree_p.h\
 	$$SRC_LEVEL/Tests/DispatcherTestsUtils.h\
 	$$SRC_LEVEL/Tests/AclTestsUtils.h\
 	CDspStatisticsGuardTest.h\
@@ -23,11 +30,22 @@ HEADERS += \
 	CXmlModelHelperTest.h \
 	CFeaturesMatrixTest.h \
 	CTransponsterNwfilterTest.h \
-	CQDomElementHelperTest.h
+	CQDomElementHelperTest.h \
+	CDspVmStateCoalescerTest.h \
+	CDspVmUptimeTest.h \
+	CDspCtStateReactorTest.h \
+	Task_VmDataStatisticTest.h \
+	Task_GetBackupTreeTest.h \
+	CDspExecutorTest.h \
+	CDspUserHelperTest.h
 
 SOURCES += \
 	Main.cpp\
 	$$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspStatisticsGuard.cpp\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspVmStateCoalescer.cpp\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspVmUptime.cpp\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspCtStateReactor.cpp\
+	$$SRC_LEVEL/Dispatcher/Dispatcher/CDspExecutor.cpp\
 	CDspStatisticsGuardTest.cpp\
 	PrlCommonUtilsTest.cpp \
 	CGuestOsesHelperTest.cpp \
@@ -35,11 +53,24 @@ SOURCES += \
 	CXmlModelHelperTest.cpp \
 	CFeaturesMatrixTest.cpp \
 	CTransponsterNwfilterTest.cpp \
-	CQDomElementHelperTest.cpp
+	CQDomElementHelperTest.cpp \
+	CDspVmStateCoalescerTest.cpp \
+	CDspVmUptimeTest.cpp \
+	CDspCtStateReactorTest.cpp \
+	Task_VmDataStatisticTest.cpp \
+	Task_GetBackupTreeTest.cpp \
+	CDspExecutorTest.cpp \
+	CDspUserHelperTest.cpp
 
 
 win32: SOURCES	+= $$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspSystemInfo_win.cpp
 linux-*: SOURCES+= $$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspSystemInfo_lin.cpp
+linux-*: HEADERS+= CNetlinkBatchTest.h
+linux-*: SOURCES+= CNetlinkBatchTest.cpp
+linux-*: HEADERS+= CVmFileListCopyTest.h
+linux-*: SOURCES+= CVmFileListCopyTest.cpp
+linux-*: HEADERS+= $$SRC_LEVEL/Dispatcher/Dispatcher/CDspTaskTrace_p.h CDspTaskTraceTest.h
+linux-*: SOURCES+= $$SRC_LEVEL/Dispatcher/Dispatcher/CDspTaskTrace.cpp CDspTaskTraceTest.cpp
 macx:	SOURCES	+= $$SRC_LEVEL/Dispatcher/Dispatcher/Stat/CDspSystemInfo_mac.cpp
 
 
@@ -57,7 +88,7 @@ linux-g++* {
 
 LIBS += -L$$SRC_LEVEL/z-Build/Release -lprlcommon -lTransponster \ 
 		-lPrlNetworking -lCpuFeatures -lStatesStore -lprlTestsUtils \
-		-lvirtuozzo
+		-lvirtuozzo -lboost_chrono
 
 boost-with-mt {
 	LIBS += -lboost_filesystem-mt -lboost_system-mt
@@ -50,6 +50,18 @@
 #include "CProblemReportUtilsTest.h"
 #include "CXmlModelHelperTest.h"
 #include "CFeaturesMatrixTest.h"
+#include "CDspVmStateCoalescerTest.h"
+#include "CDspVmUptimeTest.h"
+#include "CDspCtStateReactorTest.h"
+#include "Task_VmDataStatisticTest.h"
+#include "Task_GetBackupTreeTest.h"
+#include "CDspExecutorTest.h"
+#include "CDspUserHelperTest.h"
+#ifdef _LIN_
+#include "CNetlinkBatchTest.h"
+#include "CVmFileListCopyTest.h"
+#include "CDspTaskTraceTest.h"
+#endif
 
 int main(int argc, char *argv[])
 {
@@ -67,6 +79,18 @@ int main(int argc, char *argv[])
 	EXECUTE_TESTS_SUITE( CXmlModelHelperTest )
 	EXECUTE_TESTS_SUITE( CFeaturesMatrixTest )
 	EXECUTE_TESTS_SUITE( CTransponsterNwfilterTest )
+	EXECUTE_TESTS_SUITE( CDspVmStateCoalescerTest )
+	EXECUTE_TESTS_SUITE( CDspVmUptimeTest )
+	EXECUTE_TESTS_SUITE( CDspCtStateReactorTest )
+	EXECUTE_TESTS_SUITE( Task_VmDataStatisticTest )
+	EXECUTE_TESTS_SUITE( Task_GetBackupTreeTest )
+	EXECUTE_TESTS_SUITE( CDspExecutorTest )
+	EXECUTE_TESTS_SUITE( CDspUserHelperTest )
+#ifdef _LIN_
+	EXECUTE_TESTS_SUITE( CNetlinkBatchTest )
+	EXECUTE_TESTS_SUITE( CVmFileListCopyTest )
+	EXECUTE_TESTS_SUITE( CDspTaskTraceTest )
+#endif
 
 	return nRet;
 }
@@ -0,0 +1,182 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file Task_GetBackupTreeTest.cpp
+///
+/// Tests suite for the stamps of the backup sequence folders.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QTemporaryDir>
+#include "Task_GetBackupTreeTest.h"
+#include "Dispatcher/Dispatcher/Tasks/Task_GetBackupTree_p.h"
+
+using namespace Backup::Tree;
+
+namespace
+{
+const char g_metadata[] = ".metadata";
+
+enum
+{
+	// beyond the granularity of the file times
+	TICK = 50,
+	// a synthetic backup root
+	SEQUENCES = 1000,
+	ITEMS = 8
+};
+
+bool write(const QString& path_, const QByteArray& data_)
+{
+	QFile f(path_);
+	return f.open(QIODevice::WriteOnly) && f.write(data_) == data_.size() && f.flush();
+}
+
+bool addItem(const QDir& lair_, const QString& name_)
+{
+	return lair_.mkpath(name_) &&
+		write(QDir(lair_.filePath(name_)).filePath(g_metadata), QByteArray(512, 'm'));
+}
+
+bool addSequence(const QDir& lair_)
+{
+	if (!addItem(lair_, "base"))
+		return false;
+
+	for (int i = 2; i <= ITEMS; ++i)
+	{
+		if (!addItem(lair_, QString::number(i)))
+			return false;
+	}
+	return true;
+}
+
+QList<QDir> fill(const QString& root_)
+{
+	QList<QDir> output;
+	for (int i = 0; i < SEQUENCES; ++i)
+	{
+		QDir d(QDir(root_).filePath(QString::number(i)));
+		if (!addSequence(d))
+			return QList<QDir>();
+
+		output << d;
+	}
+	return output;
+}
+
+} // namespace
+
+void Task_GetBackupTreeTest::testRewriteInPlace()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QDir q(d.path());
+	QVERIFY(addSequence(q));
+
+	Stamp s(g_metadata);
+	Stamp::value_type a = s(q, Stamp::value_type());
+	QCOMPARE(a.size(), ITEMS + 1);
+	QTest::qSleep(TICK);
+	// the head item is rewritten without touching the folder
+	QVERIFY(write(QDir(q.filePath("base")).filePath(g_metadata), QByteArray(1024, 'n')));
+	Stamp::value_type b = s(q, a);
+	QCOMPARE(b.value(q.absolutePath()), a.value(q.absolutePath()));
+	QVERIFY(a != b);
+	QCOMPARE(s(q, b), b);
+}
+
+void Task_GetBackupTreeTest::testItemAdded()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QDir q(d.path());
+	QVERIFY(addSequence(q));
+
+	Stamp s(g_metadata);
+	Stamp::value_type a = s(q, Stamp::value_type());
+	QTest::qSleep(TICK);
+	// the metadata of a new item is written after its folder
+	QString n(QString::number(ITEMS + 1));
+	QVERIFY(q.mkpath(n));
+	Stamp::value_type b = s(q, a);
+	QVERIFY(a != b);
+	QCOMPARE(b.size(), ITEMS + 2);
+	QTest::qSleep(TICK);
+	QVERIFY(write(QDir(q.filePath(n)).filePath(g_metadata), QByteArray(512, 'm')));
+	Stamp::value_type c = s(q, b);
+	QCOMPARE(c.value(q.absolutePath()), b.value(q.absolutePath()));
+	QVERIFY(b != c);
+	// the removed item changes the folder
+	QTest::qSleep(TICK);
+	QVERIFY(QDir(q.filePath(n)).removeRecursively());
+	Stamp::value_type e = s(q, c);
+	QCOMPARE(e.size(), a.size());
+	QVERIFY(!e.contains(QDir(q.filePath(n)).filePath(g_metadata)));
+}
+
+void Task_GetBackupTreeTest::benchFirstStamp()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QList<QDir> x = fill(d.path());
+	QCOMPARE(x.size(), int(SEQUENCES));
+
+	// every sequence folder is listed
+	Stamp s(g_metadata);
+	int n = 0;
+	QBENCHMARK
+	{
+		n = 0;
+		foreach (const QDir& q, x)
+			n += s(q, Stamp::value_type()).size();
+	}
+	QCOMPARE(n, SEQUENCES * (ITEMS + 1));
+}
+
+void Task_GetBackupTreeTest::benchNextStamp()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QList<QDir> x = fill(d.path());
+	QCOMPARE(x.size(), int(SEQUENCES));
+
+	Stamp s(g_metadata);
+	QList<Stamp::value_type> p;
+	foreach (const QDir& q, x)
+		p << s(q, Stamp::value_type());
+
+	// the unchanged folders are not listed again
+	int n = 0;
+	QBENCHMARK
+	{
+		n = 0;
+		for (int i = 0; i < x.size(); ++i)
+		{
+			Stamp::value_type a = s(x.at(i), p.at(i));
+			if (a == p.at(i))
+				++n;
+		}
+	}
+	QCOMPARE(n, int(SEQUENCES));
+}
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+///
+/// @file Task_VmDataStatisticTest.cpp
+///
+/// Tests suite for the VM disk space usage walk and its cache.
+///
+/// Copyright (c) 2026 Virtuozzo International GmbH, All rights reserved.
+///
+/// This file is part of Virtuozzo Core. Virtuozzo Core is free
+/// software; you can redistribute it and/or modify it under the terms
+/// of the GNU General Public License as published by the Free Software
+/// Foundation; either version 2 of the License, or (at your option) any
+/// later version.
+/// 
+/// This program is distributed in the hope that it will be useful,
+/// but WITHOUT ANY WARRANTY; without even the implied warranty of
+/// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+/// GNU General Public License for more details.
+/// 
+/// You should have received a copy of the GNU General Public License
+/// along with this program; if not, write to the Free Software
+/// Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+/// 02110-1301, USA.
+///
+/// Our contact details: Virtuozzo International GmbH, Vordergasse 59, 8200
+/// Schaffhausen, Switzerland.
+///
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QTemporaryDir>
+#include "Task_VmDataStatisticTest.h"
+#include "Dispatcher/Dispatcher/Tasks/Task_VmDataStatistic_p.h"
+
+using namespace Statistic;
+
+namespace
+{
+const CVmIdent g_vm = MakeVmIdent("{0b8e1c35-4d0e-4a6f-9a55-7b1d3a3f0c11}", "");
+
+bool write(const QString& path_, const QByteArray& data_, QIODevice::OpenMode mode_)
+{
+	QFile f(path_);
+	return f.open(mode_) && f.write(data_) == data_.size() && f.flush();
+}
+
+quint64 getAllocated(const QString& path_)
+{
+	Node n;
+	return n.load(path_) ? n.m_allocated : 0;
+}
+
+} // namespace
+
+void Task_VmDataStatisticTest::testImageCountedOnce()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QString h = d.path(), i = h + "/harddisk.hdd";
+	QVERIFY(QDir(h).mkpath(i));
+	QVERIFY(write(i + "/harddisk.hdd.0.hds", QByteArray(1024 * 1024, 'x'),
+		QIODevice::WriteOnly));
+	QVERIFY(write(h + "/config.pvs", QByteArray(4096, 'c'), QIODevice::WriteOnly));
+
+	Walker w;
+	// two entries of one image and a nested one
+	w.track(i, Usage::DATA);
+	w.track(i, Usage::DATA);
+	w.track(i + "/harddisk.hdd.0.hds", Usage::DATA);
+	Usage u;
+	QCOMPARE(w(h, u), PRL_RESULT(PRL_ERR_SUCCESS));
+	// walking the image again adds nothing
+	QCOMPARE(w(i, u), PRL_RESULT(PRL_ERR_SUCCESS));
+	QCOMPARE(u.m_data, getAllocated(i + "/harddisk.hdd.0.hds"));
+	QVERIFY(u.m_full >= u.m_data + u.m_snapshots);
+}
+
+void Task_VmDataStatisticTest::testCountedFilesAreSigned()
+{
+	QTemporaryDir d;
+	QVERIFY(d.isValid());
+	QString h = d.path();
+	QStringList x;
+	x << h + "/parallels.log" << h + "/vm.sav" << h + "/vm.mem" << h + "/NVRAM.dat";
+	foreach (const QString& f, x)
+		QVERIFY(write(f, QByteArray(4096, 'a'), QIODevice::WriteOnly));
+
+	foreach (const QString& f, x)
+	{
+		Walker w;
+		Usage u;
+		QCOMPARE(w(h, u), PRL_RESULT(PRL_ERR_SUCCESS));
+		Cache c;
+		c.add(g_vm, w.getSignature(), u);
+		Usage v;
+		QVERIFY(c.find(g_vm, v));
+		QCOMPARE(v.m_full, u.m_full);
+		// the directory does not change when a file grows
+		QVERIFY2(write(f, QByteArray(256 * 1024, 'b'), QIODevice::Append),
+			qPrintable(f));
+		QVERIFY2(!c.find(g_vm, v), qPrintable(f));
+	}
+}